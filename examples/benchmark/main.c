@@ -0,0 +1,573 @@
+/*
+ * Copyright (c) The ThingSet Project Contributors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Micro-benchmarks for the ThingSet library running on the host.
+ *
+ * The absolute numbers are not representative for microcontrollers, but the scaling with the
+ * number of data objects is.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <thingset.h>
+
+/* for the internal text formatting functions */
+#include "thingset_priv.h"
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+#endif
+
+#define MAX_OBJECTS     3000
+#define ITEMS_PER_GROUP 15
+
+/* every SUBSET_INTERVAL-th item is part of the subset used for exports */
+#define SUBSET_EXPORT   (1U << 0)
+#define SUBSET_INTERVAL 50
+
+/* all items are part of this subset */
+#define SUBSET_ALL (1U << 1)
+
+static struct ts_data_object objects[MAX_OBJECTS];
+static char names[MAX_OBJECTS][8];
+static float values[MAX_OBJECTS];
+static uint16_t index_buf[TS_INDEX_BUF_LEN(MAX_OBJECTS)];
+
+static const size_t db_sizes[] = { 100, 500, 1000, 1500, 3000 };
+
+static double now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*
+ * Generate a database with num objects. Each group (parent root) is followed by
+ * ITEMS_PER_GROUP float items, similar to real devices.
+ */
+static void generate_objects(size_t num)
+{
+    ts_object_id_t group_id = 0;
+
+    for (size_t i = 0; i < num; i++) {
+        if (i % (ITEMS_PER_GROUP + 1) == 0) {
+            group_id = 0x100 + i / (ITEMS_PER_GROUP + 1);
+            snprintf(names[i], sizeof(names[i]), "G%u", (unsigned int)group_id);
+            struct ts_data_object group = TS_GROUP(group_id, names[i], NULL, TS_ID_ROOT);
+            memcpy(&objects[i], &group, sizeof(group));
+        }
+        else {
+            snprintf(names[i], sizeof(names[i]), "rItem%u", (unsigned int)(i % 100));
+            uint16_t subsets = SUBSET_ALL | ((i % SUBSET_INTERVAL == 1) ? SUBSET_EXPORT : 0);
+            struct ts_data_object item = TS_ITEM_FLOAT(0x1000 + i, names[i], &values[i], 2,
+                                                       group_id, TS_ANY_RW, subsets);
+            memcpy(&objects[i], &item, sizeof(item));
+        }
+    }
+}
+
+/* IDs are looked up in pseudo-random order to avoid a bias for objects at the start */
+static double bench_id_lookup(struct ts_context *ts, size_t num)
+{
+    const unsigned int lookups = 200000;
+    uint32_t rnd = 1;
+    size_t found = 0;
+
+    double start = now_ns();
+    for (unsigned int i = 0; i < lookups; i++) {
+        rnd = rnd * 1103515245U + 12345U;
+        found += ts_get_object_by_id(ts, objects[(rnd >> 8) % num].id) != NULL;
+    }
+    double elapsed = now_ns() - start;
+
+    if (found != lookups) {
+        printf("Error: only %zu of %u objects found\n", found, lookups);
+    }
+    return elapsed / lookups;
+}
+
+static void bench_object_lookup(void)
+{
+    struct ts_context ts;
+
+    printf("\nts_get_object_by_id (%s index)\n",
+           CONFIG_THINGSET_ID_INDEX_HASH ? "hash" : "sorted");
+    printf("%8s %14s %14s\n", "objects", "linear [ns]", "indexed [ns]");
+
+    for (size_t i = 0; i < ARRAY_SIZE(db_sizes); i++) {
+        size_t num = db_sizes[i];
+        generate_objects(num);
+
+        ts_init(&ts, objects, num);
+        double linear = bench_id_lookup(&ts, num);
+
+        ts_init_indexed(&ts, objects, num, index_buf, ARRAY_SIZE(index_buf));
+        double indexed = bench_id_lookup(&ts, num);
+
+        printf("%8zu %14.1f %14.1f\n", num, linear, indexed);
+    }
+}
+
+static double bench_path_lookup(struct ts_context *ts, size_t num)
+{
+    const unsigned int lookups = 200000;
+    uint32_t rnd = 1;
+    size_t found = 0;
+    char path[20];
+
+    double start = now_ns();
+    for (unsigned int i = 0; i < lookups; i++) {
+        rnd = rnd * 1103515245U + 12345U;
+        const struct ts_data_object *obj = &objects[(rnd >> 8) % num];
+        int len;
+        if (obj->parent == TS_ID_ROOT) {
+            len = snprintf(path, sizeof(path), "%s", obj->name);
+        }
+        else {
+            len = snprintf(path, sizeof(path), "G%u/%s", obj->parent, obj->name);
+        }
+        found += ts_get_object_by_path(ts, path, len) == obj;
+    }
+    double elapsed = now_ns() - start;
+
+    if (found != lookups) {
+        printf("Error: only %zu of %u paths found\n", found, lookups);
+    }
+    return elapsed / lookups;
+}
+
+static void bench_path_resolution(void)
+{
+    struct ts_context ts;
+
+    printf("\nts_get_object_by_path\n");
+    printf("%8s %14s %14s\n", "objects", "linear [ns]", "indexed [ns]");
+
+    for (size_t i = 0; i < ARRAY_SIZE(db_sizes); i++) {
+        size_t num = db_sizes[i];
+        generate_objects(num);
+
+        ts_init(&ts, objects, num);
+        double linear = bench_path_lookup(&ts, num);
+
+        ts_init_indexed(&ts, objects, num, index_buf, ARRAY_SIZE(index_buf));
+        double indexed = bench_path_lookup(&ts, num);
+
+        printf("%8zu %14.1f %14.1f\n", num, linear, indexed);
+    }
+}
+
+static double bench_get_requests(struct ts_context *ts, size_t num)
+{
+    const unsigned int requests = 20000;
+    const size_t num_groups = (num + ITEMS_PER_GROUP) / (ITEMS_PER_GROUP + 1);
+    uint8_t req[4] = { TS_GET, 0x19 }; // CBOR uint16 follows
+    uint8_t resp[300];
+    uint32_t rnd = 1;
+    size_t valid = 0;
+
+    double start = now_ns();
+    for (unsigned int i = 0; i < requests; i++) {
+        rnd = rnd * 1103515245U + 12345U;
+        ts_object_id_t id = 0x100 + (rnd >> 8) % num_groups;
+        req[2] = id >> 8;
+        req[3] = id & 0xFF;
+        int len = ts_process(ts, req, sizeof(req), resp, sizeof(resp));
+        valid += len > 0 && resp[0] == TS_STATUS_CONTENT;
+    }
+    double elapsed = now_ns() - start;
+
+    if (valid != requests) {
+        printf("Error: only %zu of %u requests successful\n", valid, requests);
+    }
+    return elapsed / requests;
+}
+
+/* binary GET requests for all values of a group */
+static void bench_group_get(void)
+{
+    static const size_t sizes[] = { 100, 500, 1000, 2000, 3000 };
+    struct ts_context ts;
+
+    printf("\nGET group (binary mode)\n");
+    printf("%8s %14s %14s\n", "objects", "linear [ns]", "indexed [ns]");
+
+    for (size_t i = 0; i < ARRAY_SIZE(sizes); i++) {
+        size_t num = sizes[i];
+        generate_objects(num);
+
+        ts_init(&ts, objects, num);
+        double linear = bench_get_requests(&ts, num);
+
+        ts_init_indexed(&ts, objects, num, index_buf, ARRAY_SIZE(index_buf));
+        double indexed = bench_get_requests(&ts, num);
+
+        printf("%8zu %14.1f %14.1f\n", num, linear, indexed);
+    }
+}
+
+static double bench_export_runs(struct ts_context *ts)
+{
+    const unsigned int runs = 20000;
+    uint8_t buf[1000];
+    size_t valid = 0;
+
+    double start = now_ns();
+    for (unsigned int i = 0; i < runs; i++) {
+        valid += ts_bin_export(ts, buf, sizeof(buf), SUBSET_EXPORT) > 0;
+    }
+    double elapsed = now_ns() - start;
+
+    if (valid != runs) {
+        printf("Error: only %zu of %u exports successful\n", valid, runs);
+    }
+    return elapsed / runs;
+}
+
+/* binary export of a subset with a constant share of the objects */
+static void bench_export(void)
+{
+    struct ts_context ts;
+
+    printf("\nts_bin_export (every %d. object in subset)\n", SUBSET_INTERVAL);
+    printf("%8s %14s %14s\n", "objects", "linear [ns]", "indexed [ns]");
+
+    for (size_t i = 0; i < ARRAY_SIZE(db_sizes); i++) {
+        size_t num = db_sizes[i];
+        generate_objects(num);
+
+        ts_init(&ts, objects, num);
+        double linear = bench_export_runs(&ts);
+
+        ts_init_indexed(&ts, objects, num, index_buf, ARRAY_SIZE(index_buf));
+        double indexed = bench_export_runs(&ts);
+
+        printf("%8zu %14.1f %14.1f\n", num, linear, indexed);
+    }
+}
+
+/* throughput of the binary export of all items in MB/s */
+static double bench_throughput_runs(struct ts_context *ts)
+{
+    static uint8_t buf[MAX_OBJECTS * 8];
+    const unsigned int runs = 500;
+    size_t bytes = 0;
+
+    double start = now_ns();
+    for (unsigned int i = 0; i < runs; i++) {
+        bytes += ts_bin_export(ts, buf, sizeof(buf), SUBSET_ALL);
+    }
+    double elapsed = now_ns() - start;
+
+    return bytes / elapsed * 1e9 / 1e6;
+}
+
+static void bench_export_throughput(void)
+{
+    struct ts_context ts;
+
+    printf("\nts_bin_export throughput (all items)\n");
+    printf("%8s %14s %14s\n", "objects", "linear [MB/s]", "indexed [MB/s]");
+
+    for (size_t i = 0; i < ARRAY_SIZE(db_sizes); i++) {
+        size_t num = db_sizes[i];
+        generate_objects(num);
+
+        ts_init(&ts, objects, num);
+        double linear = bench_throughput_runs(&ts);
+
+        ts_init_indexed(&ts, objects, num, index_buf, ARRAY_SIZE(index_buf));
+        double indexed = bench_throughput_runs(&ts);
+
+        printf("%8zu %14.1f %14.1f\n", num, linear, indexed);
+    }
+}
+
+/* bits of an extended CAN frame without bit stuffing, incl. interframe space */
+#define CAN_FRAME_BITS(len) (67 + 8 * (len))
+#define CAN_BITRATE         125000
+
+struct can_pub_result
+{
+    unsigned int frames;
+    unsigned int bits;
+};
+
+static struct can_pub_result can_pub_single(struct ts_context *ts, uint16_t subset)
+{
+    struct can_pub_result res = { 0 };
+    int start_pos = 0;
+    uint32_t msg_id;
+    uint8_t data[8];
+    int len;
+
+    while ((len = ts_bin_pub_can(ts, &start_pos, subset, 1, &msg_id, data)) > 0) {
+        res.frames++;
+        res.bits += CAN_FRAME_BITS(len);
+    }
+    return res;
+}
+
+static struct can_pub_result can_pub_packed(struct ts_context *ts, uint16_t subset,
+                                            uint8_t frame_size)
+{
+    static struct ts_can_pub_stream stream;
+    struct can_pub_result res = { 0 };
+    uint32_t msg_id;
+    uint8_t data[64];
+    int len;
+
+    ts_bin_pub_can_packed_begin(ts, &stream, subset, 1, frame_size);
+    while ((len = ts_bin_pub_can_packed(ts, &stream, &msg_id, data)) > 0) {
+        res.frames++;
+        res.bits += CAN_FRAME_BITS(len);
+    }
+    return res;
+}
+
+/* frames needed to publish a subset once and resulting rate on a 125 kbit/s bus */
+static void bench_can_pub(void)
+{
+    static const struct
+    {
+        const char *name;
+        uint16_t subset;
+    } subsets[] = {
+        { "export", SUBSET_EXPORT },
+        { "all", SUBSET_ALL },
+    };
+    const size_t num = 1000;
+    struct ts_context ts;
+
+    generate_objects(num);
+    ts_init_indexed(&ts, objects, num, index_buf, ARRAY_SIZE(index_buf));
+
+    printf("\nCAN publication of %zu objects (per message, classic CAN at %d kbit/s)\n", num,
+           CAN_BITRATE / 1000);
+    printf("%8s %10s %10s %10s %12s\n", "subset", "mode", "frames", "bits", "messages/s");
+
+    for (size_t i = 0; i < ARRAY_SIZE(subsets); i++) {
+        struct can_pub_result single = can_pub_single(&ts, subsets[i].subset);
+        struct can_pub_result packed = can_pub_packed(&ts, subsets[i].subset, 8);
+        struct can_pub_result packed_fd = can_pub_packed(&ts, subsets[i].subset, 64);
+
+        printf("%8s %10s %10u %10u %12.1f\n", subsets[i].name, "single", single.frames,
+               single.bits, (double)CAN_BITRATE / single.bits);
+        printf("%8s %10s %10u %10u %12.1f\n", subsets[i].name, "packed", packed.frames,
+               packed.bits, (double)CAN_BITRATE / packed.bits);
+        printf("%8s %10s %10u %10s %12s\n", subsets[i].name, "packed FD", packed_fd.frames, "-",
+               "-");
+    }
+}
+
+/* formatting of numbers for JSON in values/s */
+#define FORMAT_VALUES 1000
+
+static double format_runs(int type, int digits, bool use_snprintf)
+{
+    static float floats[FORMAT_VALUES];
+    static int32_t ints[FORMAT_VALUES];
+    const unsigned int runs = 1000;
+    char buf[32];
+    size_t len = 0;
+
+    for (int i = 0; i < FORMAT_VALUES; i++) {
+        ints[i] = (i * 7919) % 100000 - 50000;
+        floats[i] = ints[i] / 97.0F;
+    }
+
+    double start = now_ns();
+    for (unsigned int r = 0; r < runs; r++) {
+        for (int i = 0; i < FORMAT_VALUES; i++) {
+            if (type == TS_T_INT32) {
+                len += use_snprintf ? snprintf(buf, sizeof(buf), "%" PRIi32, ints[i])
+                                    : ts_txt_format_int(buf, sizeof(buf), ints[i]);
+            }
+            else {
+                len += use_snprintf ? snprintf(buf, sizeof(buf), "%.*f", digits, floats[i])
+                                    : ts_txt_format_float(buf, sizeof(buf), floats[i], digits);
+            }
+        }
+    }
+    double elapsed = now_ns() - start;
+
+    if (len == 0) {
+        printf("Error: no values formatted\n");
+    }
+
+    return (double)runs * FORMAT_VALUES / elapsed * 1e9;
+}
+
+static void bench_txt_format(void)
+{
+    const struct
+    {
+        const char *name;
+        int type;
+        int digits;
+    } formats[] = {
+        { "int32", TS_T_INT32, 0 },
+        { "float .0", TS_T_FLOAT32, 0 },
+        { "float .2", TS_T_FLOAT32, 2 },
+        { "float .6", TS_T_FLOAT32, 6 },
+    };
+
+    printf("\nJSON number formatting\n");
+    printf("%8s %14s %14s\n", "type", "snprintf [M/s]", "ts_txt [M/s]");
+
+    for (size_t i = 0; i < ARRAY_SIZE(formats); i++) {
+        double libc = format_runs(formats[i].type, formats[i].digits, true);
+        double fast = format_runs(formats[i].type, formats[i].digits, false);
+        printf("%8s %14.1f %14.1f\n", formats[i].name, libc / 1e6, fast / 1e6);
+    }
+}
+
+/* simulated link for pipelined requests, e.g. via LTE (one-way delay and bitrate) */
+#define LINK_DELAY_S  0.15
+#define LINK_BITRATE  100000
+#define LINK_TIME(len) ((len) * 8.0 / LINK_BITRATE)
+
+#define PIPELINE_REQUESTS  256
+#define PIPELINE_MAX_DEPTH 32
+
+/*
+ * Sends GET requests for single items through a ts_pipeline with the given depth and processes
+ * them with ts_process in a loopback. The link is only simulated, so the result is the request
+ * rate in requests/s as it would be seen by the client.
+ */
+static double pipeline_run(struct ts_context *ts, size_t depth, size_t num)
+{
+    static uint8_t responses[PIPELINE_MAX_DEPTH][32];
+    static int resp_lens[PIPELINE_MAX_DEPTH];
+    static double recv_time[PIPELINE_REQUESTS];
+    struct ts_pipeline_slot slots[PIPELINE_MAX_DEPTH];
+    struct ts_pipeline pl;
+    double uplink_free = 0;
+    double device_free = 0;
+    double downlink_free = 0;
+    size_t matched = 0;
+
+    ts_pipeline_init(&pl, slots, depth);
+
+    for (size_t i = 0; i < PIPELINE_REQUESTS + depth; i++) {
+        if (i >= depth) {
+            // slot becomes free once the oldest response was received
+            const uint8_t *payload;
+            size_t payload_len;
+            size_t slot = (i - depth) % depth;
+            if (ts_pipeline_response(&pl, responses[slot], resp_lens[slot], &payload,
+                                     &payload_len, NULL)
+                == 0)
+            {
+                matched++;
+            }
+        }
+        if (i >= PIPELINE_REQUESTS) {
+            continue;
+        }
+
+        uint8_t req[8] = { TS_GET };
+        uint8_t framed[16];
+        size_t item = 1 + (i * 7) % (num - 1);
+        if (item % (ITEMS_PER_GROUP + 1) == 0) {
+            item++;
+        }
+        int req_len = 1 + cbor_serialize_uint(&req[1], objects[item].id, sizeof(req) - 1);
+        int len = ts_pipeline_request(&pl, req, req_len, framed, sizeof(framed), NULL, NULL);
+
+        double start = now_ns();
+        resp_lens[i % depth] =
+            ts_process(ts, framed, len, responses[i % depth], sizeof(responses[0]));
+        double processing = (now_ns() - start) / 1e9;
+
+        double send = (i >= depth) ? recv_time[i - depth] : 0;
+        if (send < uplink_free) {
+            send = uplink_free;
+        }
+        uplink_free = send + LINK_TIME(len);
+
+        double begin = uplink_free + LINK_DELAY_S;
+        if (begin < device_free) {
+            begin = device_free;
+        }
+        device_free = begin + processing;
+
+        double reply = (device_free > downlink_free) ? device_free : downlink_free;
+        downlink_free = reply + LINK_TIME(resp_lens[i % depth]);
+        recv_time[i] = downlink_free + LINK_DELAY_S;
+    }
+
+    if (matched != PIPELINE_REQUESTS) {
+        printf("Error: only %zu of %d responses matched\n", matched, PIPELINE_REQUESTS);
+    }
+
+    return PIPELINE_REQUESTS / recv_time[PIPELINE_REQUESTS - 1];
+}
+
+static void bench_pipeline(void)
+{
+    static const size_t depths[] = { 1, 2, 4, 8, 16, 32 };
+    const size_t num = 1000;
+    struct ts_context ts;
+
+    generate_objects(num);
+    ts_init_indexed(&ts, objects, num, index_buf, ARRAY_SIZE(index_buf));
+
+    printf("\nPipelined binary GET requests (simulated link: %.0f ms RTT, %d kbit/s)\n",
+           LINK_DELAY_S * 2 * 1000, LINK_BITRATE / 1000);
+    printf("%8s %14s\n", "depth", "requests/s");
+
+    for (size_t i = 0; i < ARRAY_SIZE(depths); i++) {
+        printf("%8zu %14.1f\n", depths[i], pipeline_run(&ts, depths[i], num));
+    }
+}
+
+static void bench_init(void)
+{
+    struct ts_context ts;
+    const int runs = 20;
+
+    printf("\nts_init (including validation of data objects)\n");
+    printf("%8s %14s %14s\n", "objects", "plain [us]", "indexed [us]");
+
+    for (size_t i = 0; i < ARRAY_SIZE(db_sizes); i++) {
+        size_t num = db_sizes[i];
+        generate_objects(num);
+
+        double start = now_ns();
+        for (int j = 0; j < runs; j++) {
+            ts_init(&ts, objects, num);
+        }
+        double plain = (now_ns() - start) / runs / 1000;
+
+        start = now_ns();
+        for (int j = 0; j < runs; j++) {
+            ts_init_indexed(&ts, objects, num, index_buf, ARRAY_SIZE(index_buf));
+        }
+        double indexed = (now_ns() - start) / runs / 1000;
+
+        printf("%8zu %14.1f %14.1f\n", num, plain, indexed);
+    }
+}
+
+int main(void)
+{
+    bench_init();
+    bench_object_lookup();
+    bench_path_resolution();
+    bench_group_get();
+    bench_export();
+    bench_export_throughput();
+    bench_can_pub();
+    bench_txt_format();
+    bench_pipeline();
+
+    return 0;
+}
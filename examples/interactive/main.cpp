@@ -57,11 +57,13 @@ void auth_function()
 
 void pub_thread()
 {
+    // separate context for this thread, as the shell processes requests concurrently
+    ThingSet pub_thing(thing);
     char pub_msg[1000];
 
     while (1) {
         if (pub_report_enable) {
-            thing.txt_statement(pub_msg, sizeof(pub_msg), "mReport");
+            pub_thing.txt_statement(pub_msg, sizeof(pub_msg), "mReport");
             printf("%s\r\n", pub_msg);
         }
         std::this_thread::sleep_for(std::chrono::milliseconds(pub_report_interval));
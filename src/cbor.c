@@ -6,6 +6,7 @@
 
 #include "cbor.h"
 
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -168,34 +169,254 @@ int cbor_serialize_string(uint8_t *data, const char *value, size_t max_len)
     }
 }
 
-#if CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT
-int cbor_serialize_bytes(uint8_t *data, const uint8_t *bytes, size_t num_bytes, size_t max_len)
+int cbor_serialize_bytes_header(uint8_t *data, size_t num_bytes, size_t max_len)
 {
-    if (num_bytes <= CBOR_NUM_MAX && num_bytes + 1 <= max_len) {
+    if (num_bytes <= CBOR_NUM_MAX && max_len >= 1) {
         data[0] = CBOR_BYTES | (uint8_t)num_bytes;
-        memcpy(&data[1], bytes, num_bytes);
-        return num_bytes + 1;
+        return 1;
     }
-    else if (num_bytes < UINT8_MAX && num_bytes + 2 <= max_len) {
+    else if (num_bytes < UINT8_MAX && max_len >= 2) {
         data[0] = CBOR_BYTES | CBOR_UINT8_FOLLOWS;
         data[1] = (uint8_t)num_bytes;
-        memcpy((char *)&data[2], bytes, num_bytes);
-        return num_bytes + 2;
+        return 2;
     }
-    else if (num_bytes < UINT16_MAX && num_bytes + 3 <= max_len) {
+    else if (num_bytes < UINT16_MAX && max_len >= 3) {
         data[0] = CBOR_BYTES | CBOR_UINT16_FOLLOWS;
         data[1] = (uint16_t)num_bytes >> 8;
         data[2] = (uint16_t)num_bytes;
-        memcpy((char *)&data[3], bytes, num_bytes);
-        return num_bytes + 3;
+        return 3;
     }
     else {
-        // too many bytes (more than 65535)
+        // too many bytes (more than 65535) or buffer too small
+        return 0;
+    }
+}
+
+#if CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT
+int cbor_serialize_bytes(uint8_t *data, const uint8_t *bytes, size_t num_bytes, size_t max_len)
+{
+    int len = cbor_serialize_bytes_header(data, num_bytes, max_len);
+    if (len == 0 || len + num_bytes > max_len) {
         return 0;
     }
+
+    memcpy(&data[len], bytes, num_bytes);
+    return len + num_bytes;
 }
 #endif
 
+/* serializes the head of a data item without checking the buffer size (max. 5 bytes) */
+static inline int _cbor_head(uint8_t *data, uint8_t major_type, uint32_t value)
+{
+    if (value <= CBOR_NUM_MAX) {
+        data[0] = major_type | (uint8_t)value;
+        return 1;
+    }
+    else if (value <= UINT8_MAX) {
+        data[0] = major_type | CBOR_UINT8_FOLLOWS;
+        data[1] = value;
+        return 2;
+    }
+    else if (value <= UINT16_MAX) {
+        data[0] = major_type | CBOR_UINT16_FOLLOWS;
+        data[1] = value >> 8;
+        data[2] = value;
+        return 3;
+    }
+    else {
+        data[0] = major_type | CBOR_UINT32_FOLLOWS;
+        data[1] = value >> 24;
+        data[2] = value >> 16;
+        data[3] = value >> 8;
+        data[4] = value;
+        return 5;
+    }
+}
+
+static inline int _cbor_head_int(uint8_t *data, int32_t value)
+{
+    return (value >= 0) ? _cbor_head(data, CBOR_UINT, value)
+                        : _cbor_head(data, CBOR_NEGINT, -1 - value);
+}
+
+static int _serialize_int_elements_checked(uint8_t *data, const void *values, size_t elem_size,
+                                           bool is_signed, size_t num_elements, size_t max_len)
+{
+    size_t pos = 0;
+
+    for (size_t i = 0; i < num_elements; i++) {
+        const uint8_t *elem = (const uint8_t *)values + i * elem_size;
+        int len;
+        if (elem_size == 1) {
+            len = is_signed ? cbor_serialize_int(&data[pos], *(const int8_t *)elem, max_len - pos)
+                            : cbor_serialize_uint(&data[pos], *elem, max_len - pos);
+        }
+        else if (elem_size == 2) {
+            len = is_signed
+                      ? cbor_serialize_int(&data[pos], *(const int16_t *)elem, max_len - pos)
+                      : cbor_serialize_uint(&data[pos], *(const uint16_t *)elem, max_len - pos);
+        }
+        else {
+            len = is_signed
+                      ? cbor_serialize_int(&data[pos], *(const int32_t *)elem, max_len - pos)
+                      : cbor_serialize_uint(&data[pos], *(const uint32_t *)elem, max_len - pos);
+        }
+        if (len == 0) {
+            return 0;
+        }
+        pos += len;
+    }
+
+    return pos;
+}
+
+int cbor_serialize_int_elements(uint8_t *data, const void *values, size_t elem_size,
+                                bool is_signed, size_t num_elements, size_t max_len)
+{
+    size_t pos = 0;
+
+    if (elem_size != 1 && elem_size != 2 && elem_size != 4) {
+        return 0;
+    }
+    else if (num_elements > max_len / (1 + elem_size)) {
+        // not enough space for the worst case, so the size has to be checked for each element
+        return _serialize_int_elements_checked(data, values, elem_size, is_signed, num_elements,
+                                               max_len);
+    }
+
+    // separate loops for each type without any checks inside
+    if (elem_size == 1 && is_signed) {
+        const int8_t *v = (const int8_t *)values;
+        for (size_t i = 0; i < num_elements; i++) {
+            pos += _cbor_head_int(&data[pos], v[i]);
+        }
+    }
+    else if (elem_size == 1) {
+        const uint8_t *v = (const uint8_t *)values;
+        for (size_t i = 0; i < num_elements; i++) {
+            pos += _cbor_head(&data[pos], CBOR_UINT, v[i]);
+        }
+    }
+    else if (elem_size == 2 && is_signed) {
+        const int16_t *v = (const int16_t *)values;
+        for (size_t i = 0; i < num_elements; i++) {
+            pos += _cbor_head_int(&data[pos], v[i]);
+        }
+    }
+    else if (elem_size == 2) {
+        const uint16_t *v = (const uint16_t *)values;
+        for (size_t i = 0; i < num_elements; i++) {
+            pos += _cbor_head(&data[pos], CBOR_UINT, v[i]);
+        }
+    }
+    else if (is_signed) {
+        const int32_t *v = (const int32_t *)values;
+        for (size_t i = 0; i < num_elements; i++) {
+            pos += _cbor_head_int(&data[pos], v[i]);
+        }
+    }
+    else {
+        const uint32_t *v = (const uint32_t *)values;
+        for (size_t i = 0; i < num_elements; i++) {
+            pos += _cbor_head(&data[pos], CBOR_UINT, v[i]);
+        }
+    }
+
+    return pos;
+}
+
+int cbor_serialize_float_elements(uint8_t *data, const float *values, size_t num_elements,
+                                  size_t max_len)
+{
+    if (num_elements > max_len / 5) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < num_elements; i++) {
+        uint32_t ui;
+        memcpy(&ui, &values[i], sizeof(ui));
+        data[i * 5] = CBOR_FLOAT32;
+        data[i * 5 + 1] = ui >> 24;
+        data[i * 5 + 2] = ui >> 16;
+        data[i * 5 + 3] = ui >> 8;
+        data[i * 5 + 4] = ui;
+    }
+
+    return num_elements * 5;
+}
+
+/* element size of a typed array from the ll bits of the tag (and the f bit for floats) */
+static size_t _typed_array_elem_size(uint8_t tag)
+{
+    size_t ll = tag & 0x03;
+    return (tag & 0x10) ? (size_t)2 << ll : (size_t)1 << ll;
+}
+
+/* copies the elements and reverses the byte order of each element (written to be vectorized) */
+static void _copy_swapped(uint8_t *dst, const uint8_t *src, size_t num_elements, size_t elem_size)
+{
+    if (elem_size == 2) {
+        for (size_t i = 0; i < num_elements; i++) {
+            uint16_t v;
+            memcpy(&v, &src[i * 2], sizeof(v));
+            v = __builtin_bswap16(v);
+            memcpy(&dst[i * 2], &v, sizeof(v));
+        }
+    }
+    else if (elem_size == 4) {
+        for (size_t i = 0; i < num_elements; i++) {
+            uint32_t v;
+            memcpy(&v, &src[i * 4], sizeof(v));
+            v = __builtin_bswap32(v);
+            memcpy(&dst[i * 4], &v, sizeof(v));
+        }
+    }
+    else if (elem_size == 8) {
+        for (size_t i = 0; i < num_elements; i++) {
+            uint64_t v;
+            memcpy(&v, &src[i * 8], sizeof(v));
+            v = __builtin_bswap64(v);
+            memcpy(&dst[i * 8], &v, sizeof(v));
+        }
+    }
+    else {
+        memcpy(dst, src, num_elements * elem_size);
+    }
+}
+
+int cbor_serialize_typed_array(uint8_t *data, uint8_t tag, const void *elements,
+                               size_t num_elements, size_t max_len)
+{
+    const size_t elem_size = _typed_array_elem_size(tag);
+    const size_t num_bytes = num_elements * elem_size;
+
+    if (elem_size == 1) {
+        // byte order flag of 8-bit types has a different meaning (e.g. clamped uint8)
+        tag &= ~CBOR_TYPED_ARRAY_LE;
+    }
+
+    if (max_len < 2) {
+        return 0;
+    }
+    data[0] = CBOR_TAG | CBOR_UINT8_FOLLOWS;
+    data[1] = tag;
+
+    int len = cbor_serialize_bytes_header(&data[2], num_bytes, max_len - 2);
+    if (len == 0 || num_bytes > max_len - 2 - len) {
+        return 0;
+    }
+    len += 2;
+
+    if ((tag & CBOR_TYPED_ARRAY_LE) == CBOR_TYPED_ARRAY_NATIVE || elem_size == 1) {
+        memcpy(&data[len], elements, num_bytes);
+    }
+    else {
+        _copy_swapped(&data[len], (const uint8_t *)elements, num_elements, elem_size);
+    }
+
+    return len + num_bytes;
+}
+
 int _serialize_num_elements(uint8_t *data, size_t num_elements, size_t max_len)
 {
     if (num_elements <= CBOR_NUM_MAX && max_len > 0) {
@@ -231,6 +452,76 @@ int cbor_serialize_array(uint8_t *data, size_t num_elements, size_t max_len)
     return _serialize_num_elements(data, num_elements, max_len);
 }
 
+/* header with uint16 length is reserved, as more than 65535 elements are not supported */
+#define CONTAINER_HEADER_RESERVED 3
+
+int cbor_serialize_array_start(uint8_t *data, size_t max_len)
+{
+    if (max_len < CONTAINER_HEADER_RESERVED) {
+        return 0;
+    }
+    data[0] = CBOR_ARRAY;
+    return CONTAINER_HEADER_RESERVED;
+}
+
+int cbor_serialize_map_start(uint8_t *data, size_t max_len)
+{
+    if (max_len < CONTAINER_HEADER_RESERVED) {
+        return 0;
+    }
+    data[0] = CBOR_MAP;
+    return CONTAINER_HEADER_RESERVED;
+}
+
+int cbor_serialize_container_end(uint8_t *data, size_t len, size_t num_elements)
+{
+    uint8_t header[CONTAINER_HEADER_RESERVED];
+
+    if (len < CONTAINER_HEADER_RESERVED) {
+        return 0;
+    }
+
+    header[0] = data[0] & CBOR_TYPE_MASK;
+    int header_len = _serialize_num_elements(header, num_elements, sizeof(header));
+    if (header_len == 0) {
+        return 0;
+    }
+
+    memcpy(data, header, header_len);
+    if (header_len < CONTAINER_HEADER_RESERVED) {
+        memmove(data + header_len, data + CONTAINER_HEADER_RESERVED,
+                len - CONTAINER_HEADER_RESERVED);
+    }
+    return len - CONTAINER_HEADER_RESERVED + header_len;
+}
+
+int cbor_serialize_array_indefinite(uint8_t *data, size_t max_len)
+{
+    if (max_len < 1) {
+        return 0;
+    }
+    data[0] = CBOR_ARRAY | CBOR_VAR_FOLLOWS;
+    return 1;
+}
+
+int cbor_serialize_map_indefinite(uint8_t *data, size_t max_len)
+{
+    if (max_len < 1) {
+        return 0;
+    }
+    data[0] = CBOR_MAP | CBOR_VAR_FOLLOWS;
+    return 1;
+}
+
+int cbor_serialize_break(uint8_t *data, size_t max_len)
+{
+    if (max_len < 1) {
+        return 0;
+    }
+    data[0] = CBOR_BREAK;
+    return 1;
+}
+
 #if CONFIG_THINGSET_64BIT_TYPES_SUPPORT
 int _cbor_uint_data(const uint8_t *data, uint64_t *bytes)
 #else
@@ -538,6 +829,58 @@ int cbor_deserialize_float(const uint8_t *data, float *value)
     return 0;
 }
 
+int cbor_deserialize_float_elements(const uint8_t *data, float *values, size_t num_elements)
+{
+    size_t pos = 0;
+
+    for (size_t i = 0; i < num_elements; i++) {
+        if (data[pos] == CBOR_FLOAT32) {
+            uint32_t ui = (uint32_t)data[pos + 1] << 24 | (uint32_t)data[pos + 2] << 16
+                          | (uint32_t)data[pos + 3] << 8 | data[pos + 4];
+            memcpy(&values[i], &ui, sizeof(ui));
+            pos += 5;
+        }
+        else {
+            int len = cbor_deserialize_float(&data[pos], &values[i]);
+            if (len == 0) {
+                return 0;
+            }
+            pos += len;
+        }
+    }
+
+    return pos;
+}
+
+int cbor_deserialize_typed_array(const uint8_t *data, uint8_t tag, void *elements,
+                                 size_t max_elements, uint16_t *num_elements)
+{
+    const size_t elem_size = _typed_array_elem_size(tag);
+    const uint8_t *bytes;
+    uint16_t num_bytes;
+
+    if (data[0] != (CBOR_TAG | CBOR_UINT8_FOLLOWS)
+        || (data[1] | CBOR_TYPED_ARRAY_LE) != (tag | CBOR_TYPED_ARRAY_LE))
+    {
+        return 0;
+    }
+
+    int len = cbor_deserialize_bytes_zero_copy(&data[2], &bytes, &num_bytes);
+    if (len == 0 || num_bytes % elem_size != 0 || num_bytes / elem_size > max_elements) {
+        return 0;
+    }
+
+    if ((data[1] & CBOR_TYPED_ARRAY_LE) == CBOR_TYPED_ARRAY_NATIVE || elem_size == 1) {
+        memcpy(elements, bytes, num_bytes);
+    }
+    else {
+        _copy_swapped((uint8_t *)elements, bytes, num_bytes / elem_size, elem_size);
+    }
+
+    *num_elements = num_bytes / elem_size;
+    return 2 + len;
+}
+
 int cbor_deserialize_bool(const uint8_t *data, bool *value)
 {
     if (!value || !data)
@@ -596,6 +939,38 @@ int cbor_deserialize_string_zero_copy(const uint8_t *data, char **str_start, uin
     return 0; // longer string not supported
 }
 
+int cbor_deserialize_bytes_zero_copy(const uint8_t *data, const uint8_t **bytes,
+                                     uint16_t *num_bytes)
+{
+    if (!data || !bytes || !num_bytes) {
+        return 0;
+    }
+
+    uint8_t type = data[0] & CBOR_TYPE_MASK;
+    uint8_t info = data[0] & CBOR_INFO_MASK;
+
+    if (type != CBOR_BYTES) {
+        return 0;
+    }
+
+    if (info <= CBOR_NUM_MAX) {
+        *num_bytes = info;
+        *bytes = &data[1];
+        return *num_bytes + 1;
+    }
+    else if (info == CBOR_UINT8_FOLLOWS) {
+        *num_bytes = data[1];
+        *bytes = &data[2];
+        return *num_bytes + 2;
+    }
+    else if (info == CBOR_UINT16_FOLLOWS) {
+        *num_bytes = data[1] << 8 | data[2];
+        *bytes = &data[3];
+        return *num_bytes + 3;
+    }
+    return 0; // longer byte string not supported
+}
+
 #if CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT
 int cbor_deserialize_bytes(const uint8_t *data, uint8_t *bytes, uint16_t buf_size,
                            uint16_t *num_bytes)
@@ -667,6 +1042,76 @@ int cbor_num_elements(const uint8_t *data, uint16_t *num_elements)
     return 0; // more map/array elements not supported
 }
 
+int cbor_item_size(const uint8_t *data, size_t len)
+{
+    // nested items are walked iteratively, so that the stack usage does not depend on the input
+    uint64_t num_items = 1;
+    size_t pos = 0;
+
+    while (num_items > 0) {
+        if (pos >= len) {
+            return 0;
+        }
+
+        uint8_t type = data[pos] & CBOR_TYPE_MASK;
+        uint8_t info = data[pos] & CBOR_INFO_MASK;
+        size_t head;
+        uint32_t arg = 0;
+
+        // the head size is determined by the additional info for all major types
+        if (info <= CBOR_NUM_MAX) {
+            head = 1;
+            arg = info;
+        }
+        else if (info >= CBOR_UINT8_FOLLOWS && info <= CBOR_UINT64_FOLLOWS) {
+            head = 1 + (1U << (info - CBOR_UINT8_FOLLOWS));
+            if (len - pos < head) {
+                return 0;
+            }
+            if (head <= 5) {
+                for (size_t i = 1; i < head; i++) {
+                    arg = arg << 8 | data[pos + i];
+                }
+            }
+        }
+        else {
+            return -1; // indefinite lengths or reserved values
+        }
+
+        if (head == 9 && type != CBOR_UINT && type != CBOR_NEGINT && type != CBOR_MISC) {
+            return -1; // lengths above 32 bits are not supported
+        }
+
+        num_items--;
+        pos += head;
+
+        switch (type) {
+            case CBOR_BYTES:
+            case CBOR_TEXT:
+                if (pos + (uint64_t)arg > INT_MAX) {
+                    return -1;
+                }
+                pos += arg;
+                break;
+            case CBOR_ARRAY:
+                num_items += arg;
+                break;
+            case CBOR_MAP:
+                num_items += 2 * (uint64_t)arg;
+                break;
+            case CBOR_TAG:
+                num_items++;
+                break;
+        }
+
+        if (pos > INT_MAX) {
+            return -1;
+        }
+    }
+
+    return pos;
+}
+
 // determines the size of a cbor data item starting at given pointer
 int cbor_size(const uint8_t *data)
 {
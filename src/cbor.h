@@ -43,6 +43,25 @@ extern "C" {
 #define CBOR_DATETIME_EPOCH_FOLLOWS  1 /**< Datetime epoch */
 #define CBOR_DECFRAC_ARRAY_FOLLOWS   4 /**< Decimal fraction */
 
+/* Tags of typed arrays (RFC 8746) in big-endian byte order */
+#define CBOR_TYPED_ARRAY_UINT8   64 /**< Typed array of uint8 */
+#define CBOR_TYPED_ARRAY_UINT16  65 /**< Typed array of uint16 */
+#define CBOR_TYPED_ARRAY_UINT32  66 /**< Typed array of uint32 */
+#define CBOR_TYPED_ARRAY_UINT64  67 /**< Typed array of uint64 */
+#define CBOR_TYPED_ARRAY_SINT8   72 /**< Typed array of int8 */
+#define CBOR_TYPED_ARRAY_SINT16  73 /**< Typed array of int16 */
+#define CBOR_TYPED_ARRAY_SINT32  74 /**< Typed array of int32 */
+#define CBOR_TYPED_ARRAY_SINT64  75 /**< Typed array of int64 */
+#define CBOR_TYPED_ARRAY_FLOAT32 81 /**< Typed array of float32 */
+
+#define CBOR_TYPED_ARRAY_LE 0x04 /**< Flag of typed array tags for little-endian byte order */
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define CBOR_TYPED_ARRAY_NATIVE 0 /**< Flag for the byte order of this device */
+#else
+#define CBOR_TYPED_ARRAY_NATIVE CBOR_TYPED_ARRAY_LE /**< Flag for the byte order of this device */
+#endif
+
 /* Major type 7: Simple values and float */
 #define CBOR_FALSE     (CBOR_MISC | 20) /**< Simple value: false */
 #define CBOR_TRUE      (CBOR_MISC | 21) /**< Simple value: true */
@@ -129,6 +148,17 @@ int cbor_serialize_bool(uint8_t *data, bool value, size_t max_len);
  */
 int cbor_serialize_string(uint8_t *data, const char *value, size_t max_len);
 
+/**
+ * Serialize only the header of a byte string (the bytes have to be added separately)
+ *
+ * @param data Buffer where CBOR data shall be stored
+ * @param num_bytes Number of bytes of the byte string
+ * @param max_len Maximum remaining space in buffer (i.e. max length of serialized data)
+ *
+ * @returns Number of bytes added to buffer or 0 in case of error
+ */
+int cbor_serialize_bytes_header(uint8_t *data, size_t num_bytes, size_t max_len);
+
 /**
  * Serialize bytes
  *
@@ -154,6 +184,55 @@ int cbor_serialize_bytes(uint8_t *data, const uint8_t *bytes, size_t num_bytes,
  */
 int cbor_serialize_array(uint8_t *data, size_t num_elements, size_t max_len);
 
+/**
+ * Serialize the elements of an integer array (without the array header)
+ *
+ * Specialized for the element type, so that large arrays can be serialized without checking the
+ * type of each element.
+ *
+ * @param data Buffer where CBOR data shall be stored
+ * @param values Pointer to the first element
+ * @param elem_size Size of the elements in bytes (1, 2 or 4)
+ * @param is_signed True if the elements are signed integers
+ * @param num_elements Number of elements
+ * @param max_len Maximum remaining space in buffer (i.e. max length of serialized data)
+ *
+ * @returns Number of bytes added to buffer or 0 in case of error
+ */
+int cbor_serialize_int_elements(uint8_t *data, const void *values, size_t elem_size,
+                                bool is_signed, size_t num_elements, size_t max_len);
+
+/**
+ * Serialize the elements of a float array as single-precision floats (without the array header)
+ *
+ * @param data Buffer where CBOR data shall be stored
+ * @param values Pointer to the first element
+ * @param num_elements Number of elements
+ * @param max_len Maximum remaining space in buffer (i.e. max length of serialized data)
+ *
+ * @returns Number of bytes added to buffer or 0 in case of error
+ */
+int cbor_serialize_float_elements(uint8_t *data, const float *values, size_t num_elements,
+                                  size_t max_len);
+
+/**
+ * Serialize a typed array according to RFC 8746 (tagged byte string)
+ *
+ * The elements are copied with memcpy if the byte order of the tag is the byte order of this
+ * device, otherwise the bytes of each element are swapped.
+ *
+ * @param data Buffer where CBOR data shall be stored
+ * @param tag Typed array tag incl. the byte order flag (e.g. CBOR_TYPED_ARRAY_FLOAT32 |
+ *            CBOR_TYPED_ARRAY_NATIVE)
+ * @param elements Pointer to the first element
+ * @param num_elements Number of elements
+ * @param max_len Maximum remaining space in buffer (i.e. max length of serialized data)
+ *
+ * @returns Number of bytes added to buffer or 0 in case of error
+ */
+int cbor_serialize_typed_array(uint8_t *data, uint8_t tag, const void *elements,
+                               size_t num_elements, size_t max_len);
+
 /**
  * Serialize the header (length field) of a map (equivalent to JSON object)
  *
@@ -167,6 +246,79 @@ int cbor_serialize_array(uint8_t *data, size_t num_elements, size_t max_len);
  */
 int cbor_serialize_map(uint8_t *data, size_t num_elements, size_t max_len);
 
+/**
+ * Start an array with a number of elements not known in advance
+ *
+ * Space for the largest supported header is reserved, so that the elements can be serialized
+ * directly afterwards. The header has to be finalized with cbor_serialize_container_end.
+ *
+ * @param data Buffer where CBOR data shall be stored
+ * @param max_len Maximum remaining space in buffer (i.e. max length of serialized data)
+ *
+ * @returns Number of bytes added to buffer or 0 in case of error
+ */
+int cbor_serialize_array_start(uint8_t *data, size_t max_len);
+
+/**
+ * Start a map with a number of elements not known in advance
+ *
+ * See cbor_serialize_array_start for details.
+ *
+ * @param data Buffer where CBOR data shall be stored
+ * @param max_len Maximum remaining space in buffer (i.e. max length of serialized data)
+ *
+ * @returns Number of bytes added to buffer or 0 in case of error
+ */
+int cbor_serialize_map_start(uint8_t *data, size_t max_len);
+
+/**
+ * Finalize an array or map started with cbor_serialize_array_start or cbor_serialize_map_start
+ *
+ * The number of elements is written into the reserved header. If the header needs less space
+ * than reserved, the elements are moved towards the header.
+ *
+ * @param data Buffer where the container was started (pointing to the header)
+ * @param len Number of bytes serialized so far, including the reserved header
+ * @param num_elements Number of elements in the array (or key/value pairs in the map)
+ *
+ * @returns Total length of the container or 0 in case of error
+ */
+int cbor_serialize_container_end(uint8_t *data, size_t len, size_t num_elements);
+
+/**
+ * Serialize the header of an indefinite-length array
+ *
+ * The elements have to be serialized afterwards, followed by a break (see cbor_serialize_break).
+ *
+ * @param data Buffer where CBOR data shall be stored
+ * @param max_len Maximum remaining space in buffer (i.e. max length of serialized data)
+ *
+ * @returns Number of bytes added to buffer or 0 in case of error
+ */
+int cbor_serialize_array_indefinite(uint8_t *data, size_t max_len);
+
+/**
+ * Serialize the header of an indefinite-length map
+ *
+ * The elements have to be serialized afterwards, followed by a break (see cbor_serialize_break).
+ *
+ * @param data Buffer where CBOR data shall be stored
+ * @param max_len Maximum remaining space in buffer (i.e. max length of serialized data)
+ *
+ * @returns Number of bytes added to buffer or 0 in case of error
+ */
+int cbor_serialize_map_indefinite(uint8_t *data, size_t max_len);
+
+/**
+ * Serialize the break stop code to terminate an indefinite-length array or map
+ *
+ * @param data Buffer where CBOR data shall be stored
+ * @param max_len Maximum remaining space in buffer (i.e. max length of serialized data)
+ *
+ * @returns Number of bytes added to buffer or 0 in case of error
+ */
+int cbor_serialize_break(uint8_t *data, size_t max_len);
+
 /**
  * Deserialization (CBOR data to C values)
  */
@@ -306,6 +458,18 @@ int cbor_deserialize_string(const uint8_t *data, char *str, uint16_t buf_size);
  */
 int cbor_deserialize_string_zero_copy(const uint8_t *data, char **str_start, uint16_t *str_len);
 
+/**
+ * Deserialize bytes without copying them
+ *
+ * @param data Buffer containing CBOR data with matching type
+ * @param bytes Pointer to store start of the bytes in the buffer
+ * @param num_bytes Pointer to store number of bytes
+ *
+ * @returns Number of bytes read from data buffer or 0 in case of error
+ */
+int cbor_deserialize_bytes_zero_copy(const uint8_t *data, const uint8_t **bytes,
+                                     uint16_t *num_bytes);
+
 /**
  * Deserialize bytes
  *
@@ -319,6 +483,36 @@ int cbor_deserialize_string_zero_copy(const uint8_t *data, char **str_start, uin
 int cbor_deserialize_bytes(const uint8_t *data, uint8_t *bytes, uint16_t buf_size,
                            uint16_t *num_bytes);
 
+/**
+ * Deserialize the elements of a float array (without the array header)
+ *
+ * Elements encoded as single-precision floats are decoded directly, other number types are
+ * converted like with cbor_deserialize_float.
+ *
+ * @param data Buffer containing the CBOR data of the elements
+ * @param values Pointer to the first element
+ * @param num_elements Number of elements
+ *
+ * @returns Number of bytes read from buffer or 0 in case of error
+ */
+int cbor_deserialize_float_elements(const uint8_t *data, float *values, size_t num_elements);
+
+/**
+ * Deserialize a typed array according to RFC 8746 (tagged byte string)
+ *
+ * Typed arrays in both byte orders are accepted.
+ *
+ * @param data Buffer containing CBOR data with matching type
+ * @param tag Typed array tag of the expected element type (byte order flag is ignored)
+ * @param elements Pointer to the buffer for the elements
+ * @param max_elements Maximum number of elements in the buffer
+ * @param num_elements Pointer to store the number of elements
+ *
+ * @returns Number of bytes read from data buffer or 0 in case of error
+ */
+int cbor_deserialize_typed_array(const uint8_t *data, uint8_t tag, void *elements,
+                                 size_t max_elements, uint16_t *num_elements);
+
 /**
  * Determine the number of elements in a map or an array
  *
@@ -338,6 +532,22 @@ int cbor_num_elements(const uint8_t *data, uint16_t *num_elements);
  */
 int cbor_size(const uint8_t *data);
 
+/**
+ * Determine the size of a cbor data item which may not have been received completely
+ *
+ * In contrast to cbor_size, only the given number of bytes is accessed. Arrays and maps (also
+ * nested) and tagged data items are supported. Nested items are walked without recursion, so the
+ * nesting depth of untrusted input does not affect the stack usage.
+ *
+ * @param data Pointer for starting point of data item
+ * @param len Number of bytes available in the buffer
+ *
+ * @returns Size in bytes (may be larger than len if the last string of the item is incomplete),
+ *          0 if more bytes are needed to determine the size or -1 if the data item is not
+ *          well-formed, not supported or larger than INT_MAX
+ */
+int cbor_item_size(const uint8_t *data, size_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -10,27 +10,214 @@
 
 #include "thingset_priv.h"
 
+#include "cbor.h"
+
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+/* number of IDs covered by the bitmaps in each pass of ts_check_objects */
+#define CHECK_BITMAP_BITS 1024
+
+static inline bool _bit_test(const uint32_t *bitmap, uint32_t bit)
+{
+    return bitmap[bit / 32] & (1U << (bit % 32));
+}
+
+static inline void _bit_set(uint32_t *bitmap, uint32_t bit)
+{
+    bitmap[bit / 32] |= 1U << (bit % 32);
+}
 
-static void _check_id_duplicates(const struct ts_data_object *data, size_t num)
+static int _object_error(struct ts_object_error *err, int code, ts_object_id_t id)
 {
-    for (unsigned int i = 0; i < num; i++) {
-        for (unsigned int j = i + 1; j < num; j++) {
-            if (data[i].id == data[j].id) {
-                LOG_ERR("ThingSet error: Duplicate data object ID 0x%X.\n", data[i].id);
+    if (err != NULL) {
+        err->code = code;
+        err->id = id;
+    }
+    return code;
+}
+
+int ts_check_objects(struct ts_context *ts, struct ts_object_error *err)
+{
+    const struct ts_data_object *objs = ts->data_objects;
+    uint32_t ids[CHECK_BITMAP_BITS / 32];
+    uint32_t records[CHECK_BITMAP_BITS / 32];
+    uint32_t min_id = UINT16_MAX;
+    uint32_t max_id = 0;
+
+    _object_error(err, 0, 0);
+
+    for (size_t i = 0; i < ts->num_objects; i++) {
+        min_id = objs[i].id < min_id ? objs[i].id : min_id;
+        max_id = objs[i].id > max_id ? objs[i].id : max_id;
+    }
+
+    for (size_t i = 0; i < ts->num_objects; i++) {
+        if (objs[i].parent != TS_ID_ROOT && (objs[i].parent < min_id || objs[i].parent > max_id)) {
+            return _object_error(err, -ENOENT, objs[i].id);
+        }
+    }
+
+    /*
+     * Instead of comparing all pairs of objects, the range of used IDs is processed in slices.
+     * The IDs of each slice are marked in a bitmap, so that duplicates and parents are found with
+     * two passes through the objects per slice without requiring any additional memory.
+     */
+    for (uint32_t start = min_id; start <= max_id; start += CHECK_BITMAP_BITS) {
+        memset(ids, 0, sizeof(ids));
+        memset(records, 0, sizeof(records));
+
+        for (size_t i = 0; i < ts->num_objects; i++) {
+            uint32_t bit = objs[i].id - start;
+            if (objs[i].id < start || bit >= CHECK_BITMAP_BITS) {
+                continue;
+            }
+            if (_bit_test(ids, bit)) {
+                return _object_error(err, -EEXIST, objs[i].id);
+            }
+            _bit_set(ids, bit);
+            if (objs[i].type == TS_T_RECORDS) {
+                _bit_set(records, bit);
+            }
+        }
+
+        for (size_t i = 0; i < ts->num_objects; i++) {
+            ts_object_id_t parent = objs[i].parent;
+            uint32_t bit = parent - start;
+            if (parent == TS_ID_ROOT || parent < start || bit >= CHECK_BITMAP_BITS) {
+                continue;
+            }
+            if (!_bit_test(ids, bit)) {
+                return _object_error(err, -ENOENT, objs[i].id);
+            }
+            // record items are expected directly after the records object (see
+            // json_serialize_record in thingset_txt.c)
+            if (_bit_test(records, bit)
+                && (i == 0 || (objs[i - 1].id != parent && objs[i - 1].parent != parent)))
+            {
+                return _object_error(err, -EINVAL, objs[i].id);
             }
         }
     }
+
+    return 0;
+}
+
+static int _validate_objects(struct ts_context *ts)
+{
+    struct ts_object_error err;
+
+    int ret = ts_check_objects(ts, &err);
+    if (ret == -EEXIST) {
+        LOG_ERR("ThingSet error: Duplicate data object ID 0x%X.\n", err.id);
+    }
+    else if (ret == -ENOENT) {
+        LOG_ERR("ThingSet error: Parent of data object 0x%X not found.\n", err.id);
+    }
+    else if (ret == -EINVAL) {
+        LOG_ERR("ThingSet error: Record item 0x%X not directly after records object.\n", err.id);
+    }
+
+    return ret;
+}
+
+/* resets the state of a context owning its data objects */
+static void _init_common(struct ts_context *ts)
+{
+    ts->shared = NULL;
+#if CONFIG_THINGSET_SEQLOCK
+    memset(ts->seqlocks, 0, sizeof(ts->seqlocks));
+#endif
+    ts->capture.values = NULL;
+    ts->capture.filter = NULL;
+    ts->iov.iov = NULL;
+    ts_clear_path_cache(ts);
 }
 
 int ts_init(struct ts_context *ts, struct ts_data_object *data, size_t num)
 {
-    _check_id_duplicates(data, num);
+    ts->data_objects = data;
+    ts->num_objects = num;
+    ts->_auth_flags = TS_USR_MASK;
+    memset(&ts->index, 0, sizeof(ts->index));
+    _init_common(ts);
 
+    return _validate_objects(ts);
+}
+
+int ts_init_indexed(struct ts_context *ts, struct ts_data_object *data, size_t num,
+                    uint16_t *index_buf, size_t index_buf_len)
+{
     ts->data_objects = data;
     ts->num_objects = num;
     ts->_auth_flags = TS_USR_MASK;
+    _init_common(ts);
+
+    int err = ts_index_build(ts, index_buf, index_buf_len);
+    if (err != 0) {
+        LOG_ERR("ThingSet error: Index buffer too small.\n");
+    }
+
+    int ret = _validate_objects(ts);
+
+    return (ret != 0) ? ret : err;
+}
+
+int ts_init_prebuilt(struct ts_context *ts, struct ts_data_object *data, size_t num,
+                     const struct ts_index *index, uint16_t *subsets_buf, size_t subsets_buf_len)
+{
+    ts->data_objects = data;
+    ts->num_objects = num;
+    ts->_auth_flags = TS_USR_MASK;
+    _init_common(ts);
+
+    // data objects were already validated when generating the index
+    if (index->ids_len != TS_ID_INDEX_LEN(num) || index->names_len != TS_NAME_INDEX_LEN(num)
+        || index->children_len != TS_CHILD_INDEX_LEN(num))
+    {
+        LOG_ERR("ThingSet error: Index does not match data objects.\n");
+        memset(&ts->index, 0, sizeof(ts->index));
+        return -EINVAL;
+    }
+
+    memset(&ts->index, 0, sizeof(ts->index));
+    ts->index.ids = index->ids;
+    ts->index.ids_len = index->ids_len;
+    ts->index.names = index->names;
+    ts->index.names_len = index->names_len;
+    ts->index.children = index->children;
+    ts->index.children_len = index->children_len;
+
+    // subsets are searched linearly without buffer or if the lists don't fit into the buffer
+    ts->index.subsets = subsets_buf;
+    ts->index.subsets_size = subsets_buf_len;
+    (void)ts_index_update_subsets(ts);
+
+    return 0;
+}
+
+int ts_init_shared(struct ts_context *ts, struct ts_context *shared)
+{
+    // always refer to the context owning the database
+    if (shared->shared != NULL) {
+        shared = shared->shared;
+    }
+
+    ts->data_objects = shared->data_objects;
+    ts->num_objects = shared->num_objects;
+    ts->index = shared->index;
+    ts->shared = shared;
+    ts->_auth_flags = TS_USR_MASK;
+    // the update callback of the owning context is used
+    ts->_update_subsets = 0;
+    ts->update_cb = NULL;
+    ts->chunk.active = false;
+    ts->capture.values = NULL;
+    ts->capture.filter = NULL;
+    ts->iov.iov = NULL;
+    ts_clear_path_cache(ts);
 
     return 0;
 }
@@ -48,17 +235,105 @@ extern struct ts_data_object _ts_data_object_list_end[];
 
 int ts_init_global(struct ts_context *ts)
 {
-    /* duplicates are checked at compile-time */
+    /* duplicates are already checked at compile-time, but parents are not */
 
     ts->data_objects = _ts_data_object_list_start;
     ts->num_objects = _ts_data_object_list_end - _ts_data_object_list_start;
     ts->_auth_flags = TS_USR_MASK;
+    memset(&ts->index, 0, sizeof(ts->index));
+    _init_common(ts);
 
-    return 0;
+    return _validate_objects(ts);
 }
 
 #endif
 
+int ts_request_id_parse(const uint8_t *msg, size_t len, uint32_t *id)
+{
+    if (len < 1) {
+        return 0;
+    }
+    else if (msg[0] == TS_REQUEST_ID) {
+        int size = cbor_item_size(&msg[1], len - 1);
+        if (size <= 0 || (size_t)size > len - 1 || cbor_deserialize_uint32(&msg[1], id) != size) {
+            return -EINVAL;
+        }
+        return 1 + size;
+    }
+    else if (msg[0] == TS_TXT_REQUEST_ID) {
+        uint32_t value = 0;
+        size_t pos = 1;
+        while (pos < len && msg[pos] >= '0' && msg[pos] <= '9') {
+            uint32_t digit = msg[pos] - '0';
+            if (value > (UINT32_MAX - digit) / 10) {
+                return -EINVAL;
+            }
+            value = value * 10 + digit;
+            pos++;
+        }
+        if (pos == 1 || pos >= len || msg[pos] != ' ') {
+            return -EINVAL;
+        }
+        *id = value;
+        return pos + 1;
+    }
+    return 0;
+}
+
+int ts_request_id_serialize(uint8_t *buf, size_t size, uint32_t id, bool binary)
+{
+    if (size < 2) {
+        return 0;
+    }
+    else if (binary) {
+        buf[0] = TS_REQUEST_ID;
+        int len = cbor_serialize_uint(&buf[1], id, size - 1);
+        return len > 0 ? 1 + len : 0;
+    }
+    else {
+        buf[0] = TS_TXT_REQUEST_ID;
+        int len = ts_txt_format_uint((char *)&buf[1], size - 1, id);
+        if ((size_t)len + 2 >= size) {
+            // no space for the separator and the null-termination
+            return 0;
+        }
+        buf[len + 1] = ' ';
+        return len + 2;
+    }
+}
+
+/* processes a request with ID prefix and adds the same prefix to the response */
+static int ts_process_with_id(struct ts_context *ts, const uint8_t *request, size_t request_len,
+                              uint8_t *response, size_t response_size)
+{
+    uint32_t id;
+    const bool binary = (request[0] == TS_REQUEST_ID);
+
+    response[0] = '\0';
+
+    int prefix_len = ts_request_id_parse(request, request_len, &id);
+    if (prefix_len <= 0 || (size_t)prefix_len >= request_len
+        || request[prefix_len] == TS_REQUEST_ID || request[prefix_len] == TS_TXT_REQUEST_ID)
+    {
+        return 0;
+    }
+
+    int resp_prefix_len = ts_request_id_serialize(response, response_size, id, binary);
+    if (resp_prefix_len == 0) {
+        return 0;
+    }
+
+    int len = ts_process(ts, &request[prefix_len], request_len - prefix_len,
+                         &response[resp_prefix_len], response_size - resp_prefix_len);
+    if (len <= 0) {
+        // no response (e.g. for statements)
+        response[0] = '\0';
+        return 0;
+    }
+
+    return resp_prefix_len + len;
+}
+
 int ts_process(struct ts_context *ts, const uint8_t *request, size_t request_len, uint8_t *response,
                size_t response_size)
 {
@@ -67,11 +342,16 @@ int ts_process(struct ts_context *ts, const uint8_t *request, size_t request_len
         return 0;
     }
 
+    if (request[0] == TS_REQUEST_ID || request[0] == TS_TXT_REQUEST_ID) {
+        return ts_process_with_id(ts, request, request_len, response, response_size);
+    }
+
     // assign private variables
     ts->req = request;
     ts->req_len = request_len;
     ts->resp = response;
     ts->resp_size = response_size;
+    ts->chunk.active = false;
 
     if (ts->req[0] < 0x20) {
         // binary mode request
@@ -90,6 +370,318 @@ int ts_process(struct ts_context *ts, const uint8_t *request, size_t request_len
     }
 }
 
+/* size of the byte string header reserved for each response in a binary batch */
+#define BATCH_BYTES_HEADER_SIZE 3
+
+static int ts_process_batch_bin(struct ts_context *ts, const uint8_t *request, size_t request_len,
+                                uint8_t *response, size_t response_size)
+{
+    const uint8_t *sub_req;
+    uint16_t sub_req_len;
+    uint16_t num_requests;
+
+    // the head of the array must be complete before it is decoded
+    uint8_t info = request[0] & CBOR_INFO_MASK;
+    if (info > CBOR_UINT16_FOLLOWS
+        || (info > CBOR_NUM_MAX && request_len < 1 + (1U << (info - CBOR_UINT8_FOLLOWS))))
+    {
+        return -EINVAL;
+    }
+
+    size_t pos_req = cbor_num_elements(request, &num_requests);
+    if (pos_req == 0) {
+        return -EINVAL;
+    }
+
+    // check the entire envelope first, so that no request is processed for a malformed batch
+    for (uint16_t i = 0; i < num_requests; i++) {
+        int size = cbor_item_size(&request[pos_req], request_len - pos_req);
+        if (size <= 0 || (size_t)size > request_len - pos_req
+            || cbor_deserialize_bytes_zero_copy(&request[pos_req], &sub_req, &sub_req_len) != size)
+        {
+            return -EINVAL;
+        }
+        pos_req += size;
+    }
+    if (pos_req != request_len) {
+        return -EINVAL;
+    }
+
+    size_t pos_resp = cbor_serialize_array(response, num_requests, response_size);
+    if (pos_resp == 0) {
+        return -ENOMEM;
+    }
+
+    pos_req = cbor_num_elements(request, &num_requests);
+    for (uint16_t i = 0; i < num_requests; i++) {
+        pos_req += cbor_deserialize_bytes_zero_copy(&request[pos_req], &sub_req, &sub_req_len);
+
+        if (response_size - pos_resp < BATCH_BYTES_HEADER_SIZE) {
+            return -ENOMEM;
+        }
+
+        // generate the response behind the largest possible header and move it if necessary
+        uint8_t *sub_resp = &response[pos_resp + BATCH_BYTES_HEADER_SIZE];
+        int len = ts_process(ts, sub_req, sub_req_len, sub_resp,
+                             response_size - pos_resp - BATCH_BYTES_HEADER_SIZE);
+
+        int header_len = cbor_serialize_bytes_header(&response[pos_resp], len,
+                                                     BATCH_BYTES_HEADER_SIZE);
+        if (header_len == 0) {
+            return -ENOMEM;
+        }
+        else if (header_len < BATCH_BYTES_HEADER_SIZE) {
+            memmove(&response[pos_resp + header_len], sub_resp, len);
+        }
+        pos_resp += header_len + len;
+    }
+
+    return pos_resp;
+}
+
+/*
+ * Returns the next line of a text mode batch (without line break) and moves pos behind it.
+ */
+static const uint8_t *ts_batch_next_line(const uint8_t *request, size_t request_len, size_t *pos,
+                                         size_t *line_len)
+{
+    const uint8_t *line = &request[*pos];
+    const uint8_t *line_end = memchr(line, '\n', request_len - *pos);
+    size_t len = (line_end != NULL) ? (size_t)(line_end - line) : request_len - *pos;
+
+    *pos += len + 1;
+
+    if (len > 0 && line[len - 1] == '\r') {
+        len--;
+    }
+    *line_len = len;
+
+    return line;
+}
+
+/*
+ * Checks if a text mode request always generates a response, so that an empty response means
+ * that the buffer was too small.
+ */
+static bool ts_batch_txt_response_expected(const uint8_t *line, size_t line_len)
+{
+    uint32_t id;
+    int prefix_len = ts_request_id_parse(line, line_len, &id);
+    if (prefix_len < 0 || (size_t)prefix_len >= line_len) {
+        return false;
+    }
+
+    const uint8_t c = line[prefix_len];
+    return c == '?' || c == '=' || c == '+' || c == '-' || c == '!';
+}
+
+static int ts_process_batch_txt(struct ts_context *ts, const uint8_t *request, size_t request_len,
+                                uint8_t *response, size_t response_size)
+{
+    const uint8_t *line;
+    size_t line_len;
+    size_t pos_req = 0;
+    size_t pos_resp = 0;
+
+    // binary requests (incl. binary request ID prefix) can't be separated by line breaks
+    while (pos_req < request_len) {
+        line = ts_batch_next_line(request, request_len, &pos_req, &line_len);
+        if (line_len > 0 && line[0] < 0x20) {
+            return -EINVAL;
+        }
+    }
+
+    response[0] = '\0';
+
+    pos_req = 0;
+    while (pos_req < request_len) {
+        line = ts_batch_next_line(request, request_len, &pos_req, &line_len);
+        if (line_len == 0) {
+            continue;
+        }
+
+        // space for the line break and the null-termination behind the response
+        if (response_size - pos_resp < 3) {
+            return -ENOMEM;
+        }
+
+        int len = ts_process(ts, line, line_len, &response[pos_resp], response_size - pos_resp - 2);
+        if (len == 0 && ts_batch_txt_response_expected(line, line_len)) {
+            response[pos_resp] = '\0';
+            return -ENOMEM;
+        }
+
+        pos_resp += len;
+        response[pos_resp++] = '\n';
+        response[pos_resp] = '\0';
+    }
+
+    return pos_resp;
+}
+
+int ts_process_batch(struct ts_context *ts, const uint8_t *request, size_t request_len,
+                     uint8_t *response, size_t response_size)
+{
+    if (request == NULL || request_len < 1 || response == NULL || response_size < 1) {
+        return -EINVAL;
+    }
+
+    if ((request[0] & CBOR_TYPE_MASK) == CBOR_ARRAY) {
+        return ts_process_batch_bin(ts, request, request_len, response, response_size);
+    }
+    else {
+        return ts_process_batch_txt(ts, request, request_len, response, response_size);
+    }
+}
+
+int ts_process_iov(struct ts_context *ts, const uint8_t *request, size_t request_len,
+                   uint8_t *buf, size_t buf_size, struct ts_iovec *iov, size_t iov_max)
+{
+    if (iov == NULL || iov_max < 1) {
+        return -EINVAL;
+    }
+
+    ts->iov.iov = iov;
+    ts->iov.max_payloads = (iov_max - 1) / 2;
+    ts->iov.num_payloads = 0;
+
+    int len = ts_process(ts, request, request_len, buf, buf_size);
+
+    ts->iov.iov = NULL;
+
+    if (len <= 0) {
+        return 0;
+    }
+
+    // offsets of the payloads are relative to the start of the actual response behind a possible
+    // request ID prefix
+    const size_t prefix_len = ts->resp - buf;
+
+    // insert the parts of the buffer between the referenced payloads
+    size_t num = 0;
+    size_t start = 0;
+    for (size_t i = 0; i < ts->iov.num_payloads; i++) {
+        size_t offset = iov[num].len + prefix_len;
+        if (offset > (size_t)len) {
+            // payload is not part of the final response (e.g. error response)
+            break;
+        }
+        iov[num].base = &buf[start];
+        iov[num].len = offset - start;
+        start = offset;
+        num += 2;
+    }
+
+    if (start < (size_t)len || num == 0) {
+        iov[num].base = &buf[start];
+        iov[num].len = len - start;
+        num++;
+    }
+
+    return num;
+}
+
+int ts_process_begin(struct ts_context *ts, const uint8_t *request, size_t request_len,
+                     uint8_t *scratch, size_t scratch_size)
+{
+    struct ts_chunk_state *chunk = &ts->chunk;
+    int prefix_len = 0;
+    int resp_prefix_len = 0;
+    int len;
+
+    memset(chunk, 0, sizeof(*chunk));
+
+    if (request == NULL || request_len < 1 || scratch == NULL || scratch_size < 1) {
+        return -EINVAL;
+    }
+
+    if (request[0] == TS_REQUEST_ID || request[0] == TS_TXT_REQUEST_ID) {
+        // same as ts_process_with_id, but the prefix stays at the beginning of the first chunk
+        uint32_t id;
+        prefix_len = ts_request_id_parse(request, request_len, &id);
+        if (prefix_len <= 0 || (size_t)prefix_len >= request_len
+            || request[prefix_len] == TS_REQUEST_ID || request[prefix_len] == TS_TXT_REQUEST_ID)
+        {
+            return -EINVAL;
+        }
+        resp_prefix_len =
+            ts_request_id_serialize(scratch, scratch_size, id, request[0] == TS_REQUEST_ID);
+        if (resp_prefix_len == 0) {
+            return -ENOMEM;
+        }
+    }
+
+    ts->req = request + prefix_len;
+    ts->req_len = request_len - prefix_len;
+    ts->resp = scratch + resp_prefix_len;
+    ts->resp_size = scratch_size - resp_prefix_len;
+
+    chunk->scratch = scratch;
+    chunk->scratch_size = scratch_size;
+    chunk->active = true;
+
+    // GET requests only serialize the beginning of the response and set chunk->elements
+    if (ts->req[0] < 0x20) {
+        len = ts_bin_process(ts);
+    }
+    else if (ts->req[0] == '?' || ts->req[0] == '=' || ts->req[0] == '+' || ts->req[0] == '-'
+             || ts->req[0] == '!')
+    {
+        len = ts_txt_process(ts);
+    }
+    else {
+        chunk->active = false;
+        return -EINVAL;
+    }
+
+    if (len <= 0) {
+        chunk->active = false;
+        return -ENOMEM;
+    }
+
+    chunk->pending_len = resp_prefix_len + len;
+
+    return 0;
+}
+
+int ts_process_next_chunk(struct ts_context *ts, uint8_t *buf, size_t size)
+{
+    struct ts_chunk_state *chunk = &ts->chunk;
+    size_t len = 0;
+
+    if (!chunk->active) {
+        return 0;
+    }
+
+    while (len < size) {
+        if (chunk->pending_pos < chunk->pending_len) {
+            size_t num_bytes = chunk->pending_len - chunk->pending_pos;
+            if (num_bytes > size - len) {
+                num_bytes = size - len;
+            }
+            memcpy(buf + len, chunk->scratch + chunk->pending_pos, num_bytes);
+            chunk->pending_pos += num_bytes;
+            len += num_bytes;
+        }
+        else if (chunk->elements) {
+            // serialize next child object (or end of the response) into the scratch buffer
+            int ret = (ts->req[0] < 0x20) ? ts_bin_get_next(ts) : ts_txt_get_next(ts);
+            if (ret < 0) {
+                chunk->active = false;
+                return ret;
+            }
+            chunk->pending_pos = 0;
+            chunk->pending_len = ret;
+        }
+        else {
+            chunk->active = false;
+            break;
+        }
+    }
+
+    return len;
+}
+
 void ts_set_authentication(struct ts_context *ts, uint8_t flags)
 {
     ts->_auth_flags = flags;
@@ -97,13 +689,19 @@ void ts_set_authentication(struct ts_context *ts, uint8_t flags)
 
 void ts_set_update_callback(struct ts_context *ts, const uint16_t subsets, void (*update_cb)(void))
 {
-    ts->_update_subsets = subsets;
-    ts->update_cb = update_cb;
+    // same callback for all contexts sharing the data objects
+    struct ts_context *owner = ts->shared ? ts->shared : ts;
+    owner->_update_subsets = subsets;
+    owner->update_cb = update_cb;
 }
 
 struct ts_data_object *ts_get_object_by_name(struct ts_context *ts, const char *name, size_t len,
                                              int32_t parent)
 {
+    if (parent != -1 && ts->index.names != NULL) {
+        return ts_index_find_name(ts, name, len, parent);
+    }
+
     for (unsigned int i = 0; i < ts->num_objects; i++) {
         if (parent != -1 && ts->data_objects[i].parent != parent) {
             continue;
@@ -120,6 +718,10 @@ struct ts_data_object *ts_get_object_by_name(struct ts_context *ts, const char *
 
 struct ts_data_object *ts_get_object_by_id(struct ts_context *ts, ts_object_id_t id)
 {
+    if (ts->index.ids != NULL) {
+        return ts_index_find_id(ts, id);
+    }
+
     for (unsigned int i = 0; i < ts->num_objects; i++) {
         if (ts->data_objects[i].id == id) {
             return &(ts->data_objects[i]);
@@ -128,8 +730,8 @@ struct ts_data_object *ts_get_object_by_id(struct ts_context *ts, ts_object_id_t
     return NULL;
 }
 
-struct ts_data_object *ts_get_endpoint_by_path(struct ts_context *ts, const char *path, size_t len,
-                                               int *index)
+static struct ts_data_object *_resolve_path(struct ts_context *ts, const char *path, size_t len,
+                                            int *index)
 {
     struct ts_data_object *object = NULL;
     const char *start = path;
@@ -138,8 +740,8 @@ struct ts_data_object *ts_get_endpoint_by_path(struct ts_context *ts, const char
 
     // maximum depth of 10 assumed
     for (int i = 0; i < 10; i++) {
-        end = strchr(start, '/');
-        if (end == NULL || end >= path + len) {
+        end = memchr(start, '/', path + len - start);
+        if (end == NULL) {
             // we are at the end of the path
             if (object != NULL && object->type == TS_T_RECORDS && start[0] >= '0'
                 && start[0] <= '9')
@@ -173,6 +775,569 @@ struct ts_data_object *ts_get_endpoint_by_path(struct ts_context *ts, const char
     return NULL;
 }
 
+#if CONFIG_THINGSET_SEQLOCK
+
+void ts_set_seqlock(struct ts_context *ts, uint16_t subsets, struct ts_seqlock *lock)
+{
+    struct ts_context *owner = ts->shared ? ts->shared : ts;
+
+    for (int bit = 0; bit < TS_NUM_SUBSETS; bit++) {
+        if (subsets & (1U << bit)) {
+            owner->seqlocks[bit] = lock;
+        }
+    }
+}
+
+/*
+ * The sequence numbers only increase, so the sum of all sequence numbers of the selected
+ * subsets can be used to detect an update of any of them.
+ */
+bool ts_seqlock_read_begin(struct ts_context *ts, uint16_t subsets, uint32_t *seq)
+{
+    struct ts_seqlock *const *locks = (ts->shared ? ts->shared : ts)->seqlocks;
+    bool idle = true;
+
+    *seq = 0;
+    for (int bit = 0; bit < TS_NUM_SUBSETS && (subsets >> bit) != 0; bit++) {
+        if ((subsets & (1U << bit)) && locks[bit] != NULL) {
+            uint32_t lock_seq = __atomic_load_n(&locks[bit]->seq, __ATOMIC_ACQUIRE);
+            idle = idle && (lock_seq & 1U) == 0;
+            *seq += lock_seq;
+        }
+    }
+
+    return idle;
+}
+
+bool ts_seqlock_read_retry(struct ts_context *ts, uint16_t subsets, uint32_t seq)
+{
+    struct ts_seqlock *const *locks = (ts->shared ? ts->shared : ts)->seqlocks;
+    uint32_t seq_end = 0;
+
+    // make sure the values are read before the sequence numbers
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    for (int bit = 0; bit < TS_NUM_SUBSETS && (subsets >> bit) != 0; bit++) {
+        if ((subsets & (1U << bit)) && locks[bit] != NULL) {
+            seq_end += __atomic_load_n(&locks[bit]->seq, __ATOMIC_RELAXED);
+        }
+    }
+
+    return seq_end != seq;
+}
+
+#endif /* CONFIG_THINGSET_SEQLOCK */
+
+size_t ts_capture_value_size(const struct ts_data_object *object)
+{
+    switch (object->type) {
+        case TS_T_BOOL:
+            return sizeof(bool);
+        case TS_T_UINT64:
+        case TS_T_INT64:
+            return 8;
+        case TS_T_UINT32:
+        case TS_T_INT32:
+        case TS_T_FLOAT32:
+        case TS_T_DECFRAC:
+            return 4;
+        case TS_T_UINT16:
+        case TS_T_INT16:
+            return 2;
+        case TS_T_UINT8:
+        case TS_T_INT8:
+            return 1;
+        case TS_T_STRING:
+            return object->detail;
+        default:
+            return 0;
+    }
+}
+
+int ts_capture_init(struct ts_context *ts, struct ts_capture_queue *queue,
+                    struct ts_data_object *subset, uint8_t *buf, size_t buf_size)
+{
+    struct ts_data_object *member;
+    struct ts_member_iter iter = { 0 };
+    size_t num_members = 0;
+    size_t offset = 0;
+
+    if (subset == NULL || subset->type != TS_T_SUBSET) {
+        return -EINVAL;
+    }
+
+    while ((member = ts_get_next_member(ts, subset->detail, &iter)) != NULL) {
+        size_t size = ts_capture_value_size(member);
+        if (size == 0) {
+            return -EINVAL;
+        }
+        offset = ts_capture_align(offset, size) + size;
+        num_members++;
+    }
+
+    // all slots start 8-byte aligned, so that the values can be accessed directly
+    size_t skip = (8 - ((uintptr_t)buf & 7U)) & 7U;
+    size_t slot_size = ts_capture_align(offset, 8);
+    if (slot_size == 0) {
+        slot_size = 8;
+    }
+    size_t num_slots = (buf_size > skip) ? (buf_size - skip) / slot_size : 0;
+    if (num_slots > UINT16_MAX) {
+        num_slots = UINT16_MAX;
+    }
+    if (num_slots < 2 || num_members > UINT16_MAX) {
+        return -ENOMEM;
+    }
+
+    queue->subset = subset;
+    queue->buf = buf + skip;
+    queue->slot_size = slot_size;
+    queue->values_size = offset;
+    queue->num_members = num_members;
+    queue->num_slots = num_slots;
+    queue->head = 0;
+    queue->tail = 0;
+
+    return 0;
+}
+
+int ts_capture_push(struct ts_context *ts, struct ts_capture_queue *queue)
+{
+    struct ts_data_object *member;
+    struct ts_member_iter iter = { 0 };
+    unsigned int index = 0;
+    size_t offset = 0;
+
+    const uint16_t head = queue->head;
+    const uint16_t next = (head + 1 < queue->num_slots) ? head + 1 : 0;
+    if (next == __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE)) {
+        return -ENOSPC;
+    }
+
+    uint8_t *slot = &queue->buf[head * queue->slot_size];
+    while ((member = ts_get_next_member(ts, queue->subset->detail, &iter)) != NULL) {
+        size_t size = ts_capture_value_size(member);
+        offset = ts_capture_align(offset, size);
+        // the members may have been changed by a request since the queue was initialized
+        if (index >= queue->num_members || size == 0 || offset + size > queue->values_size) {
+            return -EINVAL;
+        }
+        memcpy(&slot[offset], member->data, size);
+        offset += size;
+        index++;
+    }
+    if (index != queue->num_members) {
+        return -EINVAL;
+    }
+
+    // publish the slot only after all values were written
+    __atomic_store_n(&queue->head, next, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/*
+ * Serializes the statement with the values of the oldest slot using the given serializer
+ * and releases the slot afterwards if successful.
+ */
+static int _capture_statement(struct ts_context *ts, struct ts_capture_queue *queue, void *buf,
+                              size_t buf_size, bool text)
+{
+    const uint16_t tail = queue->tail;
+    if (tail == __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    struct ts_data_object obj;
+    ts->capture.values = &queue->buf[tail * queue->slot_size];
+    ts->capture.size = queue->values_size;
+    ts->capture.num_members = queue->num_members;
+    ts->capture.mismatch = false;
+    ts->capture.obj = &obj;
+
+    int len;
+    if (text) {
+        len = ts_txt_statement(ts, (char *)buf, buf_size, queue->subset);
+    }
+    else {
+        len = ts_bin_statement(ts, (uint8_t *)buf, buf_size, queue->subset);
+    }
+
+    ts->capture.values = NULL;
+
+    if (ts->capture.mismatch) {
+        return -EINVAL;
+    }
+    else if (len <= 0) {
+        // keep the values, so that the statement can be generated again with a larger buffer
+        return -ENOMEM;
+    }
+
+    // the slot may be overwritten by the producer after this point
+    __atomic_store_n(&queue->tail, (tail + 1 < queue->num_slots) ? tail + 1 : 0, __ATOMIC_RELEASE);
+
+    return len;
+}
+
+int ts_capture_bin_statement(struct ts_context *ts, struct ts_capture_queue *queue, uint8_t *buf,
+                             size_t buf_size)
+{
+    return _capture_statement(ts, queue, buf, buf_size, false);
+}
+
+int ts_capture_txt_statement(struct ts_context *ts, struct ts_capture_queue *queue, char *buf,
+                             size_t buf_size)
+{
+    return _capture_statement(ts, queue, buf, buf_size, true);
+}
+
+int ts_delta_init(struct ts_context *ts, struct ts_delta_state *delta,
+                  struct ts_data_object *subset, uint8_t *buf, size_t buf_size,
+                  uint16_t full_sync_interval)
+{
+    struct ts_data_object *member;
+    struct ts_member_iter iter = { 0 };
+    size_t num_members = 0;
+    size_t offset = 0;
+
+    if (subset == NULL || subset->type != TS_T_SUBSET) {
+        return -EINVAL;
+    }
+
+    while ((member = ts_get_next_member(ts, subset->detail, &iter)) != NULL) {
+        size_t size = ts_capture_value_size(member);
+        if (size == 0) {
+            return -EINVAL;
+        }
+        offset = ts_capture_align(offset, size) + size;
+        num_members++;
+    }
+
+    // bitmap of changed members followed by the published values and the snapshot, both with the
+    // same layout as a capture slot
+    size_t skip = (8 - ((uintptr_t)buf & 7U)) & 7U;
+    size_t bitmap_size = ts_capture_align((num_members + 31) / 32 * sizeof(uint32_t), 8);
+    size_t shadow_size = ts_capture_align(offset, 8);
+    if (num_members > UINT16_MAX || buf_size < skip + bitmap_size + shadow_size + offset) {
+        return -ENOMEM;
+    }
+
+    delta->subset = subset;
+    delta->deadbands = NULL;
+    delta->num_deadbands = 0;
+    delta->changed = (uint32_t *)(buf + skip);
+    delta->shadow = buf + skip + bitmap_size;
+    delta->values = delta->shadow + shadow_size;
+    delta->values_size = offset;
+    delta->num_members = num_members;
+    delta->full_sync_interval = full_sync_interval;
+    delta->count = 0;
+    delta->synced = false;
+
+    return 0;
+}
+
+void ts_delta_set_deadbands(struct ts_delta_state *delta, const struct ts_delta_deadband *deadbands,
+                            size_t num_deadbands)
+{
+    delta->deadbands = deadbands;
+    delta->num_deadbands = num_deadbands;
+}
+
+/* absolute difference of two numeric values or -1 for other types */
+static float _delta_diff(const struct ts_data_object *object, const void *value, const void *prev)
+{
+    int64_t diff;
+
+    switch (object->type) {
+        case TS_T_FLOAT32: {
+            float fdiff = *(const float *)value - *(const float *)prev;
+            return (fdiff >= 0) ? fdiff : -fdiff;
+        }
+        case TS_T_UINT64: {
+            uint64_t a = *(const uint64_t *)value;
+            uint64_t b = *(const uint64_t *)prev;
+            return (a > b) ? (float)(a - b) : (float)(b - a);
+        }
+        case TS_T_INT64:
+            diff = *(const int64_t *)value - *(const int64_t *)prev;
+            break;
+        case TS_T_UINT32:
+            diff = (int64_t)(*(const uint32_t *)value) - *(const uint32_t *)prev;
+            break;
+        case TS_T_INT32:
+        case TS_T_DECFRAC:
+            diff = (int64_t)(*(const int32_t *)value) - *(const int32_t *)prev;
+            break;
+        case TS_T_UINT16:
+            diff = (int64_t)(*(const uint16_t *)value) - *(const uint16_t *)prev;
+            break;
+        case TS_T_INT16:
+            diff = (int64_t)(*(const int16_t *)value) - *(const int16_t *)prev;
+            break;
+        case TS_T_UINT8:
+            diff = (int64_t)(*(const uint8_t *)value) - *(const uint8_t *)prev;
+            break;
+        case TS_T_INT8:
+            diff = (int64_t)(*(const int8_t *)value) - *(const int8_t *)prev;
+            break;
+        default:
+            return -1;
+    }
+
+    return (diff >= 0) ? (float)diff : (float)-diff;
+}
+
+static bool _delta_changed(const struct ts_delta_state *delta, const struct ts_data_object *object,
+                           const void *value, const void *prev)
+{
+    if (object->type == TS_T_STRING) {
+        return strncmp((const char *)value, (const char *)prev, object->detail) != 0;
+    }
+    else if (memcmp(value, prev, ts_capture_value_size(object)) == 0) {
+        return false;
+    }
+
+    for (size_t i = 0; i < delta->num_deadbands; i++) {
+        if (delta->deadbands[i].id == object->id) {
+            float diff = _delta_diff(object, value, prev);
+            // NaN (e.g. for floats) is also treated as a change
+            return diff < 0 || !(diff <= delta->deadbands[i].value);
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Copies the current values of all members into the snapshot of the delta state. Returns false
+ * if the members of the subset were changed since the state was initialized.
+ */
+static bool _delta_snapshot(struct ts_context *ts, struct ts_delta_state *delta)
+{
+    struct ts_data_object *member;
+    struct ts_member_iter iter = { 0 };
+    unsigned int index = 0;
+    size_t offset = 0;
+
+    while ((member = ts_get_next_member(ts, delta->subset->detail, &iter)) != NULL) {
+        size_t size = ts_capture_value_size(member);
+        offset = ts_capture_align(offset, size);
+        if (index >= delta->num_members || size == 0 || offset + size > delta->values_size) {
+            return false;
+        }
+        memcpy(&delta->values[offset], member->data, size);
+        offset += size;
+        index++;
+    }
+
+    return index == delta->num_members;
+}
+
+static int _delta_statement(struct ts_context *ts, struct ts_delta_state *delta, void *buf,
+                            size_t buf_size, bool text)
+{
+    struct ts_data_object *member;
+    struct ts_member_iter iter = { 0 };
+    unsigned int index = 0;
+    unsigned int num_changed = 0;
+    size_t offset = 0;
+
+#if CONFIG_THINGSET_SEQLOCK
+    const uint16_t subsets = delta->subset->detail;
+    bool consistent = false;
+    for (int i = 0; i <= CONFIG_THINGSET_SEQLOCK_RETRIES && !consistent; i++) {
+        uint32_t seq;
+        if (ts_seqlock_read_begin(ts, subsets, &seq)) {
+            if (!_delta_snapshot(ts, delta)) {
+                return -EINVAL;
+            }
+            consistent = !ts_seqlock_read_retry(ts, subsets, seq);
+        }
+    }
+    if (!consistent) {
+        return -EBUSY;
+    }
+#else
+    if (!_delta_snapshot(ts, delta)) {
+        return -EINVAL;
+    }
+#endif
+
+    delta->count++;
+    const bool full = !delta->synced
+                      || (delta->full_sync_interval > 0
+                          && delta->count >= delta->full_sync_interval);
+
+    memset(delta->changed, 0, (delta->num_members + 31) / 32 * sizeof(uint32_t));
+    while ((member = ts_get_next_member(ts, delta->subset->detail, &iter)) != NULL) {
+        size_t size = ts_capture_value_size(member);
+        offset = ts_capture_align(offset, size);
+        if (index >= delta->num_members || size == 0 || offset + size > delta->values_size) {
+            return -EINVAL;
+        }
+        if (full || _delta_changed(delta, member, &delta->values[offset], &delta->shadow[offset]))
+        {
+            delta->changed[index / 32] |= 1U << (index % 32);
+            num_changed++;
+        }
+        offset += size;
+        index++;
+    }
+
+    if (num_changed == 0) {
+        return 0;
+    }
+
+    // serialize the snapshot, so that exactly the values stored in the shadow are published
+    int len;
+    struct ts_data_object obj;
+    ts->capture.values = delta->values;
+    ts->capture.size = delta->values_size;
+    ts->capture.filter = delta->changed;
+    ts->capture.num_members = delta->num_members;
+    ts->capture.mismatch = false;
+    ts->capture.obj = &obj;
+    if (text) {
+        len = ts_txt_statement(ts, (char *)buf, buf_size, delta->subset);
+    }
+    else {
+        len = ts_bin_statement(ts, (uint8_t *)buf, buf_size, delta->subset);
+    }
+    ts->capture.values = NULL;
+    ts->capture.filter = NULL;
+
+    if (ts->capture.mismatch) {
+        return -EINVAL;
+    }
+    else if (len <= 0) {
+        // values will be compared with the previously published values again in the next call
+        return -ENOMEM;
+    }
+
+    // store published values as reference for the next statements
+    memset(&iter, 0, sizeof(iter));
+    index = 0;
+    offset = 0;
+    while ((member = ts_get_next_member(ts, delta->subset->detail, &iter)) != NULL) {
+        size_t size = ts_capture_value_size(member);
+        offset = ts_capture_align(offset, size);
+        if (index >= delta->num_members || size == 0 || offset + size > delta->values_size) {
+            break;
+        }
+        if (delta->changed[index / 32] & (1U << (index % 32))) {
+            memcpy(&delta->shadow[offset], &delta->values[offset], size);
+        }
+        offset += size;
+        index++;
+    }
+
+    if (full) {
+        delta->synced = true;
+        delta->count = 0;
+    }
+
+    return len;
+}
+
+int ts_bin_delta_statement(struct ts_context *ts, struct ts_delta_state *delta, uint8_t *buf,
+                           size_t buf_size)
+{
+    return _delta_statement(ts, delta, buf, buf_size, false);
+}
+
+int ts_txt_delta_statement(struct ts_context *ts, struct ts_delta_state *delta, char *buf,
+                           size_t buf_size)
+{
+    return _delta_statement(ts, delta, buf, buf_size, true);
+}
+
+#if CONFIG_THINGSET_PATH_CACHE_SIZE > 0
+
+/* FNV-1a hash of the path */
+static uint32_t _path_hash(const char *path, size_t len)
+{
+    uint32_t hash = 2166136261U;
+
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)path[i]) * 16777619U;
+    }
+    return hash;
+}
+
+struct ts_data_object *ts_get_endpoint_by_path(struct ts_context *ts, const char *path, size_t len,
+                                               int *index)
+{
+    struct ts_path_cache *cache = &ts->path_cache;
+
+    if (len > CONFIG_THINGSET_PATH_CACHE_MAX_LEN) {
+        cache->misses++;
+        return _resolve_path(ts, path, len, index);
+    }
+
+    uint32_t hash = _path_hash(path, len);
+    struct ts_path_cache_entry *lru = &cache->entries[0];
+
+    cache->use_counter++;
+
+    for (int i = 0; i < CONFIG_THINGSET_PATH_CACHE_SIZE; i++) {
+        struct ts_path_cache_entry *entry = &cache->entries[i];
+        if (entry->object != NULL && entry->hash == hash && entry->len == len
+            && memcmp(entry->path, path, len) == 0)
+        {
+            entry->last_used = cache->use_counter;
+            cache->hits++;
+            if (index != NULL && entry->record_index != RECORD_INDEX_NONE) {
+                *index = entry->record_index;
+            }
+            return entry->object;
+        }
+        if (lru->object != NULL
+            && (entry->object == NULL || (int32_t)(entry->last_used - lru->last_used) < 0))
+        {
+            // unused entries are taken first, otherwise the one with the oldest access
+            lru = entry;
+        }
+    }
+
+    cache->misses++;
+
+    int record_index = RECORD_INDEX_NONE;
+    struct ts_data_object *object = _resolve_path(ts, path, len, &record_index);
+    if (object != NULL) {
+        // only successfully resolved paths are stored
+        lru->object = object;
+        lru->record_index = record_index;
+        lru->last_used = cache->use_counter;
+        lru->hash = hash;
+        lru->len = len;
+        memcpy(lru->path, path, len);
+    }
+
+    if (index != NULL && record_index != RECORD_INDEX_NONE) {
+        *index = record_index;
+    }
+    return object;
+}
+
+void ts_clear_path_cache(struct ts_context *ts)
+{
+    memset(&ts->path_cache, 0, sizeof(ts->path_cache));
+}
+
+#else
+
+struct ts_data_object *ts_get_endpoint_by_path(struct ts_context *ts, const char *path, size_t len,
+                                               int *index)
+{
+    return _resolve_path(ts, path, len, index);
+}
+
+void ts_clear_path_cache(struct ts_context *ts)
+{}
+
+#endif /* CONFIG_THINGSET_PATH_CACHE_SIZE > 0 */
+
 struct ts_data_object *ts_get_object_by_path(struct ts_context *ts, const char *path, size_t len)
 {
     return ts_get_endpoint_by_path(ts, path, len, NULL);
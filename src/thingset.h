@@ -19,8 +19,6 @@ extern "C" {
 #include <stdint.h>
 
 #include "cbor.h"
-#define JSMN_HEADER
-#include "jsmn.h"
 
 /*
  * Protocol function codes (same as CoAP)
@@ -32,6 +30,15 @@ extern "C" {
 #define TS_PATCH     0x07 /**< PATCH request (actually iPATCH equivalent in CBOR) */
 #define TS_STATEMENT 0x1F /**< STATEMENT message */
 
+/*
+ * Prefixes of requests and responses with a request ID (ThingSet specific)
+ *
+ * Binary mode: TS_REQUEST_ID followed by the ID as CBOR unsigned int, e.g. 0x1E 0x07 0x01 ...
+ * Text mode: TS_TXT_REQUEST_ID followed by the decimal ID and a space, e.g. "@7 ?Meas"
+ */
+#define TS_REQUEST_ID     0x1E /**< Prefix of binary requests and responses with request ID */
+#define TS_TXT_REQUEST_ID '@'  /**< Prefix of text requests and responses with request ID */
+
 /*
  * Status codes (same as CoAP)
  */
@@ -98,6 +105,21 @@ extern "C" {
  *     0 .. 3: High-priority control frames
  *     5, 7: Normal pub/sub frames for monitoring
  *
+ * Packed pub/sub messages (IDs and values of several data objects, may span multiple frames):
+ *
+ *    28      26 25 24 23           16 15 14 13 12 11    8 7             0
+ *   +----------+-----+---------------+-----+-----+-------+---------------+
+ *   | Priority | 0x1 |    subsets    | typ | msg |  seq  |  source addr  |
+ *   +----------+-----+---------------+-----+-----+-------+---------------+
+ *
+ *   Priority: 7
+ *
+ *   Payload: CBOR-encoded ID/value pairs, split across frames at arbitrary positions
+ *
+ *   Frame type (typ): 0 = first, 1 = consecutive, 2 = last, 3 = single frame
+ *   Message number (msg): Incremented with each message to detect lost frames
+ *   Sequence number (seq): Incremented with each frame of a message
+ *
  * Network management (e.g. address claiming):
  *
  *    28      26 25 24 23           16 15            8 7             0
@@ -133,6 +155,31 @@ extern "C" {
 #define TS_CAN_DATA_ID_SET(id) (((uint32_t)id << TS_CAN_DATA_ID_POS) & TS_CAN_DATA_ID_MASK)
 #define TS_CAN_DATA_ID_GET(id) (((uint32_t)id & TS_CAN_DATA_ID_MASK) >> TS_CAN_DATA_ID_POS)
 
+/* subsets, frame type and numbers of packed publication messages */
+#define TS_CAN_PACKED_SUBSETS_POS     (16U)
+#define TS_CAN_PACKED_SUBSETS_MASK    (0xFF << TS_CAN_PACKED_SUBSETS_POS)
+#define TS_CAN_PACKED_SUBSETS_SET(s) \
+    (((uint32_t)s << TS_CAN_PACKED_SUBSETS_POS) & TS_CAN_PACKED_SUBSETS_MASK)
+#define TS_CAN_PACKED_SUBSETS_GET(id) \
+    (((uint32_t)id & TS_CAN_PACKED_SUBSETS_MASK) >> TS_CAN_PACKED_SUBSETS_POS)
+
+#define TS_CAN_PACKED_TYPE_POS    (14U)
+#define TS_CAN_PACKED_TYPE_MASK   (0x3 << TS_CAN_PACKED_TYPE_POS)
+#define TS_CAN_PACKED_TYPE_FIRST  (0x0 << TS_CAN_PACKED_TYPE_POS)
+#define TS_CAN_PACKED_TYPE_CONSEC (0x1 << TS_CAN_PACKED_TYPE_POS)
+#define TS_CAN_PACKED_TYPE_LAST   (0x2 << TS_CAN_PACKED_TYPE_POS)
+#define TS_CAN_PACKED_TYPE_SINGLE (0x3 << TS_CAN_PACKED_TYPE_POS)
+
+#define TS_CAN_PACKED_MSG_POS     (12U)
+#define TS_CAN_PACKED_MSG_MASK    (0x3 << TS_CAN_PACKED_MSG_POS)
+#define TS_CAN_PACKED_MSG_SET(n)  (((uint32_t)n << TS_CAN_PACKED_MSG_POS) & TS_CAN_PACKED_MSG_MASK)
+#define TS_CAN_PACKED_MSG_GET(id) (((uint32_t)id & TS_CAN_PACKED_MSG_MASK) >> TS_CAN_PACKED_MSG_POS)
+
+#define TS_CAN_PACKED_SEQ_POS     (8U)
+#define TS_CAN_PACKED_SEQ_MASK    (0xF << TS_CAN_PACKED_SEQ_POS)
+#define TS_CAN_PACKED_SEQ_SET(n)  (((uint32_t)n << TS_CAN_PACKED_SEQ_POS) & TS_CAN_PACKED_SEQ_MASK)
+#define TS_CAN_PACKED_SEQ_GET(id) (((uint32_t)id & TS_CAN_PACKED_SEQ_MASK) >> TS_CAN_PACKED_SEQ_POS)
+
 /* bus ID for request/response messages */
 #define TS_CAN_BUS_ID_POS     (16U)
 #define TS_CAN_BUS_ID_MASK    (0xFF << TS_CAN_BUS_ID_POS)
@@ -149,6 +196,7 @@ extern "C" {
 #define TS_CAN_TYPE_MASK (0x3 << TS_CAN_TYPE_POS)
 
 #define TS_CAN_TYPE_REQRESP (0x0 << TS_CAN_TYPE_POS)
+#define TS_CAN_TYPE_PACKED  (0x1 << TS_CAN_TYPE_POS)
 #define TS_CAN_TYPE_PUBSUB  (0x2 << TS_CAN_TYPE_POS)
 #define TS_CAN_TYPE_NETWORK (0x3 << TS_CAN_TYPE_POS)
 
@@ -172,6 +220,7 @@ extern "C" {
 #define TS_CAN_PUBSUB(id) \
     (((id & TS_CAN_TYPE_MASK) == TS_CAN_TYPE_PUBSUB) && TS_CAN_PRIO_GET(id) >= 4)
 #define TS_CAN_REQRESP(id) ((id & TS_CAN_TYPE_MASK) == TS_CAN_TYPE_REQRESP)
+#define TS_CAN_PACKED(id)  ((id & TS_CAN_TYPE_MASK) == TS_CAN_TYPE_PACKED)
 
 #ifdef CONFIG_THINGSET_IMMUTABLE_OBJECTS
 #define MAYBE_CONST const
@@ -691,204 +740,1338 @@ typedef struct ts_data_object ts_data_node __attribute__((deprecated));
 
 /** @endcond */
 
+/** @cond INTERNAL_HIDDEN */
+
+#if CONFIG_THINGSET_ID_INDEX_HASH
+#define TS_ID_INDEX_LEN(num) (2 * (num))
+#else
+#define TS_ID_INDEX_LEN(num) (num)
+#endif
+
+#define TS_NAME_INDEX_LEN(num) (2 * (num))
+
+#define TS_CHILD_INDEX_LEN(num) (num)
+
+#define TS_SUBSET_INDEX_LEN(num) (num)
+
+/* number of subset flags available in struct ts_data_object */
+#define TS_NUM_SUBSETS 7
+
+/** @endcond */
+
 /**
- * ThingSet context.
+ * Number of uint16_t elements required for the index buffer passed to ts_init_indexed.
  *
- * Stores and handles all data objects exposed to different communication interfaces.
+ * @param num Number of data objects in the database
  */
-struct ts_context
+#define TS_INDEX_BUF_LEN(num) \
+    (TS_ID_INDEX_LEN(num) + TS_NAME_INDEX_LEN(num) + TS_CHILD_INDEX_LEN(num) \
+     + TS_SUBSET_INDEX_LEN(num))
+
+/**
+ * Lookup index for the data objects database.
+ *
+ * The tables store positions in the data_objects array (not the objects themselves), so the
+ * index can be placed in any caller-provided memory.
+ */
+struct ts_index
 {
     /**
-     * Array of objects database provided during initialization
+     * Positions of the data objects sorted by ID or hash table of positions if
+     * CONFIG_THINGSET_ID_INDEX_HASH is set. NULL if no index is available.
      */
-    struct ts_data_object *data_objects;
+    const uint16_t *ids;
 
     /**
-     * Number of objects in the data_objects array
+     * Number of elements in the ids table
      */
-    size_t num_objects;
+    size_t ids_len;
 
     /**
-     * Pointer to request buffer (provided in process function)
+     * Hash table of data object positions with the parent ID and the object name as key.
+     * NULL if no index is available.
      */
-    const uint8_t *req;
+    const uint16_t *names;
 
     /**
-     * Length of the request
+     * Number of elements in the names table
      */
-    size_t req_len;
+    size_t names_len;
 
     /**
-     * Pointer to response buffer (provided in process function)
+     * Positions of the data objects sorted by parent ID, so that all children of an object are
+     * stored next to each other in the same order as in the data_objects array. NULL if no index
+     * is available.
      */
-    uint8_t *resp;
+    const uint16_t *children;
 
     /**
-     * Size of response buffer (i.e. maximum length)
+     * Number of elements in the children table
      */
-    size_t resp_size;
+    size_t children_len;
 
     /**
-     * Pointer to the start of JSON payload in the request
+     * Positions of the members of each subset in the same order as in the data_objects array.
+     *
+     * The members of subset flag n are stored from subsets_start[n] to subsets_start[n + 1] - 1.
+     * In contrast to the other tables, the lists are stored in RAM, as they have to be updated if
+     * the subset membership is changed at runtime. NULL if no index is available (also for
+     * indexes generated at build time).
      */
-    char *json_str;
+    uint16_t *subsets;
 
     /**
-     * JSON tokes in json_str parsed by JSMN
+     * Number of elements available in the subsets buffer
      */
-    jsmntok_t tokens[CONFIG_THINGSET_NUM_JSON_TOKENS];
+    size_t subsets_size;
 
     /**
-     * Number of JSON tokens parsed by JSMN
+     * Start of the list for each subset flag in the subsets buffer
      */
-    int tok_count;
+    uint16_t subsets_start[TS_NUM_SUBSETS + 1];
 
     /**
-     * Stores current authentication status (authentication as "normal" user as default)
+     * True if the subset lists are up to date and fit into the buffer
      */
-    uint8_t _auth_flags;
+    bool subsets_valid;
 
     /**
-     * Stores current authentication status (authentication as "normal" user as default)
+     * Sequence number of the subset lists, odd while the lists are rebuilt
      */
-    uint8_t _update_subsets;
+    uint32_t subsets_seq;
 
     /**
-     * Callback to be called from patch function if a value belonging to _update_subsets
-     * was changed
+     * Set if the subset lists have to be rebuilt (again) because the membership was changed
      */
-    void (*update_cb)(void);
+    bool subsets_dirty;
 };
 
+#if CONFIG_THINGSET_PATH_CACHE_SIZE > 0
+
 /**
- * Initialize a ThingSet context.
- *
- * @param ts Pointer to ThingSet context.
- * @param data Pointer to array of ThingSetDataObject type containing the entire object database
- * @param num Number of elements in that array
+ * Entry of the path cache.
  */
-int ts_init(struct ts_context *ts, struct ts_data_object *data, size_t num);
+struct ts_path_cache_entry
+{
+    /**
+     * Resolved data object or NULL if the entry is unused
+     */
+    struct ts_data_object *object;
 
-#ifdef CONFIG_THINGSET_ITERABLE_SECTIONS
+    /**
+     * Record index found in the path or -1 if the path did not contain a record index
+     */
+    int record_index;
+
+    /**
+     * Value of the use counter at the last access (for least recently used replacement)
+     */
+    uint32_t last_used;
+
+    /**
+     * Hash of the path
+     */
+    uint32_t hash;
+
+    /**
+     * Length of the path
+     */
+    uint8_t len;
+
+    /**
+     * Copy of the path (not null-terminated)
+     */
+    char path[CONFIG_THINGSET_PATH_CACHE_MAX_LEN];
+};
 
 /**
- * Initialize a ThingSet context using Zephyr iterable sections.
- *
- * Data objects defined using TS_ADD_* macros will be magically added to the object database by the
- * linker.
- *
- * @param ts Pointer to ThingSet context.
+ * Cache for resolved paths with least recently used replacement.
  */
-int ts_init_global(struct ts_context *ts);
+struct ts_path_cache
+{
+    /**
+     * Cache entries
+     */
+    struct ts_path_cache_entry entries[CONFIG_THINGSET_PATH_CACHE_SIZE];
 
-#endif /* CONFIG_THINGSET_ITERABLE_SECTIONS */
+    /**
+     * Counter incremented with each access
+     */
+    uint32_t use_counter;
+
+    /**
+     * Number of paths found in the cache
+     */
+    uint32_t hits;
+
+    /**
+     * Number of paths not found in the cache (including paths too long to be cached)
+     */
+    uint32_t misses;
+};
+
+#endif /* CONFIG_THINGSET_PATH_CACHE_SIZE > 0 */
 
 /**
- * Process ThingSet request.
- *
- * This function also detects if JSON or CBOR format is used
- *
- * @param ts Pointer to ThingSet context.
- * @param request Pointer to the ThingSet request buffer
- * @param request_len Length of the data in the request buffer
- * @param response Pointer to the buffer where the ThingSet response should be stored
- * @param response_size Size of the response buffer, i.e. maximum allowed length of the response
- *
- * @returns Actual length of the response written to the buffer or 0 in case of error or if no
- *          response message has been generated (e.g. because a statement was processed)
+ * State of a response generated in chunks (see ts_process_begin).
  */
-int ts_process(struct ts_context *ts, const uint8_t *request, size_t request_len, uint8_t *response,
-               size_t response_size);
+struct ts_chunk_state
+{
+    /**
+     * Buffer for the part of the response currently generated (provided in ts_process_begin)
+     */
+    uint8_t *scratch;
+
+    /**
+     * Size of the scratch buffer
+     */
+    size_t scratch_size;
+
+    /**
+     * Position of the first byte in the scratch buffer not yet copied to a chunk
+     */
+    size_t pending_pos;
+
+    /**
+     * Number of valid bytes in the scratch buffer
+     */
+    size_t pending_len;
+
+    /**
+     * Endpoint of a GET request with child objects still to be serialized (NULL for root)
+     */
+    const struct ts_data_object *endpoint;
+
+    /**
+     * Return type flags of the GET request
+     */
+    uint32_t ret_type;
+
+    /**
+     * Record index of the GET request (only used for records)
+     */
+    int record_index;
+
+    /**
+     * Iterator for the child objects of the endpoint
+     */
+    unsigned int iter;
+
+    /**
+     * Number of child objects serialized so far
+     */
+    int num_elements;
+
+    /**
+     * True if ts_process_begin was called and the response is generated in chunks
+     */
+    bool active;
+
+    /**
+     * True if child objects of a GET request still have to be serialized
+     */
+    bool elements;
+};
+
+#if CONFIG_THINGSET_SEQLOCK
 
 /**
- * Print all data objects as a structured JSON text to stdout.
- *
- * WARNING: This is a recursive function and might cause stack overflows if run in constrained
- *          devices with large data object tree. Use with care and for testing only!
+ * Sequence lock for values written by the application and read by the library.
  *
- * @param ts Pointer to ThingSet context.
- * @param obj_id Root object ID where to start with printing
- * @param level Indentation level (=depth inside the data object tree)
+ * The sequence number is odd while the values are updated. Writers never block, but readers
+ * repeat the serialization if the sequence number changed in the meantime.
  */
-void ts_dump_json(struct ts_context *ts, ts_object_id_t obj_id, int level);
+struct ts_seqlock
+{
+    /**
+     * Sequence number incremented before and after updating the values
+     */
+    uint32_t seq;
+};
 
 /**
- * Sets current authentication level.
+ * Start updating the values protected by a sequence lock.
  *
- * The authentication flags must match with access flags specified in ThingSetDataObject to allow
- * read/write access to a data object.
+ * Only a single writer per lock is allowed (e.g. the control loop).
  *
- * @param ts Pointer to ThingSet context.
- * @param flags Flags to define authentication level (1 = access allowed)
+ * @param lock Pointer to the sequence lock
  */
-void ts_set_authentication(struct ts_context *ts, uint8_t flags);
+static inline void ts_seqlock_write_begin(struct ts_seqlock *lock)
+{
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
 
 /**
- * Configures a callback for notification if data belonging to specified subset(s) was updated.
+ * Finish updating the values protected by a sequence lock.
  *
- * @param ts Pointer to ThingSet context.
- * @param subsets Flags to select which subset(s) of data items should be considered
- * @param update_cb Callback to be called after an update.
+ * @param lock Pointer to the sequence lock
  */
-void ts_set_update_callback(struct ts_context *ts, const uint16_t subsets, void (*update_cb)(void));
+static inline void ts_seqlock_write_end(struct ts_seqlock *lock)
+{
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELEASE);
+}
+
+#endif /* CONFIG_THINGSET_SEQLOCK */
 
 /**
- * Retrieve data in JSON format for given subset(s).
- *
- * This function does not return a complete ThingSet message, but only the payload data as a
- * name/value map. It can be used e.g. to store data in the EEPROM or other non-volatile memory.
- *
- * @param ts Pointer to ThingSet context.
- * @param buf Pointer to the buffer where the data should be stored
- * @param buf_size Size of the buffer, i.e. maximum allowed length of the data
- * @param subsets Flags to select which subset(s) of data items should be exported
- *
- * @returns Actual length of the data written to the buffer or 0 in case of error
+ * Request slot of a struct ts_pipeline.
  */
-int ts_txt_export(struct ts_context *ts, char *buf, size_t buf_size, uint16_t subsets);
+struct ts_pipeline_slot
+{
+    /**
+     * Request ID of the pending request
+     */
+    uint32_t id;
+
+    /**
+     * Pointer passed to ts_pipeline_request, returned with the matching response
+     */
+    void *user_data;
+
+    /**
+     * True if a response for this slot is still outstanding
+     */
+    bool pending;
+};
 
 /**
- * Generate statement message in JSON format based on pointer to group or subset.
- *
- * This is the fastest method to generate a statement as it does not require to search through the
- * entire data objects array.
- *
- * @param ts Pointer to ThingSet context.
- * @param buf Pointer to the buffer where the publication message should be stored
- * @param buf_size Size of the message buffer, i.e. maximum allowed length of the message
- * @param object Group or subset object specifying the items to be published
+ * Client-side state to keep multiple requests in flight.
  *
- * @returns Actual length of the message written to the buffer or 0 in case of error
+ * Each request gets a unique request ID, which is returned by the server in the response, so
+ * that the responses can be matched to their requests also if they arrive out of order (e.g.
+ * from different devices behind a gateway). The maximum number of requests in flight is given
+ * by the number of slots.
  */
-int ts_txt_statement(struct ts_context *ts, char *buf, size_t buf_size,
-                     struct ts_data_object *object);
+struct ts_pipeline
+{
+    /**
+     * Array of slots for the pending requests
+     */
+    struct ts_pipeline_slot *slots;
+
+    /**
+     * Number of slots (i.e. the pipeline depth)
+     */
+    size_t num_slots;
+
+    /**
+     * Number of currently pending requests
+     */
+    size_t num_pending;
+
+    /**
+     * ID used for the next request
+     */
+    uint32_t next_id;
+};
 
 /**
- * Generate statement message in JSON format based on path.
- *
- * @param ts Pointer to ThingSet context.
- * @param buf Pointer to the buffer where the publication message should be stored
- * @param buf_size Size of the message buffer, i.e. maximum allowed length of the message
- * @param path Path to group or subset object specifying the items to be published
- *
- * @returns Actual length of the message written to the buffer or 0 in case of error
+ * Segment of a response generated with ts_process_iov.
  */
-int ts_txt_statement_by_path(struct ts_context *ts, char *buf, size_t buf_size, const char *path);
+struct ts_iovec
+{
+    /**
+     * Start of the segment
+     */
+    const void *base;
+
+    /**
+     * Length of the segment in bytes
+     */
+    size_t len;
+};
 
 /**
- * Generate statement message in JSON format based on data object ID.
- *
- * @param ts Pointer to ThingSet context.
- * @param buf Pointer to the buffer where the publication message should be stored
- * @param buf_size Size of the message buffer, i.e. maximum allowed length of the message
- * @param id ID of group or subset object specifying the items to be published
- *
- * @returns Actual length of the message written to the buffer or 0 in case of error
+ * State of a response generated with ts_process_iov.
  */
-int ts_txt_statement_by_id(struct ts_context *ts, char *buf, size_t buf_size, ts_object_id_t id);
+struct ts_iov_state
+{
+    /**
+     * Segments of the response (NULL if the response is generated in a single buffer)
+     *
+     * While serializing, even entries store the offset of the referenced payload in the response
+     * buffer as len and odd entries the referenced payload itself.
+     */
+    struct ts_iovec *iov;
+
+    /**
+     * Maximum number of referenced payloads
+     */
+    size_t max_payloads;
+
+    /**
+     * Number of payloads referenced so far
+     */
+    size_t num_payloads;
+};
 
 /**
- * Generate statement message in JSON format based on pointer to group or subset.
+ * Captured values or filter used while serializing a statement of a subset.
+ */
+struct ts_capture_state
+{
+    /**
+     * Values of the slot currently serialized (NULL if the variables are used)
+     */
+    const uint8_t *values;
+
+    /**
+     * Bitmap of the members to be serialized, indexed by their position in the subset (NULL if
+     * all members are serialized)
+     */
+    const uint32_t *filter;
+
+    /**
+     * Storage for the temporary data object pointing to the captured value
+     */
+    struct ts_data_object *obj;
+
+    /**
+     * Size of the captured values
+     */
+    size_t size;
+
+    /**
+     * Number of members when the values were captured or the filter was created
+     */
+    uint16_t num_members;
+
+    /**
+     * Set if the current members of the subset don't match the captured values or the filter
+     */
+    bool mismatch;
+};
+
+/**
+ * Single-producer single-consumer queue for captured values of a subset.
+ *
+ * See ts_capture_init for details.
+ */
+struct ts_capture_queue
+{
+    /**
+     * Subset data object with the members to be captured
+     */
+    struct ts_data_object *subset;
+
+    /**
+     * Buffer for the captured values
+     */
+    uint8_t *buf;
+
+    /**
+     * Size of the values of all members of the subset (incl. padding)
+     */
+    size_t slot_size;
+
+    /**
+     * Size of the values of all members of the subset without padding at the end of the slot
+     */
+    size_t values_size;
+
+    /**
+     * Number of members of the subset when the queue was initialized
+     */
+    uint16_t num_members;
+
+    /**
+     * Number of slots in the buffer (one slot is always kept free)
+     */
+    uint16_t num_slots;
+
+    /**
+     * Slot written next by ts_capture_push (only changed by the producer)
+     */
+    uint16_t head;
+
+    /**
+     * Slot read next by the statement functions (only changed by the consumer)
+     */
+    uint16_t tail;
+};
+
+/**
+ * Deadband of a data object used for delta statements.
+ */
+struct ts_delta_deadband
+{
+    /**
+     * ID of the data object
+     */
+    ts_object_id_t id;
+
+    /**
+     * Minimum change of the value to be published (in units of the mantissa for decimal
+     * fractions)
+     */
+    float value;
+};
+
+/**
+ * State of delta statements of a subset.
+ *
+ * See ts_delta_init for details.
+ */
+struct ts_delta_state
+{
+    /**
+     * Subset data object with the published members
+     */
+    struct ts_data_object *subset;
+
+    /**
+     * Deadbands of the members (members without deadband are published on any change)
+     */
+    const struct ts_delta_deadband *deadbands;
+
+    /**
+     * Number of deadbands
+     */
+    size_t num_deadbands;
+
+    /**
+     * Bitmap of the members to be published in the current statement
+     */
+    uint32_t *changed;
+
+    /**
+     * Values of the members published in the previous statements
+     */
+    uint8_t *shadow;
+
+    /**
+     * Snapshot of the current values, used for both the change detection and the statement
+     */
+    uint8_t *values;
+
+    /**
+     * Size of the values of all members (same layout for the shadow and the snapshot)
+     */
+    size_t values_size;
+
+    /**
+     * Number of members of the subset when the state was initialized
+     */
+    uint16_t num_members;
+
+    /**
+     * Number of calls between statements containing all members (0 to disable)
+     */
+    uint16_t full_sync_interval;
+
+    /**
+     * Number of calls since the last statement containing all members
+     */
+    uint16_t count;
+
+    /**
+     * True if the shadow values were initialized by a full statement
+     */
+    bool synced;
+};
+
+/**
+ * ThingSet context.
+ *
+ * Stores and handles all data objects exposed to different communication interfaces.
+ */
+struct ts_context
+{
+    /**
+     * Array of objects database provided during initialization
+     */
+    struct ts_data_object *data_objects;
+
+    /**
+     * Number of objects in the data_objects array
+     */
+    size_t num_objects;
+
+    /**
+     * Lookup index for the data objects (only used if initialized with ts_init_indexed)
+     */
+    struct ts_index index;
+
+    /**
+     * Context owning the data objects and the index if this context was initialized with
+     * ts_init_shared, NULL otherwise
+     */
+    struct ts_context *shared;
+
+#if CONFIG_THINGSET_SEQLOCK
+    /**
+     * Sequence locks assigned to the subsets (index is the bit position of the subset)
+     */
+    struct ts_seqlock *seqlocks[TS_NUM_SUBSETS];
+#endif
+
+#if CONFIG_THINGSET_PATH_CACHE_SIZE > 0
+    /**
+     * Cache for resolved paths (hits and misses can be read to determine the required size)
+     */
+    struct ts_path_cache path_cache;
+#endif
+
+    /**
+     * Pointer to request buffer (provided in process function)
+     */
+    const uint8_t *req;
+
+    /**
+     * Length of the request
+     */
+    size_t req_len;
+
+    /**
+     * Pointer to response buffer (provided in process function)
+     */
+    uint8_t *resp;
+
+    /**
+     * Size of response buffer (i.e. maximum length)
+     */
+    size_t resp_size;
+
+    /**
+     * Pointer to the start of JSON payload in the request
+     */
+    char *json_str;
+
+    /**
+     * Length of JSON payload in the request
+     */
+    size_t json_len;
+
+    /**
+     * Stores current authentication status (authentication as "normal" user as default)
+     */
+    uint8_t _auth_flags;
+
+    /**
+     * Stores current authentication status (authentication as "normal" user as default)
+     */
+    uint8_t _update_subsets;
+
+    /**
+     * Callback to be called from patch function if a value belonging to _update_subsets
+     * was changed
+     */
+    void (*update_cb)(void);
+
+    /**
+     * State of a response generated in chunks
+     */
+    struct ts_chunk_state chunk;
+
+    /**
+     * Captured values used for the statement currently generated
+     */
+    struct ts_capture_state capture;
+
+    /**
+     * Segments of a response generated with ts_process_iov
+     */
+    struct ts_iov_state iov;
+};
+
+/**
+ * State of a binary PATCH request received in fragments (see ts_bin_patch_stream_push).
+ */
+struct ts_patch_stream
+{
+    /**
+     * Bytes of the CBOR data item currently received (only the incomplete item is stored)
+     */
+    uint8_t buf[CONFIG_THINGSET_PATCH_STREAM_BUF_SIZE];
+
+    /**
+     * Number of valid bytes in the buffer
+     */
+    uint16_t buf_len;
+
+    /**
+     * Number of key/value pairs in the map of the request
+     */
+    uint16_t num_elements;
+
+    /**
+     * Number of key/value pairs already processed
+     */
+    uint16_t element;
+
+    /**
+     * Endpoint data object of the request
+     */
+    const struct ts_data_object *endpoint;
+
+    /**
+     * Data object of the key received last (the value is still expected)
+     */
+    const struct ts_data_object *object;
+
+    /**
+     * Request ID received in front of the request (only valid if has_id is true)
+     */
+    uint32_t id;
+
+    /**
+     * True if the request started with a request ID prefix
+     */
+    bool has_id;
+
+    /**
+     * Part of the request expected next (internal state of the parser)
+     */
+    uint8_t state;
+
+    /**
+     * True if data objects selected with ts_set_update_callback were changed
+     */
+    bool updated;
+};
+
+/**
+ * State of a packed CAN publication message (see ts_bin_pub_can_packed).
+ */
+struct ts_can_pub_stream
+{
+    /**
+     * Encoded ID and value of the data object currently published
+     */
+    uint8_t buf[CONFIG_THINGSET_CAN_PUB_BUF_SIZE];
+
+    /**
+     * Number of valid bytes in the buffer
+     */
+    uint16_t buf_len;
+
+    /**
+     * Number of bytes of the buffer already sent
+     */
+    uint16_t buf_pos;
+
+    /**
+     * Position in the data_objects array to continue searching for members
+     */
+    unsigned int pos;
+
+    /**
+     * Data object which did not fit into the buffer completely (NULL if none)
+     */
+    const struct ts_data_object *item;
+
+    /**
+     * Number of bytes of the encoded item already stored in the buffer
+     */
+    size_t item_pos;
+
+    /**
+     * Flags to select the published subsets
+     */
+    uint16_t subsets;
+
+    /**
+     * Device ID on the CAN bus
+     */
+    uint8_t can_dev_id;
+
+    /**
+     * Maximum payload length of the frames (8 for classic CAN, up to 64 for CAN FD)
+     */
+    uint8_t frame_size;
+
+    /**
+     * Message number (incremented with each message)
+     */
+    uint8_t msg_num;
+
+    /**
+     * Sequence number of the next frame
+     */
+    uint8_t seq;
+
+    /**
+     * True if the next frame is the first frame of the message
+     */
+    bool first;
+
+    /**
+     * True if frames of the message are left to be sent
+     */
+    bool active;
+};
+
+/**
+ * Publication schedule of subsets for the CAN scheduler (see ts_can_sched_next).
+ *
+ * Only subsets, period and priority have to be set by the application. The remaining fields are
+ * maintained by the scheduler.
+ */
+struct ts_can_sched_entry
+{
+    /**
+     * Flags to select the published subsets
+     */
+    uint16_t subsets;
+
+    /**
+     * Publication period in milliseconds (0 to disable the entry)
+     */
+    uint32_t period_ms;
+
+    /**
+     * Priority of the CAN frames (one of the TS_CAN_PRIO_* values)
+     */
+    uint32_t prio;
+
+    /**
+     * Time when the next publication is due
+     */
+    uint32_t next_ms;
+
+    /**
+     * Time when the current publication was due
+     */
+    uint32_t due_ms;
+
+    /**
+     * Position in the data_objects array to continue the current publication
+     */
+    int pos;
+
+    /**
+     * True if the current publication is not finished yet
+     */
+    bool pending;
+
+    /**
+     * True if the first frame of the current publication was already sent
+     */
+    bool started;
+
+    /**
+     * Maximum delay between the due time and the first frame of a publication in milliseconds
+     */
+    uint32_t max_jitter_ms;
+
+    /**
+     * Number of periods skipped because the previous publication was not finished in time
+     */
+    uint32_t overruns;
+
+    /**
+     * Number of completed publications
+     */
+    uint32_t count;
+};
+
+/**
+ * Scheduler for CAN publication messages of several subsets.
+ */
+struct ts_can_sched
+{
+    /**
+     * Array of the scheduled entries
+     */
+    struct ts_can_sched_entry *entries;
+
+    /**
+     * Number of entries in the array
+     */
+    size_t num_entries;
+
+    /**
+     * Device ID on the CAN bus
+     */
+    uint8_t can_dev_id;
+};
+
+/**
+ * Details about an inconsistency found in the data objects database.
+ */
+struct ts_object_error
+{
+    /**
+     * Error code: -EEXIST for duplicate IDs, -ENOENT if the parent object does not exist or
+     * -EINVAL if a record item is not placed directly after its records object (or the previous
+     * item of the same records object). 0 if no error was found.
+     */
+    int code;
+
+    /**
+     * ID of the data object causing the error
+     */
+    ts_object_id_t id;
+};
+
+/**
+ * Initialize a ThingSet context.
+ *
+ * The data objects are checked for consistency using ts_check_objects.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param data Pointer to array of ThingSetDataObject type containing the entire object database
+ * @param num Number of elements in that array
+ *
+ * @returns 0 for success or negative error code if the data objects are invalid (see
+ *          struct ts_object_error)
+ */
+int ts_init(struct ts_context *ts, struct ts_data_object *data, size_t num);
+
+/**
+ * Initialize a ThingSet context and build a lookup index for the data objects.
+ *
+ * Without an index, finding a data object by its ID requires a linear search through the entire
+ * database. The index is stored in the provided buffer, which has to stay valid as long as the
+ * context is used. Use TS_INDEX_BUF_LEN to determine the required size of the buffer.
+ *
+ * The type of the ID index (sorted table with binary search or hash table) is selected with
+ * CONFIG_THINGSET_ID_INDEX_HASH. Names are always found via a hash table with the parent ID and
+ * the name as key, so that resolving a path segment needs only a single string comparison in
+ * most cases. A third table groups the objects by parent, so that listing the children of a group
+ * (e.g. for GET requests or statements) does not have to go through the entire database.
+ *
+ * In addition, a list of members is maintained for each subset, so that exports and statements
+ * of subsets only visit the members. An object contained in multiple subsets uses one element
+ * per subset. If more elements are required than reserved with TS_INDEX_BUF_LEN, the subsets are
+ * searched linearly.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param data Pointer to array of ThingSetDataObject type containing the entire object database
+ * @param num Number of elements in that array
+ * @param index_buf Buffer to store the index
+ * @param index_buf_len Number of elements in the index buffer
+ *
+ * @returns 0 for success, negative error code if the data objects are invalid (see
+ *          struct ts_object_error) or -ENOMEM if the buffer is too small (the context can still
+ *          be used, but without index)
+ */
+int ts_init_indexed(struct ts_context *ts, struct ts_data_object *data, size_t num,
+                    uint16_t *index_buf, size_t index_buf_len);
+
+/**
+ * Initialize a ThingSet context with an index generated at build time.
+ *
+ * For data objects arrays that don't change at runtime, the index can be generated on the host
+ * using tools/ts_index_gen.c, so that it is stored in flash and does not need any time to be
+ * built during startup. The data objects are validated by the generator, so no checks are
+ * performed by this function.
+ *
+ * The member lists of the subsets are not part of a generated index, as they have to be stored in
+ * RAM. They are built in the separate subsets buffer during initialization. Without buffer (NULL)
+ * or if it is too small, subsets are searched linearly.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param data Pointer to array of ThingSetDataObject type containing the entire object database
+ * @param num Number of elements in that array
+ * @param index Pointer to the generated index
+ * @param subsets_buf Buffer to store the subset member lists (see TS_SUBSET_INDEX_LEN) or NULL
+ * @param subsets_buf_len Number of elements in the subsets buffer
+ *
+ * @returns 0 for success or -EINVAL if the index does not match the number of objects
+ */
+int ts_init_prebuilt(struct ts_context *ts, struct ts_data_object *data, size_t num,
+                     const struct ts_index *index, uint16_t *subsets_buf, size_t subsets_buf_len);
+
+/**
+ * Initialize an additional ThingSet context sharing the data objects with another context.
+ *
+ * Each context stores the state of the request currently processed (buffers, parsed JSON tokens,
+ * authentication), so ts_process can be called concurrently for different contexts, e.g. one per
+ * communication interface running in its own thread. The data objects and the lookup index of
+ * the shared context are used without copying them.
+ *
+ * The update callback is common for all contexts sharing the data objects, also if it is set
+ * after this function was called. The authentication is reset to the normal user.
+ *
+ * The library does not lock the values of the data objects: Values written by one context may be
+ * read partially updated by another one (see ts_set_seqlock for consistent statements).
+ *
+ * Adding or removing subset members ("+" and "-" text mode requests) is allowed while other
+ * contexts handle requests. The member lists of the index are rebuilt by one context at a time
+ * and contexts iterating over the members fall back to a linear search while a rebuild is in
+ * progress. However, changes of the membership of the same data object requested at the same time
+ * by two contexts may overwrite each other.
+ *
+ * @param ts Pointer to the new ThingSet context
+ * @param shared Pointer to an initialized ThingSet context with the data objects
+ *
+ * @returns 0 for success
+ */
+int ts_init_shared(struct ts_context *ts, struct ts_context *shared);
+
+#ifdef CONFIG_THINGSET_ITERABLE_SECTIONS
+
+/**
+ * Initialize a ThingSet context using Zephyr iterable sections.
+ *
+ * Data objects defined using TS_ADD_* macros will be magically added to the object database by the
+ * linker.
+ *
+ * @param ts Pointer to ThingSet context.
+ */
+int ts_init_global(struct ts_context *ts);
+
+#endif /* CONFIG_THINGSET_ITERABLE_SECTIONS */
+
+/**
+ * Check the data objects database of a context for consistency.
+ *
+ * The following conditions are checked:
+ *
+ * - IDs are unique
+ * - Parent objects exist
+ * - Record items directly follow their records object
+ *
+ * The check requires linear time and no additional memory, so it is also suitable for large
+ * databases. It is called by the ts_init functions, which only return the error code.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param err Pointer to store details about the first error found (may be NULL)
+ *
+ * @returns 0 if the data objects are valid or negative error code (see struct ts_object_error)
+ */
+int ts_check_objects(struct ts_context *ts, struct ts_object_error *err);
+
+/**
+ * Process ThingSet request.
+ *
+ * This function also detects if JSON or CBOR format is used
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param request Pointer to the ThingSet request buffer
+ * @param request_len Length of the data in the request buffer
+ * @param response Pointer to the buffer where the ThingSet response should be stored
+ * @param response_size Size of the response buffer, i.e. maximum allowed length of the response
+ *
+ * @returns Actual length of the response written to the buffer or 0 in case of error or if no
+ *          response message has been generated (e.g. because a statement was processed)
+ */
+int ts_process(struct ts_context *ts, const uint8_t *request, size_t request_len, uint8_t *response,
+               size_t response_size);
+
+/**
+ * Parse the request ID prefix of a ThingSet request or response.
+ *
+ * Requests with an ID are processed by ts_process like any other request, but the response
+ * starts with the same ID. This allows clients to send multiple requests without waiting for
+ * the responses (see struct ts_pipeline).
+ *
+ * @param msg Pointer to the request or response
+ * @param len Length of the message
+ * @param id Pointer to store the request ID
+ *
+ * @returns Length of the prefix, 0 if the message does not have a request ID or -EINVAL if the
+ *          prefix is malformed
+ */
+int ts_request_id_parse(const uint8_t *msg, size_t len, uint32_t *id);
+
+/**
+ * Serialize the request ID prefix of a ThingSet request or response.
+ *
+ * @param buf Pointer to the buffer where the prefix should be stored
+ * @param size Size of the buffer
+ * @param id Request ID
+ * @param binary True for binary mode, false for text mode
+ *
+ * @returns Length of the prefix or 0 if the buffer is too small
+ */
+int ts_request_id_serialize(uint8_t *buf, size_t size, uint32_t id, bool binary);
+
+/**
+ * Start processing a ThingSet request with a response generated in chunks.
+ *
+ * Instead of generating the entire response at once like ts_process, the response can be
+ * retrieved in small pieces with ts_process_next_chunk, e.g. to pass it directly to a transport
+ * with small frames. The request is processed immediately, but the child objects of GET
+ * requests are only serialized one by one while retrieving the chunks, so the required RAM does
+ * not depend on the size of the response.
+ *
+ * The scratch buffer has to be large enough for the largest single data object incl. its name
+ * and for the entire response of requests other than GET (e.g. the status message). It has to
+ * stay valid until the response was retrieved completely.
+ *
+ * In text mode, the response is not null-terminated. In binary mode, the number of elements
+ * of a GET response has to be known in advance, so the child objects are iterated twice unless
+ * CONFIG_THINGSET_CBOR_INDEFINITE_LENGTH is enabled.
+ *
+ * Requests with a request ID prefix (see TS_REQUEST_ID) are supported like in ts_process. The
+ * prefix of the response is part of the first chunk.
+ *
+ * The request buffer and the data objects must not be changed before the response was retrieved
+ * completely.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param request Pointer to the ThingSet request buffer
+ * @param request_len Length of the data in the request buffer
+ * @param scratch Buffer used to generate parts of the response
+ * @param scratch_size Size of the scratch buffer
+ *
+ * @returns 0 for success, -EINVAL if the request is not a ThingSet request or -ENOMEM if the
+ *          response could not be generated in the scratch buffer
+ */
+int ts_process_begin(struct ts_context *ts, const uint8_t *request, size_t request_len,
+                     uint8_t *scratch, size_t scratch_size);
+
+/**
+ * Retrieve the next chunk of a response started with ts_process_begin.
+ *
+ * The chunk buffer is filled completely, unless the end of the response was reached.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param buf Buffer to store the chunk
+ * @param size Size of the buffer
+ *
+ * @returns Number of bytes written to the buffer, 0 if the response is complete or -ENOMEM if a
+ *          data object did not fit into the scratch buffer (the response is incomplete in this
+ *          case and has to be discarded by the receiver)
+ */
+int ts_process_next_chunk(struct ts_context *ts, uint8_t *buf, size_t size);
+
+/**
+ * Process a ThingSet request and generate the response as a list of segments (scatter-gather).
+ *
+ * The response is generated in the supplied buffer like with ts_process, except that the bytes
+ * of byte strings with a size of at least CONFIG_THINGSET_IOV_MIN_SIZE are not copied. Instead,
+ * the segments point directly to the application buffers of the byte strings, so that transports
+ * supporting scatter-gather (e.g. with DMA) can send the response without copying it.
+ *
+ * Only binary responses with byte strings are split into multiple segments. The referenced
+ * buffers must not be changed until the response was sent.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param request Pointer to the ThingSet request buffer
+ * @param request_len Length of the data in the request buffer
+ * @param buf Buffer for the response except for the referenced byte strings
+ * @param buf_size Size of the buffer
+ * @param iov Array to store the segments of the response
+ * @param iov_max Maximum number of segments (if a response contains more byte strings, the
+ *                remaining ones are copied into the buffer)
+ *
+ * @returns Number of segments of the response, 0 if no response was generated (e.g. because a
+ *          statement was processed) or -EINVAL if no segment can be stored
+ */
+int ts_process_iov(struct ts_context *ts, const uint8_t *request, size_t request_len,
+                   uint8_t *buf, size_t buf_size, struct ts_iovec *iov, size_t iov_max);
+
+/**
+ * Process a batch of ThingSet requests and generate a matching batch of responses.
+ *
+ * In binary mode, the batch is a CBOR array of byte strings, each containing a complete request.
+ * The response is a CBOR array with the same number of byte strings containing the responses
+ * in the same order. Requests without a response (e.g. statements) result in an empty byte
+ * string.
+ *
+ * In text mode, the batch consists of requests separated by line breaks (optionally preceded
+ * by a carriage return). Empty lines are ignored. Each response is terminated by a line break,
+ * so requests without a response result in an empty line. The entire response is
+ * null-terminated. Binary requests are not allowed in a text mode batch.
+ *
+ * The requests are processed one after the other exactly like with ts_process, so errors in
+ * one request do not affect the others.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param request Pointer to the buffer containing the batch of requests
+ * @param request_len Length of the data in the request buffer
+ * @param response Pointer to the buffer where the batch of responses should be stored
+ * @param response_size Size of the response buffer
+ *
+ * @returns Length of the responses written to the buffer, -EINVAL if the batch is malformed or
+ *          contains binary requests in text mode (no request is processed in this case) or
+ *          -ENOMEM if the response buffer is too small (the requests up to this point were
+ *          processed)
+ */
+int ts_process_batch(struct ts_context *ts, const uint8_t *request, size_t request_len,
+                     uint8_t *response, size_t response_size);
+
+/**
+ * Initialize a client-side request pipeline.
+ *
+ * @param pl Pointer to the pipeline
+ * @param slots Array of slots, one for each request that may be in flight
+ * @param num_slots Number of slots in the array
+ */
+void ts_pipeline_init(struct ts_pipeline *pl, struct ts_pipeline_slot *slots, size_t num_slots);
+
+/**
+ * Add a request to the pipeline.
+ *
+ * The request (text or binary mode) is copied to the buffer with a new request ID prefix, so that
+ * it can be sent to the server without waiting for the responses of previous requests.
+ *
+ * @param pl Pointer to the pipeline
+ * @param req Pointer to the request (without request ID)
+ * @param req_len Length of the request
+ * @param buf Buffer to store the request with request ID
+ * @param buf_size Size of the buffer
+ * @param user_data Pointer returned by ts_pipeline_response for the matching response
+ * @param id Pointer to store the assigned request ID, e.g. for ts_pipeline_cancel (may be NULL)
+ *
+ * @returns Length of the request in the buffer, -EINVAL for an empty request, -EBUSY if all
+ *          slots are in use or -ENOMEM if the buffer is too small
+ */
+int ts_pipeline_request(struct ts_pipeline *pl, const uint8_t *req, size_t req_len, uint8_t *buf,
+                        size_t buf_size, void *user_data, uint32_t *id);
+
+/**
+ * Match a received response with a pending request of the pipeline.
+ *
+ * The slot of the request is released, so that a new request can be added.
+ *
+ * @param pl Pointer to the pipeline
+ * @param resp Pointer to the response (with request ID)
+ * @param resp_len Length of the response
+ * @param payload Pointer to store the start of the response behind the request ID
+ * @param payload_len Pointer to store the length of the response behind the request ID
+ * @param user_data Pointer to store the user data of the request (may be NULL)
+ *
+ * @returns 0 for success, -EINVAL if the response does not have a valid request ID or -ENOENT if
+ *          no request with this ID is pending (e.g. because it was cancelled)
+ */
+int ts_pipeline_response(struct ts_pipeline *pl, const uint8_t *resp, size_t resp_len,
+                         const uint8_t **payload, size_t *payload_len, void **user_data);
+
+/**
+ * Cancel a pending request of the pipeline, e.g. after a timeout.
+ *
+ * A response received later for this request is rejected by ts_pipeline_response.
+ *
+ * @param pl Pointer to the pipeline
+ * @param id Request ID assigned by ts_pipeline_request
+ *
+ * @returns 0 for success or -ENOENT if no request with this ID is pending
+ */
+int ts_pipeline_cancel(struct ts_pipeline *pl, uint32_t id);
+
+/**
+ * Print all data objects as a structured JSON text to stdout.
+ *
+ * WARNING: This is a recursive function and might cause stack overflows if run in constrained
+ *          devices with large data object tree. Use with care and for testing only!
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param obj_id Root object ID where to start with printing
+ * @param level Indentation level (=depth inside the data object tree)
+ */
+void ts_dump_json(struct ts_context *ts, ts_object_id_t obj_id, int level);
+
+/**
+ * Sets current authentication level.
+ *
+ * The authentication flags must match with access flags specified in ThingSetDataObject to allow
+ * read/write access to a data object.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param flags Flags to define authentication level (1 = access allowed)
+ */
+void ts_set_authentication(struct ts_context *ts, uint8_t flags);
+
+/**
+ * Configures a callback for notification if data belonging to specified subset(s) was updated.
+ *
+ * For contexts sharing the data objects (see ts_init_shared), the callback is set for all of
+ * them.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param subsets Flags to select which subset(s) of data items should be considered
+ * @param update_cb Callback to be called after an update.
+ */
+void ts_set_update_callback(struct ts_context *ts, const uint16_t subsets, void (*update_cb)(void));
+
+#if CONFIG_THINGSET_SEQLOCK
+
+/**
+ * Assign a sequence lock to one or more subsets.
+ *
+ * Exports and statements of these subsets are only returned if the values were not updated
+ * while they were serialized. The application has to call ts_seqlock_write_begin and
+ * ts_seqlock_write_end around the updates of the values.
+ *
+ * The serialization is repeated up to CONFIG_THINGSET_SEQLOCK_RETRIES times before the export
+ * or statement fails. So the values should be read by a thread with lower priority than the
+ * writer, and the lock should only be held for short updates.
+ *
+ * Contexts initialized with ts_init_shared use the locks of the owning context.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param subsets Flags to select the subset(s) protected by the lock
+ * @param lock Pointer to the sequence lock or NULL to remove the lock of the subsets
+ */
+void ts_set_seqlock(struct ts_context *ts, uint16_t subsets, struct ts_seqlock *lock);
+
+#endif /* CONFIG_THINGSET_SEQLOCK */
+
+/**
+ * Invalidates all entries of the path cache.
+ *
+ * The cache is cleared during initialization of the context. This function only has to be called
+ * if data objects are changed afterwards, e.g. if an object is renamed. The hit and miss counters
+ * are reset as well.
+ *
+ * Does nothing if CONFIG_THINGSET_PATH_CACHE_SIZE is 0.
+ *
+ * @param ts Pointer to ThingSet context.
+ */
+void ts_clear_path_cache(struct ts_context *ts);
+
+/**
+ * Retrieve data in JSON format for given subset(s).
+ *
+ * This function does not return a complete ThingSet message, but only the payload data as a
+ * name/value map. It can be used e.g. to store data in the EEPROM or other non-volatile memory.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param buf Pointer to the buffer where the data should be stored
+ * @param buf_size Size of the buffer, i.e. maximum allowed length of the data
+ * @param subsets Flags to select which subset(s) of data items should be exported
+ *
+ * @returns Actual length of the data written to the buffer or 0 in case of error
+ */
+int ts_txt_export(struct ts_context *ts, char *buf, size_t buf_size, uint16_t subsets);
+
+/**
+ * Generate statement message in JSON format based on pointer to group or subset.
+ *
+ * This is the fastest method to generate a statement as it does not require to search through the
+ * entire data objects array.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param buf Pointer to the buffer where the publication message should be stored
+ * @param buf_size Size of the message buffer, i.e. maximum allowed length of the message
+ * @param object Group or subset object specifying the items to be published
+ *
+ * @returns Actual length of the message written to the buffer or 0 in case of error
+ */
+int ts_txt_statement(struct ts_context *ts, char *buf, size_t buf_size,
+                     struct ts_data_object *object);
+
+/**
+ * Generate statement message in JSON format based on path.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param buf Pointer to the buffer where the publication message should be stored
+ * @param buf_size Size of the message buffer, i.e. maximum allowed length of the message
+ * @param path Path to group or subset object specifying the items to be published
+ *
+ * @returns Actual length of the message written to the buffer or 0 in case of error
+ */
+int ts_txt_statement_by_path(struct ts_context *ts, char *buf, size_t buf_size, const char *path);
+
+/**
+ * Generate statement message in JSON format based on data object ID.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param buf Pointer to the buffer where the publication message should be stored
+ * @param buf_size Size of the message buffer, i.e. maximum allowed length of the message
+ * @param id ID of group or subset object specifying the items to be published
+ *
+ * @returns Actual length of the message written to the buffer or 0 in case of error
+ */
+int ts_txt_statement_by_id(struct ts_context *ts, char *buf, size_t buf_size, ts_object_id_t id);
+
+/**
+ * Generate statement message in JSON format based on pointer to group or subset.
  *
  * This is the fastest method to generate a statement as it does not require to search through the
  * entire data objects array.
@@ -980,6 +2163,83 @@ int ts_bin_statement_by_id(struct ts_context *ts, uint8_t *buf, size_t buf_size,
 int ts_bin_pub_can(struct ts_context *ts, int *start_pos, uint16_t subset, uint8_t can_dev_id,
                    uint32_t *msg_id, uint8_t *msg_data);
 
+/**
+ * Initialize a scheduler for CAN publication messages.
+ *
+ * Each entry publishes its subsets periodically with its own priority, using the same frame
+ * format as ts_bin_pub_can. All entries are due immediately after initialization.
+ *
+ * @param sched Pointer to the scheduler
+ * @param entries Array of entries with subsets, period_ms and prio set by the application
+ * @param num_entries Number of entries in the array
+ * @param can_dev_id Device ID on the CAN bus
+ * @param now_ms Current time in milliseconds
+ */
+void ts_can_sched_init(struct ts_can_sched *sched, struct ts_can_sched_entry *entries,
+                       size_t num_entries, uint8_t can_dev_id, uint32_t now_ms);
+
+/**
+ * Encode the next due CAN publication frame.
+ *
+ * The function should be called in each tick until it returns 0 or the transmit queue is full.
+ * Frames of entries with higher priority are returned first, so that publications of
+ * slower entries with lower priority are interrupted if a high-priority entry becomes due.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param sched Pointer to the initialized scheduler
+ * @param now_ms Current time in milliseconds (may overflow)
+ * @param msg_id reference to can message id storage
+ * @param msg_data reference to the buffer where the publication message should be stored
+ *
+ * @returns Length of the message_data or 0 if no frame is due
+ */
+int ts_can_sched_next(struct ts_context *ts, struct ts_can_sched *sched, uint32_t now_ms,
+                      uint32_t *msg_id, uint8_t *msg_data);
+
+/**
+ * Start a packed CAN publication message for the supplied subsets.
+ *
+ * In contrast to ts_bin_pub_can, the IDs and values of multiple data objects are packed into
+ * each frame and data objects exceeding the remaining space of a frame are continued in the next
+ * frame. Receivers concatenate the payload of all frames of a message and decode the contained
+ * ID/value pairs.
+ *
+ * Data objects larger than CONFIG_THINGSET_CAN_PUB_BUF_SIZE are encoded in multiple parts, so
+ * their value must not be changed until the message was published completely.
+ *
+ * The message number is incremented with each call, so the stream should be kept for the next
+ * messages.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param stream Pointer to the stream state
+ * @param subsets Flags to select which subsets of data items should be published
+ * @param can_dev_id Device ID on the CAN bus
+ * @param frame_size Maximum payload length of the frames (8 for classic CAN or a valid CAN FD
+ *                   length up to 64)
+ *
+ * @returns 0 for success or -EINVAL if the frame size is not valid
+ */
+int ts_bin_pub_can_packed_begin(struct ts_context *ts, struct ts_can_pub_stream *stream,
+                                uint16_t subsets, uint8_t can_dev_id, uint8_t frame_size);
+
+/**
+ * Encode the next frame of a packed CAN publication message.
+ *
+ * All frames except the last one use the full frame size. Frames longer than 8 bytes are padded
+ * with CBOR undefined (0xF7) to the next valid CAN FD length.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param stream Pointer to the stream state started with ts_bin_pub_can_packed_begin
+ * @param msg_id reference to can message id storage
+ * @param msg_data reference to the buffer where the frame payload should be stored (must be
+ *                 at least frame_size bytes long)
+ *
+ * @returns Length of the frame payload, 0 if all frames of the message were encoded or -EINVAL
+ *          if a data object can't be encoded (the message is incomplete in this case)
+ */
+int ts_bin_pub_can_packed(struct ts_context *ts, struct ts_can_pub_stream *stream,
+                          uint32_t *msg_id, uint8_t *msg_data);
+
 /**
  * Import data in CBOR format into data objects.
  *
@@ -1013,6 +2273,187 @@ int ts_bin_import(struct ts_context *ts, const uint8_t *data, size_t len, uint8_
 int ts_bin_import_record(struct ts_context *ts, const uint8_t *data, size_t len, uint8_t auth_flags,
                          uint16_t subsets, struct ts_data_object *object, int record_index);
 
+/**
+ * Start processing a binary PATCH request received in fragments.
+ *
+ * Must be called before the first fragment of a request is passed to ts_bin_patch_stream_push.
+ *
+ * @param stream Pointer to the parser state (allocated by the caller, e.g. per transport)
+ */
+void ts_bin_patch_stream_begin(struct ts_patch_stream *stream);
+
+/**
+ * Process the next fragment of a binary PATCH request.
+ *
+ * In contrast to ts_process, the request does not have to be stored contiguously in memory.
+ * Only an incomplete CBOR data item is kept in the parser state, all complete key/value pairs
+ * are applied immediately. The access permissions of a data object are checked as soon as its
+ * ID was received, but the value is only written after it was received completely.
+ *
+ * Like for ts_process, data objects updated before an error was detected keep their new values.
+ * A request ID prefix (see TS_REQUEST_ID) in front of the PATCH request is added to the response.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param stream Pointer to the parser state initialized with ts_bin_patch_stream_begin
+ * @param data Pointer to the fragment of the request
+ * @param len Length of the fragment
+ * @param response Pointer to the buffer where the ThingSet response should be stored
+ * @param response_size Size of the response buffer, i.e. maximum allowed length of the response
+ *
+ * @returns Length of the response written to the buffer after the request was processed
+ *          completely or an error was detected, 0 if more fragments are expected. Further
+ *          fragments of the same request are ignored after a response was returned.
+ */
+int ts_bin_patch_stream_push(struct ts_context *ts, struct ts_patch_stream *stream,
+                             const uint8_t *data, size_t len, uint8_t *response,
+                             size_t response_size);
+
+/**
+ * Initialize a queue to capture the values of a subset.
+ *
+ * The queue allows to take snapshots of the values in a time-critical context (e.g. a control
+ * loop interrupt) with ts_capture_push, which only copies the raw values. The statements are
+ * generated from the captured values later on in a thread with lower priority using
+ * ts_capture_bin_statement or ts_capture_txt_statement.
+ *
+ * The queue is lock-free, but only a single producer and a single consumer are allowed.
+ *
+ * Only members with simple types (numbers, bool, decimal fractions and strings) are supported.
+ * The layout of the slots is determined by the members of the subset at initialization. If the
+ * members are changed afterwards (e.g. via a request to add an object to the subset), pushing
+ * and generating statements fails and the queue has to be initialized again.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param queue Pointer to the queue to be initialized
+ * @param subset Subset data object defining the captured members (must be a top-level object)
+ * @param buf Buffer for the captured values
+ * @param buf_size Size of the buffer (determines the number of captures that can be stored)
+ *
+ * @returns 0 for success, -EINVAL if the object is not a subset or a member has an unsupported
+ *          type, -ENOMEM if the buffer can't store at least one capture
+ */
+int ts_capture_init(struct ts_context *ts, struct ts_capture_queue *queue,
+                    struct ts_data_object *subset, uint8_t *buf, size_t buf_size);
+
+/**
+ * Capture the current values of the subset members (producer).
+ *
+ * Only the values are copied, so the function can be called from an interrupt.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param queue Pointer to the queue
+ *
+ * @returns 0 for success, -ENOSPC if the queue is full (the values are not captured) or -EINVAL
+ *          if the members of the subset were changed since the queue was initialized
+ */
+int ts_capture_push(struct ts_context *ts, struct ts_capture_queue *queue);
+
+/**
+ * Generate a binary statement from the oldest captured values and remove them (consumer).
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param queue Pointer to the queue
+ * @param buf Pointer to the buffer where the statement should be stored
+ * @param buf_size Size of the buffer, i.e. maximum allowed length of the statement
+ *
+ * @returns Length of the statement, 0 if the queue is empty, -ENOMEM if the statement did not
+ *          fit into the buffer or -EINVAL if the members of the subset were changed (the captured
+ *          values are kept in the queue in both cases)
+ */
+int ts_capture_bin_statement(struct ts_context *ts, struct ts_capture_queue *queue, uint8_t *buf,
+                             size_t buf_size);
+
+/**
+ * Generate a text mode statement from the oldest captured values and remove them (consumer).
+ *
+ * See ts_capture_bin_statement for details.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param queue Pointer to the queue
+ * @param buf Pointer to the buffer where the statement should be stored
+ * @param buf_size Size of the buffer, i.e. maximum allowed length of the statement
+ *
+ * @returns Length of the statement, 0 if the queue is empty, -ENOMEM if the statement did not
+ *          fit into the buffer or -EINVAL if the members of the subset were changed (the captured
+ *          values are kept in the queue in both cases)
+ */
+int ts_capture_txt_statement(struct ts_context *ts, struct ts_capture_queue *queue, char *buf,
+                             size_t buf_size);
+
+/**
+ * Initialize the state for delta statements of a subset.
+ *
+ * Delta statements only contain the members whose value changed since they were published last
+ * time. The previously published values are stored in the provided buffer, together with a
+ * snapshot of the current values. The snapshot is taken once per statement, so that a value
+ * changed concurrently is either published or detected as changed in the next statement.
+ *
+ * The first statement and every full_sync_interval-th statement afterwards contain all members,
+ * so that new subscribers receive all values after some time.
+ *
+ * Only members with simple types (numbers, bool, decimal fractions and strings) are supported.
+ * The state has to be initialized again after the members of the subset were changed.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param delta Pointer to the state to be initialized
+ * @param subset Subset data object defining the published members (must be a top-level object)
+ * @param buf Buffer for the previously published values
+ * @param buf_size Size of the buffer
+ * @param full_sync_interval Number of calls between statements containing all members (0 to
+ *                           publish all members only with the first statement)
+ *
+ * @returns 0 for success, -EINVAL if the object is not a subset or a member has an unsupported
+ *          type, -ENOMEM if the buffer is too small
+ */
+int ts_delta_init(struct ts_context *ts, struct ts_delta_state *delta,
+                  struct ts_data_object *subset, uint8_t *buf, size_t buf_size,
+                  uint16_t full_sync_interval);
+
+/**
+ * Set the deadbands of members of a delta statement.
+ *
+ * Numeric values are only published if their difference to the previously published value
+ * exceeds the deadband.
+ *
+ * @param delta Pointer to the initialized state
+ * @param deadbands Array with deadbands (must stay valid while the state is used)
+ * @param num_deadbands Number of deadbands in the array
+ */
+void ts_delta_set_deadbands(struct ts_delta_state *delta, const struct ts_delta_deadband *deadbands,
+                            size_t num_deadbands);
+
+/**
+ * Generate a binary statement containing only the changed members of a subset.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param delta Pointer to the initialized state
+ * @param buf Pointer to the buffer where the statement should be stored
+ * @param buf_size Size of the buffer, i.e. maximum allowed length of the statement
+ *
+ * @returns Length of the statement, 0 if no value changed, -ENOMEM if the statement did not fit
+ *          into the buffer, -EBUSY if no consistent snapshot could be taken because of concurrent
+ *          writers or -EINVAL if the members of the subset were changed
+ */
+int ts_bin_delta_statement(struct ts_context *ts, struct ts_delta_state *delta, uint8_t *buf,
+                           size_t buf_size);
+
+/**
+ * Generate a text mode statement containing only the changed members of a subset.
+ *
+ * See ts_bin_delta_statement for details.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param delta Pointer to the initialized state
+ * @param buf Pointer to the buffer where the statement should be stored
+ * @param buf_size Size of the buffer, i.e. maximum allowed length of the statement
+ *
+ * @returns Length of the statement, 0 if no value changed, -ENOMEM if the statement did not fit
+ *          into the buffer, -EBUSY if no consistent snapshot could be taken because of concurrent
+ *          writers or -EINVAL if the members of the subset were changed
+ */
+int ts_txt_delta_statement(struct ts_context *ts, struct ts_delta_state *delta, char *buf,
+                           size_t buf_size);
+
 /**
  * Get data object by ID.
  *
@@ -1083,11 +2524,38 @@ public:
         (void)ts_init(&ts, data, num);
     };
 
+    inline ThingSet(ThingSetDataObject *data, size_t num, uint16_t *index_buf,
+                    size_t index_buf_len)
+    {
+        (void)ts_init_indexed(&ts, data, num, index_buf, index_buf_len);
+    };
+
+    inline ThingSet(ThingSetDataObject *data, size_t num, const struct ts_index *index,
+                    uint16_t *subsets_buf = NULL, size_t subsets_buf_len = 0)
+    {
+        (void)ts_init_prebuilt(&ts, data, num, index, subsets_buf, subsets_buf_len);
+    };
+
+    /**
+     * Create an additional instance for the data objects of another instance, e.g. for a
+     * different communication interface running in its own thread (see ts_init_shared).
+     */
+    inline ThingSet(ThingSet &shared)
+    {
+        (void)ts_init_shared(&ts, &shared.ts);
+    };
+
     inline int process(uint8_t *request, size_t req_len, uint8_t *response, size_t resp_size)
     {
         return ts_process(&ts, request, req_len, response, resp_size);
     };
 
+    inline int process_batch(uint8_t *request, size_t req_len, uint8_t *response,
+                             size_t resp_size)
+    {
+        return ts_process_batch(&ts, request, req_len, response, resp_size);
+    };
+
     inline void dump_json(ts_object_id_t obj_id = 0, int level = 0)
     {
         ts_dump_json(&ts, obj_id, level);
@@ -1154,6 +2622,18 @@ public:
         return ts_bin_pub_can(&ts, &start_pos, subset, can_dev_id, &msg_id, &msg_data[0]);
     };
 
+    inline int bin_pub_can_packed_begin(struct ts_can_pub_stream &stream, uint16_t subsets,
+                                        uint8_t can_dev_id, uint8_t frame_size = 8)
+    {
+        return ts_bin_pub_can_packed_begin(&ts, &stream, subsets, can_dev_id, frame_size);
+    };
+
+    inline int bin_pub_can_packed(struct ts_can_pub_stream &stream, uint32_t &msg_id,
+                                  uint8_t *msg_data)
+    {
+        return ts_bin_pub_can_packed(&ts, &stream, &msg_id, msg_data);
+    };
+
     inline ThingSetDataObject *get_object(ThingSetObjId id)
     {
         return ts_get_object_by_id(&ts, id);
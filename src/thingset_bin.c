@@ -9,6 +9,7 @@
 
 #include "cbor.h"
 
+#include <errno.h>
 #include <math.h> // for rounding of floats
 #include <stdio.h>
 #include <string.h>
@@ -50,6 +51,111 @@ static int cbor_deserialize_simple_value(const uint8_t *buf, void *data, int typ
     }
 }
 
+#if CONFIG_THINGSET_CBOR_TYPED_ARRAYS
+
+static const struct
+{
+    uint8_t type;
+    uint8_t size;
+    uint8_t tag;
+} typed_array_tags[] = {
+    { TS_T_UINT8, sizeof(uint8_t), CBOR_TYPED_ARRAY_UINT8 },
+    { TS_T_INT8, sizeof(int8_t), CBOR_TYPED_ARRAY_SINT8 },
+    { TS_T_UINT16, sizeof(uint16_t), CBOR_TYPED_ARRAY_UINT16 },
+    { TS_T_INT16, sizeof(int16_t), CBOR_TYPED_ARRAY_SINT16 },
+    { TS_T_UINT32, sizeof(uint32_t), CBOR_TYPED_ARRAY_UINT32 },
+    { TS_T_INT32, sizeof(int32_t), CBOR_TYPED_ARRAY_SINT32 },
+#if CONFIG_THINGSET_64BIT_TYPES_SUPPORT
+    { TS_T_UINT64, sizeof(uint64_t), CBOR_TYPED_ARRAY_UINT64 },
+    { TS_T_INT64, sizeof(int64_t), CBOR_TYPED_ARRAY_SINT64 },
+#endif
+    { TS_T_FLOAT32, sizeof(float), CBOR_TYPED_ARRAY_FLOAT32 },
+};
+
+/* returns the (big-endian) typed array tag for the elements or 0 if not supported */
+static uint8_t ts_bin_typed_array_tag(const struct ts_array *array)
+{
+    for (size_t i = 0; i < sizeof(typed_array_tags) / sizeof(typed_array_tags[0]); i++) {
+        if (typed_array_tags[i].type == array->type && typed_array_tags[i].size == array->type_size)
+        {
+            return typed_array_tags[i].tag;
+        }
+    }
+    return 0;
+}
+
+#endif /* CONFIG_THINGSET_CBOR_TYPED_ARRAYS */
+
+/* deserializes all elements with the function for the element type (no type check per element) */
+#define DESERIALIZE_ELEMENTS(func, ctype)                                 \
+    for (uint16_t i = 0; i < num_elements; i++) {                         \
+        int num_bytes = func(&buf[pos], &((ctype *)array->elements)[i]); \
+        if (num_bytes == 0) {                                             \
+            return 0;                                                     \
+        }                                                                 \
+        pos += num_bytes;                                                 \
+    }                                                                     \
+    break
+
+static int cbor_deserialize_array_elements(const uint8_t *buf, struct ts_array *array, int detail)
+{
+    uint16_t num_elements;
+
+#if CONFIG_THINGSET_CBOR_TYPED_ARRAYS
+    uint8_t tag = ts_bin_typed_array_tag(array);
+    if (tag != 0 && (buf[0] & CBOR_TYPE_MASK) == CBOR_TAG) {
+        int len = cbor_deserialize_typed_array(buf, tag, array->elements, array->max_elements,
+                                               &num_elements);
+        if (len > 0) {
+            array->num_elements = num_elements;
+        }
+        return len;
+    }
+#endif
+
+    int pos = cbor_num_elements(buf, &num_elements);
+    if (pos == 0 || num_elements > array->max_elements) {
+        return 0;
+    }
+
+    switch (array->type) {
+        case TS_T_FLOAT32: {
+            int len = cbor_deserialize_float_elements(&buf[pos], (float *)array->elements,
+                                                      num_elements);
+            if (len == 0 && num_elements > 0) {
+                return 0;
+            }
+            pos += len;
+            break;
+        }
+        case TS_T_UINT32:
+            DESERIALIZE_ELEMENTS(cbor_deserialize_uint32, uint32_t);
+        case TS_T_INT32:
+            DESERIALIZE_ELEMENTS(cbor_deserialize_int32, int32_t);
+        case TS_T_UINT16:
+            DESERIALIZE_ELEMENTS(cbor_deserialize_uint16, uint16_t);
+        case TS_T_INT16:
+            DESERIALIZE_ELEMENTS(cbor_deserialize_int16, int16_t);
+        case TS_T_UINT8:
+            DESERIALIZE_ELEMENTS(cbor_deserialize_uint8, uint8_t);
+        case TS_T_INT8:
+            DESERIALIZE_ELEMENTS(cbor_deserialize_int8, int8_t);
+        default:
+            for (uint16_t i = 0; i < num_elements; i++) {
+                void *data = (uint8_t *)array->elements + i * array->type_size;
+                int num_bytes = cbor_deserialize_simple_value(&buf[pos], data, array->type, detail);
+                if (num_bytes == 0) {
+                    return 0;
+                }
+                pos += num_bytes;
+            }
+            break;
+    }
+
+    array->num_elements = num_elements;
+    return pos;
+}
+
 static int cbor_deserialize_data_obj(const uint8_t *buf, const struct ts_data_object *object)
 {
     int pos = cbor_deserialize_simple_value(buf, object->data, object->type, object->detail);
@@ -69,19 +175,7 @@ static int cbor_deserialize_data_obj(const uint8_t *buf, const struct ts_data_ob
             if (!array) {
                 return 0;
             }
-
-            // Deserialize the buffer length, and calculate the actual number of array elements
-            uint16_t num_elements;
-            pos = cbor_num_elements(buf, &num_elements);
-            if (num_elements > array->max_elements) {
-                return 0;
-            }
-
-            for (int i = 0; i < num_elements; i++) {
-                void *data = (uint8_t *)array->elements + i * array->type_size;
-                pos += cbor_deserialize_simple_value(buf + pos, data, array->type, object->detail);
-            }
-            return pos;
+            return cbor_deserialize_array_elements(buf, array, object->detail);
         }
         default:
             return 0;
@@ -133,6 +227,65 @@ static int cbor_serialize_simple_value(uint8_t *buf, size_t size, void *data, in
     }
 }
 
+static int cbor_serialize_array_elements(uint8_t *buf, size_t size, const struct ts_array *array,
+                                         int detail)
+{
+    const size_t num_elements = array->num_elements;
+    bool is_signed = false;
+    int len = -1;
+
+#if CONFIG_THINGSET_CBOR_TYPED_ARRAYS
+    uint8_t tag = ts_bin_typed_array_tag(array);
+    if (tag != 0) {
+        return cbor_serialize_typed_array(buf, tag | CBOR_TYPED_ARRAY_NATIVE, array->elements,
+                                          num_elements, size);
+    }
+#endif
+
+    int pos = cbor_serialize_array(buf, num_elements, size);
+    if (pos == 0 || num_elements == 0) {
+        return pos;
+    }
+
+    switch (array->type) {
+        case TS_T_FLOAT32:
+            if (detail != 0) {
+                len = cbor_serialize_float_elements(&buf[pos], (const float *)array->elements,
+                                                    num_elements, size - pos);
+            }
+            break;
+        case TS_T_INT32:
+        case TS_T_INT16:
+        case TS_T_INT8:
+            is_signed = true;
+            /* fall through */
+        case TS_T_UINT32:
+        case TS_T_UINT16:
+        case TS_T_UINT8:
+            len = cbor_serialize_int_elements(&buf[pos], array->elements, array->type_size,
+                                              is_signed, num_elements, size - pos);
+            break;
+        default:
+            break;
+    }
+
+    if (len < 0) {
+        // remaining types (and floats rounded to integers) are serialized element by element
+        len = 0;
+        for (size_t i = 0; i < num_elements; i++) {
+            void *data = (uint8_t *)array->elements + i * array->type_size;
+            int num_bytes = cbor_serialize_simple_value(&buf[pos + len], size - pos - len, data,
+                                                        array->type, detail);
+            if (num_bytes == 0) {
+                return 0;
+            }
+            len += num_bytes;
+        }
+    }
+
+    return len > 0 ? pos + len : 0;
+}
+
 static int cbor_serialize_data_obj(uint8_t *buf, size_t size, const struct ts_data_object *object)
 {
     int pos = cbor_serialize_simple_value(buf, size, object->data, object->type, object->detail);
@@ -151,22 +304,41 @@ static int cbor_serialize_data_obj(uint8_t *buf, size_t size, const struct ts_da
             if (!array) {
                 return 0;
             }
-            // Add the length field to the beginning of the CBOR buffer and update the CBOR buffer
-            // index
-            pos = cbor_serialize_array(buf, array->num_elements, size);
-
-            for (int i = 0; i < array->num_elements; i++) {
-                void *data = (uint8_t *)array->elements + i * array->type_size;
-                pos += cbor_serialize_simple_value(buf + pos, size - pos, data, array->type,
-                                                   object->detail);
-            }
-            return pos;
+            return cbor_serialize_array_elements(buf, size, array, object->detail);
         }
         default:
             return 0;
     }
 }
 
+/*
+ * Serializes the value of a data object into the response, only referencing the payload of large
+ * byte strings if the response is generated with ts_process_iov.
+ */
+static int ts_bin_serialize_value(struct ts_context *ts, uint8_t *buf, size_t size,
+                                  const struct ts_data_object *object)
+{
+#if CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT
+    struct ts_iov_state *iov = &ts->iov;
+    if (object->type == TS_T_BYTES && iov->iov != NULL && iov->num_payloads < iov->max_payloads) {
+        const struct ts_bytes_buffer *bytes = (struct ts_bytes_buffer *)object->data;
+        if (bytes->num_bytes >= CONFIG_THINGSET_IOV_MIN_SIZE) {
+            int len = cbor_serialize_bytes_header(buf, bytes->num_bytes, size);
+            if (len > 0) {
+                struct ts_iovec *seg = &iov->iov[2 * iov->num_payloads];
+                seg[0].base = NULL;
+                seg[0].len = &buf[len] - ts->resp;
+                seg[1].base = bytes->bytes;
+                seg[1].len = bytes->num_bytes;
+                iov->num_payloads++;
+            }
+            return len;
+        }
+    }
+#endif
+    return cbor_serialize_data_obj(buf, size, object);
+}
+
 int ts_bin_response(struct ts_context *ts, uint8_t code)
 {
     if (ts->resp_size > 0) {
@@ -325,7 +497,7 @@ int ts_bin_fetch(struct ts_context *ts, const struct ts_data_object *endpoint, u
         if ((ret_type & TS_RET_DISCOVERY) == 0) {
             // "normal" request to fetch values
             num_bytes =
-                cbor_serialize_data_obj(&ts->resp[pos_resp], ts->resp_size - pos_resp, data_obj);
+                ts_bin_serialize_value(ts, &ts->resp[pos_resp], ts->resp_size - pos_resp, data_obj);
         }
         else if (ret_type & TS_RET_PATHS) {
             // request to determine paths from IDs
@@ -381,6 +553,54 @@ int ts_bin_import_record(struct ts_context *ts, const uint8_t *data, size_t len,
     return ts->resp[0];
 }
 
+/*
+ * Checks if the data object may be updated by a PATCH request.
+ *
+ * Returns 0 if the update is allowed or the ThingSet status code to be sent otherwise.
+ */
+static uint8_t ts_bin_patch_check(const struct ts_data_object *endpoint,
+                                  const struct ts_data_object *object, uint8_t auth_flags)
+{
+    uint8_t access =
+        (endpoint && endpoint->type == TS_T_RECORDS) ? endpoint->access : object->access;
+    if ((access & TS_WRITE_MASK & auth_flags) == 0) {
+        if (access & TS_WRITE_MASK) {
+            return TS_STATUS_UNAUTHORIZED;
+        }
+        else {
+            return TS_STATUS_FORBIDDEN;
+        }
+    }
+    else if (endpoint && object->parent != endpoint->id) {
+        return TS_STATUS_NOT_FOUND;
+    }
+    return 0;
+}
+
+/*
+ * Deserializes the value of a PATCH request into the data object (or the record item).
+ *
+ * Returns the number of bytes read from the buffer or 0 in case of error.
+ */
+static int ts_bin_patch_value(const uint8_t *buf, const struct ts_data_object *endpoint,
+                              const struct ts_data_object *object, int record_index)
+{
+    if (endpoint && endpoint->type == TS_T_RECORDS) {
+        struct ts_records *records = (struct ts_records *)endpoint->data;
+        void *data = (uint8_t *)records->data + record_index * records->record_size
+                     + (ptrdiff_t)object->data;
+
+        struct ts_data_object obj_tmp = { .data = data,
+                                          .type = object->type,
+                                          .detail = object->detail };
+
+        return cbor_deserialize_data_obj(buf, &obj_tmp);
+    }
+    else {
+        return cbor_deserialize_data_obj(buf, object);
+    }
+}
+
 int ts_bin_patch(struct ts_context *ts, const struct ts_data_object *endpoint,
                  unsigned int pos_payload, uint8_t auth_flags, uint16_t subsets, int record_index)
 {
@@ -410,18 +630,9 @@ int ts_bin_patch(struct ts_context *ts, const struct ts_data_object *endpoint,
 
         const struct ts_data_object *object = ts_get_object_by_id(ts, id);
         if (object) {
-            uint8_t access =
-                (endpoint && endpoint->type == TS_T_RECORDS) ? endpoint->access : object->access;
-            if ((access & TS_WRITE_MASK & auth_flags) == 0) {
-                if (access & TS_WRITE_MASK) {
-                    return ts_bin_response(ts, TS_STATUS_UNAUTHORIZED);
-                }
-                else {
-                    return ts_bin_response(ts, TS_STATUS_FORBIDDEN);
-                }
-            }
-            else if (endpoint && object->parent != endpoint->id) {
-                return ts_bin_response(ts, TS_STATUS_NOT_FOUND);
+            uint8_t status = ts_bin_patch_check(endpoint, object, auth_flags);
+            if (status != 0) {
+                return ts_bin_response(ts, status);
             }
             else if (subsets && !(object->subsets & subsets)) {
                 // ignore element
@@ -429,22 +640,9 @@ int ts_bin_patch(struct ts_context *ts, const struct ts_data_object *endpoint,
             }
             else {
                 // actually deserialize the data and update object
-                if (endpoint && endpoint->type == TS_T_RECORDS) {
-                    struct ts_records *records = (struct ts_records *)endpoint->data;
-                    void *data = (uint8_t *)records->data + record_index * records->record_size
-                                 + (ptrdiff_t)object->data;
-
-                    struct ts_data_object obj_tmp = { .data = data,
-                                                      .type = object->type,
-                                                      .detail = object->detail };
-
-                    num_bytes = cbor_deserialize_data_obj(&ts->req[pos_req], &obj_tmp);
-                }
-                else {
-                    num_bytes = cbor_deserialize_data_obj(&ts->req[pos_req], object);
-                }
+                num_bytes = ts_bin_patch_value(&ts->req[pos_req], endpoint, object, record_index);
 
-                if (ts->_update_subsets & object->subsets) {
+                if (ts_owner(ts)->_update_subsets & object->subsets) {
                     updated = true;
                 }
             }
@@ -469,8 +667,8 @@ int ts_bin_patch(struct ts_context *ts, const struct ts_data_object *endpoint,
     }
 
     if (element == num_elements) {
-        if (updated && ts->update_cb != NULL) {
-            ts->update_cb();
+        if (updated && ts_owner(ts)->update_cb != NULL) {
+            ts_owner(ts)->update_cb();
         }
         return ts_bin_response(ts, TS_STATUS_CHANGED);
     }
@@ -480,6 +678,242 @@ int ts_bin_patch(struct ts_context *ts, const struct ts_data_object *endpoint,
     }
 }
 
+/* parts of a PATCH request expected next by the stream parser */
+enum
+{
+    TS_PATCH_STREAM_FUNCTION = 0,
+    TS_PATCH_STREAM_REQUEST_ID,
+    TS_PATCH_STREAM_ENDPOINT,
+    TS_PATCH_STREAM_MAP,
+    TS_PATCH_STREAM_KEY,
+    TS_PATCH_STREAM_VALUE,
+    TS_PATCH_STREAM_DONE,
+};
+
+void ts_bin_patch_stream_begin(struct ts_patch_stream *stream)
+{
+    memset(stream, 0, sizeof(*stream));
+}
+
+/*
+ * Finishes the request with the given status code and returns the length of the response.
+ */
+static int ts_bin_patch_stream_finish(struct ts_context *ts, struct ts_patch_stream *stream,
+                                      uint8_t status)
+{
+    stream->state = TS_PATCH_STREAM_DONE;
+
+    if (status == TS_STATUS_CHANGED) {
+        if (stream->updated && ts_owner(ts)->update_cb != NULL) {
+            ts_owner(ts)->update_cb();
+        }
+
+        // check if endpoint has a callback assigned (same as for ts_process)
+        if (stream->endpoint->type == TS_T_GROUP && stream->endpoint->data != NULL) {
+            void (*fun)(void) = (void (*)(void))stream->endpoint->data;
+            fun();
+        }
+    }
+
+    if (stream->has_id) {
+        // same prefix as added by ts_process for requests with ID
+        uint8_t *response = ts->resp;
+        size_t response_size = ts->resp_size;
+        int prefix_len = ts_request_id_serialize(response, response_size, stream->id, true);
+        if (prefix_len == 0) {
+            return 0;
+        }
+        ts->resp = response + prefix_len;
+        ts->resp_size = response_size - prefix_len;
+        int len = ts_bin_response(ts, status);
+        ts->resp = response;
+        ts->resp_size = response_size;
+        return len > 0 ? prefix_len + len : 0;
+    }
+
+    return ts_bin_response(ts, status);
+}
+
+/*
+ * Processes a complete CBOR data item (or the head of the map) stored in the stream buffer.
+ *
+ * Returns the number of bytes consumed or 0 if the request was finished (incl. errors).
+ */
+static int ts_bin_patch_stream_item(struct ts_context *ts, struct ts_patch_stream *stream,
+                                    size_t size, int *resp_len)
+{
+    const uint8_t *buf = stream->buf;
+
+    switch (stream->state) {
+        case TS_PATCH_STREAM_FUNCTION:
+            // size is 1 in this case
+            if (buf[0] == TS_REQUEST_ID && !stream->has_id) {
+                stream->state = TS_PATCH_STREAM_REQUEST_ID;
+                return size;
+            }
+            else if (buf[0] != TS_PATCH) {
+                *resp_len = ts_bin_patch_stream_finish(ts, stream, TS_STATUS_BAD_REQUEST);
+                return 0;
+            }
+            stream->state = TS_PATCH_STREAM_ENDPOINT;
+            return size;
+        case TS_PATCH_STREAM_REQUEST_ID:
+            if ((buf[0] & CBOR_TYPE_MASK) != CBOR_UINT
+                || cbor_deserialize_uint32(buf, &stream->id) != size)
+            {
+                *resp_len = ts_bin_patch_stream_finish(ts, stream, TS_STATUS_BAD_REQUEST);
+                return 0;
+            }
+            stream->has_id = true;
+            stream->state = TS_PATCH_STREAM_FUNCTION;
+            return size;
+        case TS_PATCH_STREAM_ENDPOINT: {
+            const struct ts_data_object *endpoint = NULL;
+            if ((buf[0] & CBOR_TYPE_MASK) == CBOR_TEXT) {
+                char *str_start;
+                uint16_t str_len;
+                cbor_deserialize_string_zero_copy(buf, &str_start, &str_len);
+                endpoint = ts_get_object_by_path(ts, str_start, str_len);
+            }
+            else if ((buf[0] & CBOR_TYPE_MASK) == CBOR_UINT) {
+                ts_object_id_t id = 0;
+                if (cbor_deserialize_uint16(buf, &id) > 0) {
+                    endpoint = ts_get_object_by_id(ts, id);
+                }
+            }
+
+            if (endpoint == NULL) {
+                *resp_len = ts_bin_patch_stream_finish(ts, stream, TS_STATUS_BAD_REQUEST);
+                return 0;
+            }
+
+            // records can't be updated like this (see ts_bin_process)
+            struct ts_data_object *parent = ts_get_object_by_id(ts, endpoint->parent);
+            if (parent != NULL && parent->type == TS_T_RECORDS) {
+                *resp_len = ts_bin_patch_stream_finish(ts, stream, TS_STATUS_NOT_FOUND);
+                return 0;
+            }
+
+            stream->endpoint = endpoint;
+            stream->state = TS_PATCH_STREAM_MAP;
+            return size;
+        }
+        case TS_PATCH_STREAM_MAP:
+            // size is the head length in this case
+            cbor_num_elements(buf, &stream->num_elements);
+            if (stream->num_elements == 0) {
+                *resp_len = ts_bin_patch_stream_finish(ts, stream, TS_STATUS_CHANGED);
+                return 0;
+            }
+            stream->state = TS_PATCH_STREAM_KEY;
+            return size;
+        case TS_PATCH_STREAM_KEY: {
+            ts_object_id_t id;
+            if (cbor_deserialize_uint16(buf, &id) == 0) {
+                *resp_len = ts_bin_patch_stream_finish(ts, stream, TS_STATUS_BAD_REQUEST);
+                return 0;
+            }
+
+            // validate the object before its value is received
+            const struct ts_data_object *object = ts_get_object_by_id(ts, id);
+            uint8_t status = object ? ts_bin_patch_check(stream->endpoint, object, ts->_auth_flags)
+                                    : TS_STATUS_NOT_FOUND;
+            if (status != 0) {
+                *resp_len = ts_bin_patch_stream_finish(ts, stream, status);
+                return 0;
+            }
+
+            stream->object = object;
+            stream->state = TS_PATCH_STREAM_VALUE;
+            return size;
+        }
+        case TS_PATCH_STREAM_VALUE:
+            if (ts_bin_patch_value(buf, stream->endpoint, stream->object, 0) == 0) {
+                *resp_len = ts_bin_patch_stream_finish(ts, stream, TS_STATUS_BAD_REQUEST);
+                return 0;
+            }
+
+            if (ts_owner(ts)->_update_subsets & stream->object->subsets) {
+                stream->updated = true;
+            }
+
+            if (++stream->element == stream->num_elements) {
+                *resp_len = ts_bin_patch_stream_finish(ts, stream, TS_STATUS_CHANGED);
+                return 0;
+            }
+            stream->state = TS_PATCH_STREAM_KEY;
+            return size;
+        default:
+            return 0;
+    }
+}
+
+int ts_bin_patch_stream_push(struct ts_context *ts, struct ts_patch_stream *stream,
+                             const uint8_t *data, size_t len, uint8_t *response,
+                             size_t response_size)
+{
+    size_t pos = 0;
+    int resp_len = 0;
+
+    if (stream->state == TS_PATCH_STREAM_DONE) {
+        return 0;
+    }
+
+    ts->resp = response;
+    ts->resp_size = response_size;
+
+    while (pos < len) {
+        // append as much of the fragment as possible to the incomplete data item
+        size_t num_bytes = len - pos;
+        if (num_bytes > sizeof(stream->buf) - stream->buf_len) {
+            num_bytes = sizeof(stream->buf) - stream->buf_len;
+        }
+        memcpy(&stream->buf[stream->buf_len], &data[pos], num_bytes);
+        stream->buf_len += num_bytes;
+        pos += num_bytes;
+
+        // process all complete data items in the buffer
+        while (stream->buf_len > 0) {
+            int size;
+            if (stream->state == TS_PATCH_STREAM_FUNCTION) {
+                size = 1;
+            }
+            else if (stream->state == TS_PATCH_STREAM_MAP) {
+                // only the head of the map is processed at once
+                uint8_t info = stream->buf[0] & CBOR_INFO_MASK;
+                if ((stream->buf[0] & CBOR_TYPE_MASK) != CBOR_MAP || info > CBOR_UINT16_FOLLOWS) {
+                    return ts_bin_patch_stream_finish(ts, stream, TS_STATUS_BAD_REQUEST);
+                }
+                size = info <= CBOR_NUM_MAX ? 1 : 1 + (1U << (info - CBOR_UINT8_FOLLOWS));
+            }
+            else {
+                size = cbor_item_size(stream->buf, stream->buf_len);
+                if (size < 0) {
+                    return ts_bin_patch_stream_finish(ts, stream, TS_STATUS_BAD_REQUEST);
+                }
+            }
+
+            if (size == 0 || size > stream->buf_len) {
+                if (size > (int)sizeof(stream->buf)
+                    || (size == 0 && stream->buf_len == sizeof(stream->buf)))
+                {
+                    return ts_bin_patch_stream_finish(ts, stream, TS_STATUS_REQUEST_TOO_LARGE);
+                }
+                break; // wait for more data
+            }
+
+            if (ts_bin_patch_stream_item(ts, stream, size, &resp_len) == 0) {
+                return resp_len;
+            }
+
+            stream->buf_len -= size;
+            memmove(stream->buf, &stream->buf[size], stream->buf_len);
+        }
+    }
+
+    return 0;
+}
+
 int ts_bin_exec(struct ts_context *ts, const struct ts_data_object *object,
                 unsigned int pos_payload)
 {
@@ -501,20 +935,20 @@ int ts_bin_exec(struct ts_context *ts, const struct ts_data_object *object,
         return ts_bin_response(ts, TS_STATUS_FORBIDDEN);
     }
 
-    for (unsigned int i = 0; i < ts->num_objects; i++) {
-        if (ts->data_objects[i].parent == object->id) {
-            if (element >= num_elements) {
-                // more child objects found than parameters were passed
-                return ts_bin_response(ts, TS_STATUS_BAD_REQUEST);
-            }
-            int num_bytes = cbor_deserialize_data_obj(&ts->req[pos_req], &ts->data_objects[i]);
-            if (num_bytes == 0) {
-                // deserializing the value was not successful
-                return ts_bin_response(ts, TS_STATUS_UNSUPPORTED_FORMAT);
-            }
-            pos_req += num_bytes;
-            element++;
+    struct ts_data_object *child;
+    unsigned int iter = 0;
+    while ((child = ts_get_next_child(ts, object->id, &iter)) != NULL) {
+        if (element >= num_elements) {
+            // more child objects found than parameters were passed
+            return ts_bin_response(ts, TS_STATUS_BAD_REQUEST);
         }
+        int num_bytes = cbor_deserialize_data_obj(&ts->req[pos_req], child);
+        if (num_bytes == 0) {
+            // deserializing the value was not successful
+            return ts_bin_response(ts, TS_STATUS_UNSUPPORTED_FORMAT);
+        }
+        pos_req += num_bytes;
+        element++;
     }
 
     if (num_elements > element) {
@@ -529,8 +963,48 @@ int ts_bin_exec(struct ts_context *ts, const struct ts_data_object *object,
     return ts_bin_response(ts, TS_STATUS_VALID);
 }
 
-int ts_bin_statement(struct ts_context *ts, uint8_t *buf, size_t buf_size,
-                     struct ts_data_object *object)
+/*
+ * Arrays and maps with a number of elements not known in advance are serialized in a single
+ * pass. Depending on the configuration, either indefinite-length containers are used or the
+ * reserved header is updated after all elements were serialized.
+ */
+static int ts_bin_container_start(uint8_t *buf, uint8_t type, size_t max_len)
+{
+#if CONFIG_THINGSET_CBOR_INDEFINITE_LENGTH
+    return type == CBOR_MAP ? cbor_serialize_map_indefinite(buf, max_len)
+                            : cbor_serialize_array_indefinite(buf, max_len);
+#else
+    return type == CBOR_MAP ? cbor_serialize_map_start(buf, max_len)
+                            : cbor_serialize_array_start(buf, max_len);
+#endif
+}
+
+/* returns the total length of the container starting at buf or 0 in case of error */
+static int ts_bin_container_end(struct ts_context *ts, uint8_t *buf, size_t len,
+                                size_t num_elements, size_t max_len)
+{
+#if CONFIG_THINGSET_CBOR_INDEFINITE_LENGTH
+    int num_bytes = cbor_serialize_break(&buf[len], max_len - len);
+    return num_bytes > 0 ? len + num_bytes : 0;
+#else
+    int num_bytes = cbor_serialize_container_end(buf, len, num_elements);
+    if (num_bytes > 0 && (size_t)num_bytes < len && ts->iov.iov != NULL && buf >= ts->resp
+        && buf < ts->resp + ts->resp_size)
+    {
+        // elements were moved to the shorter header, so the referenced payloads moved as well
+        for (size_t i = 0; i < ts->iov.num_payloads; i++) {
+            struct ts_iovec *seg = &ts->iov.iov[2 * i];
+            if (seg->len > (size_t)(buf - ts->resp)) {
+                seg->len -= len - num_bytes;
+            }
+        }
+    }
+    return num_bytes;
+#endif
+}
+
+static int ts_bin_statement_elements(struct ts_context *ts, uint8_t *buf, size_t buf_size,
+                                     struct ts_data_object *object)
 {
     buf[0] = TS_STATEMENT;
     int len = 1;
@@ -539,65 +1013,73 @@ int ts_bin_statement(struct ts_context *ts, uint8_t *buf, size_t buf_size,
         // currently only supporting top level objects
         return 0;
     }
+    else if (object->type != TS_T_SUBSET && object->type != TS_T_GROUP) {
+        return 0;
+    }
 
     // serialize endpoint
     len += cbor_serialize_uint(&buf[len], object->id, buf_size - len);
 
-    if (object->type == TS_T_SUBSET) {
-        uint16_t subsets = object->detail;
-
-        // find out number of elements to be serialized
-        int num_ids = 0;
-        for (unsigned int i = 0; i < ts->num_objects; i++) {
-            if (ts->data_objects[i].subsets & subsets) {
-                num_ids++;
-            }
+    // number of elements is not known in advance, so the array header is updated at the end
+    int start = len;
+    int num_elements = 0;
+    int num_bytes = ts_bin_container_start(&buf[len], CBOR_ARRAY, buf_size - len);
+    if (num_bytes == 0) {
+        return 0;
+    }
+    len += num_bytes;
+
+    struct ts_data_object *element;
+    struct ts_member_iter member_iter = { 0 };
+    unsigned int child_iter = 0;
+    while (true) {
+        if (object->type == TS_T_SUBSET) {
+            element = ts_get_next_member_value(ts, object->detail, &member_iter);
+        }
+        else {
+            element = ts_get_next_child(ts, object->id, &child_iter);
+        }
+        if (element == NULL) {
+            break;
         }
 
-        len += cbor_serialize_array(&buf[len], num_ids, buf_size - len);
-
-        for (unsigned int i = 0; i < ts->num_objects; i++) {
-            if (ts->data_objects[i].subsets & subsets) {
-                size_t num_bytes =
-                    cbor_serialize_data_obj(&buf[len], buf_size - len, &ts->data_objects[i]);
-                if (num_bytes == 0) {
-                    return 0;
-                }
-                else {
-                    len += num_bytes;
-                }
-            }
+        num_bytes = cbor_serialize_data_obj(&buf[len], buf_size - len, element);
+        if (num_bytes == 0) {
+            return 0;
         }
+        len += num_bytes;
+        num_elements++;
     }
-    else if (object->type == TS_T_GROUP) {
-        // find out number of elements to be serialized
-        int num_ids = 0;
-        for (unsigned int i = 0; i < ts->num_objects; i++) {
-            if (ts->data_objects[i].parent == object->id) {
-                num_ids++;
-            }
-        }
 
-        len += cbor_serialize_array(&buf[len], num_ids, buf_size - len);
+    num_bytes =
+        ts_bin_container_end(ts, &buf[start], len - start, num_elements, buf_size - start);
+    if (num_bytes == 0) {
+        return 0;
+    }
 
-        for (unsigned int i = 0; i < ts->num_objects; i++) {
-            if (ts->data_objects[i].parent == object->id) {
-                size_t num_bytes =
-                    cbor_serialize_data_obj(&buf[len], buf_size - len, &ts->data_objects[i]);
-                if (num_bytes == 0) {
-                    return 0;
-                }
-                else {
-                    len += num_bytes;
+    return start + num_bytes;
+}
+
+int ts_bin_statement(struct ts_context *ts, uint8_t *buf, size_t buf_size,
+                     struct ts_data_object *object)
+{
+#if CONFIG_THINGSET_SEQLOCK
+    // captured values are a stable snapshot, which is not changed by the writers
+    if (object && object->type == TS_T_SUBSET && ts->capture.values == NULL) {
+        const uint16_t subsets = object->detail;
+        for (int i = 0; i <= CONFIG_THINGSET_SEQLOCK_RETRIES; i++) {
+            uint32_t seq;
+            if (ts_seqlock_read_begin(ts, subsets, &seq)) {
+                int len = ts_bin_statement_elements(ts, buf, buf_size, object);
+                if (!ts_seqlock_read_retry(ts, subsets, seq)) {
+                    return len;
                 }
             }
         }
-    }
-    else {
         return 0;
     }
-
-    return len;
+#endif
+    return ts_bin_statement_elements(ts, buf, buf_size, object);
 }
 
 int ts_bin_statement_by_path(struct ts_context *ts, uint8_t *buf, size_t buf_size, const char *path)
@@ -610,54 +1092,72 @@ int ts_bin_statement_by_id(struct ts_context *ts, uint8_t *buf, size_t buf_size,
     return ts_bin_statement(ts, buf, buf_size, ts_get_object_by_id(ts, id));
 }
 
-int ts_bin_export(struct ts_context *ts, uint8_t *buf, size_t buf_size, uint16_t subsets)
+static int ts_bin_export_members(struct ts_context *ts, uint8_t *buf, size_t buf_size,
+                                 uint16_t subsets)
 {
-    // find out number of elements to be serialized
-    int num_ids = 0;
-    for (unsigned int i = 0; i < ts->num_objects; i++) {
-        if (ts->data_objects[i].subsets & subsets) {
-            num_ids++;
+    struct ts_data_object *member;
+    struct ts_member_iter iter = { 0 };
+    int num_elements = 0;
+
+    // always with definite length, as ts_bin_import does not support indefinite-length maps
+    int len = cbor_serialize_map_start(buf, buf_size);
+    if (len == 0) {
+        return 0;
+    }
+
+    while ((member = ts_get_next_member_value(ts, subsets, &iter)) != NULL) {
+        len += cbor_serialize_uint(&buf[len], member->id, buf_size - len);
+        size_t num_bytes = cbor_serialize_data_obj(&buf[len], buf_size - len, member);
+        if (num_bytes == 0) {
+            return 0;
+        }
+        else {
+            len += num_bytes;
         }
+        num_elements++;
     }
 
-    int len = cbor_serialize_map(buf, num_ids, buf_size);
+    return cbor_serialize_container_end(buf, len, num_elements);
+}
 
-    for (unsigned int i = 0; i < ts->num_objects; i++) {
-        if (ts->data_objects[i].subsets & subsets) {
-            len += cbor_serialize_uint(&buf[len], ts->data_objects[i].id, buf_size - len);
-            size_t num_bytes =
-                cbor_serialize_data_obj(&buf[len], buf_size - len, &ts->data_objects[i]);
-            if (num_bytes == 0) {
-                return 0;
-            }
-            else {
-                len += num_bytes;
+int ts_bin_export(struct ts_context *ts, uint8_t *buf, size_t buf_size, uint16_t subsets)
+{
+#if CONFIG_THINGSET_SEQLOCK
+    for (int i = 0; i <= CONFIG_THINGSET_SEQLOCK_RETRIES; i++) {
+        uint32_t seq;
+        if (ts_seqlock_read_begin(ts, subsets, &seq)) {
+            int len = ts_bin_export_members(ts, buf, buf_size, subsets);
+            if (!ts_seqlock_read_retry(ts, subsets, seq)) {
+                return len;
             }
         }
     }
-
-    return len;
+    return 0;
+#else
+    return ts_bin_export_members(ts, buf, buf_size, subsets);
+#endif
 }
 
-int ts_bin_pub_can(struct ts_context *ts, int *start_pos, uint16_t subset, uint8_t can_dev_id,
-                   uint32_t *msg_id, uint8_t *msg_data)
+static int ts_bin_pub_can_frame(struct ts_context *ts, int *start_pos, uint16_t subset,
+                                uint32_t prio, uint8_t can_dev_id, uint32_t *msg_id,
+                                uint8_t *msg_data)
 {
+    struct ts_data_object *member;
+    struct ts_member_iter iter = { .pos = *start_pos };
     int msg_len = -1;
 
-    for (unsigned int i = *start_pos; i < ts->num_objects; i++) {
-        if (ts->data_objects[i].subsets & subset) {
-            *msg_id = TS_CAN_TYPE_PUBSUB | TS_CAN_PRIO_PUBSUB_LOW
-                      | TS_CAN_DATA_ID_SET(ts->data_objects[i].id) | TS_CAN_SOURCE_SET(can_dev_id);
+    while ((member = ts_get_next_member(ts, subset, &iter)) != NULL) {
+        *msg_id = TS_CAN_TYPE_PUBSUB | prio | TS_CAN_DATA_ID_SET(member->id)
+                  | TS_CAN_SOURCE_SET(can_dev_id);
 
-            msg_len = cbor_serialize_data_obj(msg_data, 8, &ts->data_objects[i]);
+        msg_len = cbor_serialize_data_obj(msg_data, 8, member);
 
-            if (msg_len > 0) {
-                // object found and successfully encoded, increase start pos for next run
-                *start_pos = i + 1;
-                break;
-            }
-            // else: data too long, take next object
+        if (msg_len > 0) {
+            // object found and successfully encoded, iterator points to next position already
+            *start_pos = iter.pos;
+            break;
         }
+        // else: data too long, take next object
     }
 
     if (msg_len <= 0) {
@@ -668,6 +1168,414 @@ int ts_bin_pub_can(struct ts_context *ts, int *start_pos, uint16_t subset, uint8
     return msg_len;
 }
 
+int ts_bin_pub_can(struct ts_context *ts, int *start_pos, uint16_t subset, uint8_t can_dev_id,
+                   uint32_t *msg_id, uint8_t *msg_data)
+{
+    return ts_bin_pub_can_frame(ts, start_pos, subset, TS_CAN_PRIO_PUBSUB_LOW, can_dev_id, msg_id,
+                                msg_data);
+}
+
+void ts_can_sched_init(struct ts_can_sched *sched, struct ts_can_sched_entry *entries,
+                       size_t num_entries, uint8_t can_dev_id, uint32_t now_ms)
+{
+    sched->entries = entries;
+    sched->num_entries = num_entries;
+    sched->can_dev_id = can_dev_id;
+
+    for (size_t i = 0; i < num_entries; i++) {
+        entries[i].next_ms = now_ms;
+        entries[i].due_ms = now_ms;
+        entries[i].pos = 0;
+        entries[i].pending = false;
+        entries[i].started = false;
+        entries[i].max_jitter_ms = 0;
+        entries[i].overruns = 0;
+        entries[i].count = 0;
+    }
+}
+
+/* marks entries as pending if their period elapsed */
+static void ts_can_sched_update(struct ts_can_sched *sched, uint32_t now_ms)
+{
+    for (size_t i = 0; i < sched->num_entries; i++) {
+        struct ts_can_sched_entry *entry = &sched->entries[i];
+        if (entry->period_ms == 0 || (int32_t)(now_ms - entry->next_ms) < 0) {
+            continue;
+        }
+
+        if (entry->pending) {
+            // previous publication not finished within its period
+            entry->overruns++;
+        }
+        else {
+            entry->pending = true;
+            entry->started = false;
+            entry->pos = 0;
+            entry->due_ms = entry->next_ms;
+        }
+
+        entry->next_ms += entry->period_ms;
+        if ((int32_t)(now_ms - entry->next_ms) >= 0) {
+            // at least one period was missed completely
+            entry->overruns++;
+            entry->next_ms = now_ms + entry->period_ms;
+        }
+    }
+}
+
+int ts_can_sched_next(struct ts_context *ts, struct ts_can_sched *sched, uint32_t now_ms,
+                      uint32_t *msg_id, uint8_t *msg_data)
+{
+    ts_can_sched_update(sched, now_ms);
+
+    while (true) {
+        // pending entry with highest priority (lowest value), the oldest one first
+        struct ts_can_sched_entry *next = NULL;
+        for (size_t i = 0; i < sched->num_entries; i++) {
+            struct ts_can_sched_entry *entry = &sched->entries[i];
+            if (entry->pending
+                && (next == NULL || entry->prio < next->prio
+                    || (entry->prio == next->prio && (int32_t)(entry->due_ms - next->due_ms) < 0)))
+            {
+                next = entry;
+            }
+        }
+
+        if (next == NULL) {
+            return 0;
+        }
+
+        int len = ts_bin_pub_can_frame(ts, &next->pos, next->subsets, next->prio,
+                                       sched->can_dev_id, msg_id, msg_data);
+        if (len > 0) {
+            if (!next->started) {
+                uint32_t jitter = now_ms - next->due_ms;
+                if (jitter > next->max_jitter_ms) {
+                    next->max_jitter_ms = jitter;
+                }
+                next->started = true;
+            }
+            return len;
+        }
+
+        // all objects of the entry published
+        next->pending = false;
+        next->count++;
+    }
+}
+
+int ts_bin_pub_can_packed_begin(struct ts_context *ts, struct ts_can_pub_stream *stream,
+                                uint16_t subsets, uint8_t can_dev_id, uint8_t frame_size)
+{
+    if (frame_size < 8 || frame_size > 64 || (frame_size > 24 && frame_size % 16 != 0)
+        || frame_size % 4 != 0)
+    {
+        return -EINVAL;
+    }
+
+    stream->buf_len = 0;
+    stream->buf_pos = 0;
+    stream->pos = 0;
+    stream->item = NULL;
+    stream->item_pos = 0;
+    stream->subsets = subsets;
+    stream->can_dev_id = can_dev_id;
+    stream->frame_size = frame_size;
+    stream->msg_num = (stream->msg_num + 1) & 0x3;
+    stream->seq = 0;
+    stream->first = true;
+    stream->active = true;
+
+    return 0;
+}
+
+/*
+ * Part of the encoded ID/value pair stored in the stream buffer. Bytes before skip were already
+ * stored in the buffer previously, bytes behind the end of the buffer are only counted.
+ */
+struct ts_can_pub_window
+{
+    uint8_t *buf;
+    size_t size;
+    size_t skip;
+    size_t len;
+    size_t total;
+};
+
+static void ts_can_pub_window_put(struct ts_can_pub_window *w, const void *data, size_t num_bytes)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    const size_t start = w->total;
+
+    w->total += num_bytes;
+    if (w->total <= w->skip) {
+        return;
+    }
+    else if (start < w->skip) {
+        bytes += w->skip - start;
+        num_bytes -= w->skip - start;
+    }
+
+    if (num_bytes > w->size - w->len) {
+        num_bytes = w->size - w->len;
+    }
+    memcpy(&w->buf[w->len], bytes, num_bytes);
+    w->len += num_bytes;
+}
+
+/*
+ * Encodes ID and value of a data object piece by piece, so that data objects larger than the
+ * stream buffer can be published in multiple parts. The output is the same as for
+ * cbor_serialize_data_obj.
+ */
+static int ts_bin_pub_can_encode(const struct ts_data_object *object, struct ts_can_pub_window *w)
+{
+    uint8_t tmp[16]; // large enough for any simple value and CBOR heads
+    int len;
+
+    len = cbor_serialize_uint(tmp, object->id, sizeof(tmp));
+    ts_can_pub_window_put(w, tmp, len);
+
+    switch (object->type) {
+        case TS_T_STRING: {
+            const size_t str_len = strlen((const char *)object->data);
+            len = cbor_serialize_bytes_header(tmp, str_len, sizeof(tmp));
+            if (len == 0) {
+                return -EINVAL;
+            }
+            tmp[0] = CBOR_TEXT | (tmp[0] & CBOR_INFO_MASK);
+            ts_can_pub_window_put(w, tmp, len);
+            ts_can_pub_window_put(w, object->data, str_len);
+            return 0;
+        }
+#if CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT
+        case TS_T_BYTES: {
+            const struct ts_bytes_buffer *bytes = (struct ts_bytes_buffer *)object->data;
+            len = cbor_serialize_bytes_header(tmp, bytes->num_bytes, sizeof(tmp));
+            if (len == 0) {
+                return -EINVAL;
+            }
+            ts_can_pub_window_put(w, tmp, len);
+            ts_can_pub_window_put(w, bytes->bytes, bytes->num_bytes);
+            return 0;
+        }
+#endif
+        case TS_T_ARRAY: {
+            const struct ts_array *array = (struct ts_array *)object->data;
+            if (!array) {
+                return -EINVAL;
+            }
+#if CONFIG_THINGSET_CBOR_TYPED_ARRAYS
+            uint8_t tag = ts_bin_typed_array_tag(array);
+            if (tag != 0) {
+                // typed array head without elements, followed by the raw elements
+                const size_t num_bytes = array->num_elements * array->type_size;
+                len = cbor_serialize_typed_array(tmp, tag | CBOR_TYPED_ARRAY_NATIVE,
+                                                 array->elements, 0, sizeof(tmp));
+                ts_can_pub_window_put(w, tmp, len - 1);
+                len = cbor_serialize_bytes_header(tmp, num_bytes, sizeof(tmp));
+                if (len == 0) {
+                    return -EINVAL;
+                }
+                ts_can_pub_window_put(w, tmp, len);
+                ts_can_pub_window_put(w, array->elements, num_bytes);
+                return 0;
+            }
+#endif
+            len = cbor_serialize_array(tmp, array->num_elements, sizeof(tmp));
+            ts_can_pub_window_put(w, tmp, len);
+            for (size_t i = 0; i < array->num_elements; i++) {
+                void *data = (uint8_t *)array->elements + i * array->type_size;
+                len = cbor_serialize_simple_value(tmp, sizeof(tmp), data, array->type,
+                                                  object->detail);
+                if (len == 0) {
+                    return -EINVAL;
+                }
+                ts_can_pub_window_put(w, tmp, len);
+            }
+            return 0;
+        }
+        default:
+            len = cbor_serialize_simple_value(tmp, sizeof(tmp), object->data, object->type,
+                                              object->detail);
+            if (len == 0) {
+                return -EINVAL;
+            }
+            ts_can_pub_window_put(w, tmp, len);
+            return 0;
+    }
+}
+
+/*
+ * Stores the next part of the current data object or the beginning of the next member in the
+ * stream buffer.
+ *
+ * Returns 1 if data was stored, 0 if all members were published or a negative error code.
+ */
+static int ts_bin_pub_can_next_item(struct ts_context *ts, struct ts_can_pub_stream *stream)
+{
+    struct ts_can_pub_window w = { .buf = stream->buf, .size = sizeof(stream->buf) };
+
+    if (stream->item == NULL) {
+        struct ts_member_iter iter = { .pos = stream->pos };
+        stream->item = ts_get_next_member(ts, stream->subsets, &iter);
+        stream->pos = iter.pos;
+        stream->item_pos = 0;
+        if (stream->item == NULL) {
+            return 0;
+        }
+    }
+
+    w.skip = stream->item_pos;
+    int err = ts_bin_pub_can_encode(stream->item, &w);
+    if (err != 0) {
+        return err;
+    }
+
+    stream->buf_len = w.len;
+    stream->buf_pos = 0;
+    stream->item_pos += w.len;
+    if (stream->item_pos >= w.total) {
+        // data object completely stored in the buffer
+        stream->item = NULL;
+    }
+
+    return 1;
+}
+
+int ts_bin_pub_can_packed(struct ts_context *ts, struct ts_can_pub_stream *stream,
+                          uint32_t *msg_id, uint8_t *msg_data)
+{
+    size_t len = 0;
+    int ret;
+
+    if (!stream->active) {
+        return 0;
+    }
+
+    while (len < stream->frame_size) {
+        if (stream->buf_pos < stream->buf_len) {
+            size_t num_bytes = stream->buf_len - stream->buf_pos;
+            if (num_bytes > stream->frame_size - len) {
+                num_bytes = stream->frame_size - len;
+            }
+            memcpy(&msg_data[len], &stream->buf[stream->buf_pos], num_bytes);
+            stream->buf_pos += num_bytes;
+            len += num_bytes;
+        }
+        else if ((ret = ts_bin_pub_can_next_item(ts, stream)) <= 0) {
+            if (ret < 0) {
+                stream->active = false;
+                return ret;
+            }
+            break;
+        }
+    }
+
+    // check if any data is left for further frames
+    bool last = false;
+    if (stream->buf_pos >= stream->buf_len) {
+        ret = ts_bin_pub_can_next_item(ts, stream);
+        if (ret < 0) {
+            stream->active = false;
+            return ret;
+        }
+        last = (ret == 0);
+    }
+    if (last) {
+        stream->active = false;
+    }
+
+    if (len == 0) {
+        // no members found
+        return 0;
+    }
+
+    if (len > 8) {
+        // valid CAN FD lengths are 12, 16, 20, 24, 32, 48 and 64 bytes
+        size_t fd_len = (len <= 24) ? (len + 3) & ~3U : (len <= 32) ? 32 : (len <= 48) ? 48 : 64;
+        memset(&msg_data[len], CBOR_UNDEFINED, fd_len - len);
+        len = fd_len;
+    }
+
+    uint32_t type;
+    if (stream->first) {
+        type = last ? TS_CAN_PACKED_TYPE_SINGLE : TS_CAN_PACKED_TYPE_FIRST;
+    }
+    else {
+        type = last ? TS_CAN_PACKED_TYPE_LAST : TS_CAN_PACKED_TYPE_CONSEC;
+    }
+
+    *msg_id = TS_CAN_TYPE_PACKED | TS_CAN_PRIO_PUBSUB_LOW
+              | TS_CAN_PACKED_SUBSETS_SET(stream->subsets) | type
+              | TS_CAN_PACKED_MSG_SET(stream->msg_num) | TS_CAN_PACKED_SEQ_SET(stream->seq)
+              | TS_CAN_SOURCE_SET(stream->can_dev_id);
+
+    stream->seq = (stream->seq + 1) & 0xF;
+    stream->first = false;
+
+    return len;
+}
+
+/*
+ * Serializes a child object of a GET request (ID or name and/or value, depending on ret_type).
+ *
+ * Returns the number of bytes written or 0 if the buffer is too small.
+ */
+static int ts_bin_serialize_child(struct ts_context *ts, uint8_t *buf, size_t size,
+                                  const struct ts_data_object *endpoint,
+                                  const struct ts_data_object *child, uint32_t ret_type,
+                                  int record_index)
+{
+    int num_bytes = 0;
+
+    if (ret_type & TS_RET_IDS) {
+        num_bytes = cbor_serialize_uint(buf, child->id, size);
+    }
+    else if (ret_type & TS_RET_NAMES) {
+        num_bytes = cbor_serialize_string(buf, child->name, size);
+    }
+
+    if (num_bytes == 0 && (ret_type & (TS_RET_IDS | TS_RET_NAMES))) {
+        return 0;
+    }
+
+    if (ret_type & TS_RET_VALUES) {
+        int value_len;
+        if (endpoint->type == TS_T_RECORDS) {
+            struct ts_records *records = (struct ts_records *)endpoint->data;
+            void *data = (uint8_t *)records->data + record_index * records->record_size
+                         + (size_t)child->data;
+            // create temporary data object with data from struct
+            struct ts_data_object obj = {
+                .id = child->id,
+                .name = child->name,
+                .data = data,
+                .type = child->type,
+                .detail = child->detail,
+            };
+            value_len = cbor_serialize_data_obj(&buf[num_bytes], size - num_bytes, &obj);
+        }
+        else {
+            value_len = ts_bin_serialize_value(ts, &buf[num_bytes], size - num_bytes, child);
+        }
+        if (value_len == 0) {
+            // incomplete key/value pair must not be returned
+            return 0;
+        }
+        num_bytes += value_len;
+    }
+
+    return num_bytes;
+}
+
+static inline bool ts_bin_child_readable(const struct ts_data_object *endpoint,
+                                         const struct ts_data_object *child)
+{
+    uint8_t access = endpoint->type == TS_T_RECORDS ? endpoint->access : child->access;
+    return access & TS_READ_MASK;
+}
+
 int ts_bin_get(struct ts_context *ts, const struct ts_data_object *endpoint, uint32_t ret_type,
                int record_index)
 {
@@ -691,72 +1599,97 @@ int ts_bin_get(struct ts_context *ts, const struct ts_data_object *endpoint, uin
             break;
         default:
             // single data object
-            len += cbor_serialize_data_obj(&ts->resp[len], ts->resp_size - len, endpoint);
+            len += ts_bin_serialize_value(ts, &ts->resp[len], ts->resp_size - len, endpoint);
             return len;
     }
 
-    // find out number of elements
+    const uint8_t container_type = (ret_type & TS_RET_VALUES) ? CBOR_MAP : CBOR_ARRAY;
+    struct ts_data_object *child;
+    unsigned int iter = 0;
     int num_elements = 0;
-    for (unsigned int i = 0; i < ts->num_objects; i++) {
-        uint8_t access =
-            endpoint->type == TS_T_RECORDS ? endpoint->access : ts->data_objects[i].access;
-        if (access & TS_READ_MASK && (ts->data_objects[i].parent == endpoint->id)) {
-            num_elements++;
+    int num_bytes;
+
+    if (ts->chunk.active) {
+        // only serialize the container header, children follow in ts_bin_get_next
+#if CONFIG_THINGSET_CBOR_INDEFINITE_LENGTH
+        num_bytes = ts_bin_container_start(&ts->resp[len], container_type, ts->resp_size - len);
+#else
+        // header can't be updated afterwards, so the elements have to be counted first
+        while ((child = ts_get_next_child(ts, endpoint->id, &iter)) != NULL) {
+            num_elements += ts_bin_child_readable(endpoint, child);
+        }
+        num_bytes = container_type == CBOR_MAP
+                        ? cbor_serialize_map(&ts->resp[len], num_elements, ts->resp_size - len)
+                        : cbor_serialize_array(&ts->resp[len], num_elements, ts->resp_size - len);
+#endif
+        if (num_bytes == 0) {
+            return ts_bin_response(ts, TS_STATUS_RESPONSE_TOO_LARGE);
         }
+        ts->chunk.endpoint = endpoint;
+        ts->chunk.ret_type = ret_type;
+        ts->chunk.record_index = record_index;
+        ts->chunk.iter = 0;
+        ts->chunk.num_elements = 0;
+        ts->chunk.elements = true;
+        return len + num_bytes;
     }
 
-    if (ret_type & TS_RET_VALUES) {
-        len += cbor_serialize_map(&ts->resp[len], num_elements, ts->resp_size - len);
+    const unsigned int start = len;
+    num_bytes = ts_bin_container_start(&ts->resp[len], container_type, ts->resp_size - len);
+    if (num_bytes == 0) {
+        return ts_bin_response(ts, TS_STATUS_RESPONSE_TOO_LARGE);
     }
-    else {
-        len += cbor_serialize_array(&ts->resp[len], num_elements, ts->resp_size - len);
-    }
-
-    for (unsigned int i = 0; i < ts->num_objects; i++) {
-        uint8_t access =
-            endpoint->type == TS_T_RECORDS ? endpoint->access : ts->data_objects[i].access;
-        if (access & TS_READ_MASK && (ts->data_objects[i].parent == endpoint->id)) {
-            int num_bytes = 0;
-            if (ret_type & TS_RET_IDS) {
-                num_bytes = cbor_serialize_uint(&ts->resp[len], ts->data_objects[i].id,
-                                                ts->resp_size - len);
-            }
-            else if (ret_type & TS_RET_NAMES) {
-                num_bytes = cbor_serialize_string(&ts->resp[len], ts->data_objects[i].name,
-                                                  ts->resp_size - len);
-            }
-
-            if (ret_type & TS_RET_VALUES) {
-                if (endpoint->type == TS_T_RECORDS) {
-                    struct ts_records *records = (struct ts_records *)endpoint->data;
-                    void *data = (uint8_t *)records->data + record_index * records->record_size
-                                 + (size_t)ts->data_objects[i].data;
-                    // create temporary data object with data from struct
-                    struct ts_data_object obj = {
-                        .id = ts->data_objects[i].id,
-                        .name = ts->data_objects[i].name,
-                        .data = data,
-                        .type = ts->data_objects[i].type,
-                        .detail = ts->data_objects[i].detail,
-                    };
-                    num_bytes += cbor_serialize_data_obj(&ts->resp[len + num_bytes],
-                                                         ts->resp_size - len - num_bytes, &obj);
-                }
-                else {
-                    num_bytes += cbor_serialize_data_obj(&ts->resp[len + num_bytes],
-                                                         ts->resp_size - len - num_bytes,
-                                                         &ts->data_objects[i]);
-                }
-            }
+    len += num_bytes;
 
-            if (num_bytes == 0) {
-                return ts_bin_response(ts, TS_STATUS_RESPONSE_TOO_LARGE);
-            }
-            else {
-                len += num_bytes;
-            }
+    while ((child = ts_get_next_child(ts, endpoint->id, &iter)) != NULL) {
+        if (!ts_bin_child_readable(endpoint, child)) {
+            continue;
         }
+
+        num_bytes = ts_bin_serialize_child(ts, &ts->resp[len], ts->resp_size - len, endpoint,
+                                           child, ret_type, record_index);
+        if (num_bytes == 0) {
+            return ts_bin_response(ts, TS_STATUS_RESPONSE_TOO_LARGE);
+        }
+        len += num_bytes;
+        num_elements++;
     }
 
-    return len;
+    num_bytes = ts_bin_container_end(ts, &ts->resp[start], len - start, num_elements,
+                                     ts->resp_size - start);
+    if (num_bytes == 0) {
+        return ts_bin_response(ts, TS_STATUS_RESPONSE_TOO_LARGE);
+    }
+
+    return start + num_bytes;
+}
+
+int ts_bin_get_next(struct ts_context *ts)
+{
+    struct ts_chunk_state *chunk = &ts->chunk;
+    struct ts_data_object *child;
+
+    while ((child = ts_get_next_child(ts, chunk->endpoint->id, &chunk->iter)) != NULL) {
+        if (!ts_bin_child_readable(chunk->endpoint, child)) {
+            continue;
+        }
+
+        int num_bytes = ts_bin_serialize_child(ts, chunk->scratch, chunk->scratch_size,
+                                               chunk->endpoint, child, chunk->ret_type,
+                                               chunk->record_index);
+        if (num_bytes == 0) {
+            return -ENOMEM;
+        }
+        chunk->num_elements++;
+        return num_bytes;
+    }
+
+    chunk->elements = false;
+
+#if CONFIG_THINGSET_CBOR_INDEFINITE_LENGTH
+    int num_bytes = cbor_serialize_break(chunk->scratch, chunk->scratch_size);
+    return num_bytes > 0 ? num_bytes : -ENOMEM;
+#else
+    return 0;
+#endif
 }
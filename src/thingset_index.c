@@ -0,0 +1,485 @@
+/*
+ * Copyright (c) The ThingSet Project Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Lookup index to speed up searching the data objects database */
+
+#include "thingset_priv.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+typedef bool (*ts_index_less_t)(const struct ts_data_object *objs, uint16_t a, uint16_t b);
+
+static void _sift_down(const struct ts_data_object *objs, uint16_t *list, size_t root, size_t end,
+                       ts_index_less_t less)
+{
+    size_t child;
+    while ((child = 2 * root + 1) < end) {
+        if (child + 1 < end && less(objs, list[child], list[child + 1])) {
+            child++;
+        }
+        if (!less(objs, list[root], list[child])) {
+            return;
+        }
+        uint16_t tmp = list[root];
+        list[root] = list[child];
+        list[child] = tmp;
+        root = child;
+    }
+}
+
+/*
+ * Heapsort is used because it works in-place without recursion, so the stack usage does not
+ * depend on the number of data objects.
+ */
+static void _sort(const struct ts_data_object *objs, uint16_t *list, size_t num,
+                  ts_index_less_t less)
+{
+    for (size_t i = num / 2; i > 0; i--) {
+        _sift_down(objs, list, i - 1, num, less);
+    }
+    for (size_t end = num; end > 1; end--) {
+        uint16_t tmp = list[0];
+        list[0] = list[end - 1];
+        list[end - 1] = tmp;
+        _sift_down(objs, list, 0, end - 1, less);
+    }
+}
+
+#if CONFIG_THINGSET_ID_INDEX_HASH
+
+static inline size_t _id_hash(ts_object_id_t id, size_t len)
+{
+    // Fibonacci hashing spreads consecutive IDs evenly over the table
+    return (((uint32_t)id * 2654435761U) >> 16) % len;
+}
+
+static void _build_id_index(struct ts_context *ts, uint16_t *table, size_t len)
+{
+    const struct ts_data_object *objs = ts->data_objects;
+
+    memset(table, 0xFF, len * sizeof(uint16_t));
+
+    for (size_t i = 0; i < ts->num_objects; i++) {
+        size_t slot = _id_hash(objs[i].id, len);
+        while (table[slot] != TS_INDEX_EMPTY) {
+            slot = (slot + 1) % len;
+        }
+        table[slot] = i;
+    }
+}
+
+struct ts_data_object *ts_index_find_id(struct ts_context *ts, ts_object_id_t id)
+{
+    const uint16_t *table = ts->index.ids;
+    const size_t len = ts->index.ids_len;
+
+    size_t slot = _id_hash(id, len);
+    for (size_t i = 0; i < len && table[slot] != TS_INDEX_EMPTY; i++) {
+        if (ts->data_objects[table[slot]].id == id) {
+            return &ts->data_objects[table[slot]];
+        }
+        slot = (slot + 1) % len;
+    }
+    return NULL;
+}
+
+#else /* sorted table */
+
+static bool _id_less(const struct ts_data_object *objs, uint16_t a, uint16_t b)
+{
+    // position as secondary key keeps the first of duplicate IDs in front (same as linear search)
+    return objs[a].id < objs[b].id || (objs[a].id == objs[b].id && a < b);
+}
+
+static void _build_id_index(struct ts_context *ts, uint16_t *table, size_t len)
+{
+    const struct ts_data_object *objs = ts->data_objects;
+
+    for (size_t i = 0; i < len; i++) {
+        table[i] = i;
+    }
+    _sort(objs, table, len, _id_less);
+}
+
+struct ts_data_object *ts_index_find_id(struct ts_context *ts, ts_object_id_t id)
+{
+    const uint16_t *table = ts->index.ids;
+    size_t low = 0;
+    size_t high = ts->index.ids_len;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (ts->data_objects[table[mid]].id < id) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    if (low < ts->index.ids_len && ts->data_objects[table[low]].id == id) {
+        return &ts->data_objects[table[low]];
+    }
+    return NULL;
+}
+
+#endif /* CONFIG_THINGSET_ID_INDEX_HASH */
+
+/* FNV-1a hash of parent ID and name */
+static uint32_t _name_hash(ts_object_id_t parent, const char *name, size_t len)
+{
+    uint32_t hash = 2166136261U;
+
+    hash = (hash ^ (parent & 0xFF)) * 16777619U;
+    hash = (hash ^ (parent >> 8)) * 16777619U;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619U;
+    }
+    return hash;
+}
+
+static void _build_name_index(struct ts_context *ts, uint16_t *table, size_t len)
+{
+    const struct ts_data_object *objs = ts->data_objects;
+
+    memset(table, 0xFF, len * sizeof(uint16_t));
+
+    // objects are inserted in database order, so the first of equal names is found first
+    for (size_t i = 0; i < ts->num_objects; i++) {
+        if (objs[i].name == NULL) {
+            continue;
+        }
+        size_t slot = _name_hash(objs[i].parent, objs[i].name, strlen(objs[i].name)) % len;
+        while (table[slot] != TS_INDEX_EMPTY) {
+            slot = (slot + 1) % len;
+        }
+        table[slot] = i;
+    }
+}
+
+struct ts_data_object *ts_index_find_name(struct ts_context *ts, const char *name, size_t len,
+                                          ts_object_id_t parent)
+{
+    const uint16_t *table = ts->index.names;
+    const size_t table_len = ts->index.names_len;
+
+    size_t slot = _name_hash(parent, name, len) % table_len;
+    for (size_t i = 0; i < table_len && table[slot] != TS_INDEX_EMPTY; i++) {
+        struct ts_data_object *object = &ts->data_objects[table[slot]];
+        if (object->parent == parent && strncmp(object->name, name, len) == 0
+            && strlen(object->name) == len)
+        {
+            return object;
+        }
+        slot = (slot + 1) % table_len;
+    }
+    return NULL;
+}
+
+static bool _parent_less(const struct ts_data_object *objs, uint16_t a, uint16_t b)
+{
+    // position as secondary key keeps the children in the same order as in the database
+    return objs[a].parent < objs[b].parent || (objs[a].parent == objs[b].parent && a < b);
+}
+
+static void _build_child_index(struct ts_context *ts, uint16_t *table, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        table[i] = i;
+    }
+    _sort(ts->data_objects, table, len, _parent_less);
+}
+
+struct ts_data_object *ts_get_next_child(struct ts_context *ts, ts_object_id_t parent,
+                                         unsigned int *iter)
+{
+    const uint16_t *table = ts->index.children;
+
+    if (table == NULL) {
+        // without index the iterator is the position in the data objects array
+        for (unsigned int i = *iter; i < ts->num_objects; i++) {
+            if (ts->data_objects[i].parent == parent) {
+                *iter = i + 1;
+                return &ts->data_objects[i];
+            }
+        }
+        *iter = ts->num_objects;
+        return NULL;
+    }
+
+    // with index the iterator is the position in the children table plus one (0 = not started)
+    size_t pos = *iter;
+    if (pos == 0) {
+        size_t high = ts->index.children_len;
+        while (pos < high) {
+            size_t mid = pos + (high - pos) / 2;
+            if (ts->data_objects[table[mid]].parent < parent) {
+                pos = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+    }
+    else {
+        pos--;
+    }
+
+    if (pos < ts->index.children_len && ts->data_objects[table[pos]].parent == parent) {
+        *iter = pos + 2;
+        return &ts->data_objects[table[pos]];
+    }
+    *iter = ts->index.children_len + 1;
+    return NULL;
+}
+
+/*
+ * Writes the member lists of all subsets. The subsets of the data objects may be changed
+ * concurrently, so the lists are only filled up to the previously counted length.
+ */
+static int _build_subset_lists(struct ts_context *ts, struct ts_index *index)
+{
+    uint16_t start[TS_NUM_SUBSETS + 1];
+    uint16_t next[TS_NUM_SUBSETS];
+
+    memset(next, 0, sizeof(next));
+    for (size_t i = 0; i < ts->num_objects; i++) {
+        for (int bit = 0; bit < TS_NUM_SUBSETS; bit++) {
+            if (ts->data_objects[i].subsets & (1U << bit)) {
+                next[bit]++;
+            }
+        }
+    }
+
+    size_t total = 0;
+    for (int bit = 0; bit < TS_NUM_SUBSETS; bit++) {
+        start[bit] = total;
+        total += next[bit];
+        next[bit] = start[bit];
+    }
+    start[TS_NUM_SUBSETS] = total;
+
+    if (total > index->subsets_size) {
+        index->subsets_valid = false;
+        return -ENOMEM;
+    }
+
+    memcpy(index->subsets_start, start, sizeof(start));
+    for (size_t i = 0; i < ts->num_objects; i++) {
+        for (int bit = 0; bit < TS_NUM_SUBSETS; bit++) {
+            if ((ts->data_objects[i].subsets & (1U << bit)) && next[bit] < start[bit + 1]) {
+                index->subsets[next[bit]++] = i;
+            }
+        }
+    }
+    // entries left over after a concurrent removal are skipped by ts_get_next_member
+    for (int bit = 0; bit < TS_NUM_SUBSETS; bit++) {
+        while (next[bit] < start[bit + 1]) {
+            index->subsets[next[bit]++] = ts->num_objects;
+        }
+    }
+
+    index->subsets_valid = true;
+
+    return 0;
+}
+
+int ts_index_update_subsets(struct ts_context *ts)
+{
+    // contexts initialized with ts_init_shared use the subset lists of the owning context
+    struct ts_index *index = ts->shared ? &ts->shared->index : &ts->index;
+    int err = 0;
+
+    if (index->subsets == NULL) {
+        return 0;
+    }
+
+    /*
+     * The lists are protected like a sequence lock with multiple writers: Only the context which
+     * changes the sequence number from even to odd rebuilds the lists. A context finding a rebuild
+     * in progress leaves the dirty flag set, so that the rebuild is repeated before it finishes.
+     */
+    __atomic_store_n(&index->subsets_dirty, true, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&index->subsets_dirty, __ATOMIC_SEQ_CST)) {
+        uint32_t seq = __atomic_load_n(&index->subsets_seq, __ATOMIC_RELAXED);
+        if ((seq & 1U)
+            || !__atomic_compare_exchange_n(&index->subsets_seq, &seq, seq + 1, false,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        {
+            return 0;
+        }
+
+        do {
+            __atomic_store_n(&index->subsets_dirty, false, __ATOMIC_SEQ_CST);
+            err = _build_subset_lists(ts, index);
+        } while (__atomic_load_n(&index->subsets_dirty, __ATOMIC_SEQ_CST));
+
+        __atomic_store_n(&index->subsets_seq, seq + 2, __ATOMIC_SEQ_CST);
+    }
+
+    return err;
+}
+
+static struct ts_data_object *_get_next_member_linear(struct ts_context *ts, uint16_t subsets,
+                                                      struct ts_member_iter *iter)
+{
+    for (unsigned int i = iter->pos; i < ts->num_objects; i++) {
+        if (ts->data_objects[i].subsets & subsets) {
+            iter->pos = i + 1;
+            return &ts->data_objects[i];
+        }
+    }
+    iter->pos = ts->num_objects;
+    return NULL;
+}
+
+struct ts_data_object *ts_get_next_member(struct ts_context *ts, uint16_t subsets,
+                                          struct ts_member_iter *iter)
+{
+    const struct ts_index *index = ts->shared ? &ts->shared->index : &ts->index;
+
+    const uint32_t seq = __atomic_load_n(&index->subsets_seq, __ATOMIC_ACQUIRE);
+    if ((seq & 1U) || !index->subsets_valid) {
+        return _get_next_member_linear(ts, subsets, iter);
+    }
+
+    if (!iter->started || iter->seq != seq) {
+        // find the first member not below the start position in each list
+        for (int bit = 0; bit < TS_NUM_SUBSETS; bit++) {
+            size_t low = index->subsets_start[bit];
+            size_t high = index->subsets_start[bit + 1];
+            while (low < high) {
+                size_t mid = low + (high - low) / 2;
+                if (index->subsets[mid] < iter->pos) {
+                    low = mid + 1;
+                }
+                else {
+                    high = mid;
+                }
+            }
+            iter->cursor[bit] = low;
+        }
+        iter->started = true;
+        iter->seq = seq;
+    }
+
+    // next member is the lowest position not below the iterator in any of the selected lists
+    size_t next = ts->num_objects;
+    for (int bit = 0; bit < TS_NUM_SUBSETS && (subsets >> bit) != 0; bit++) {
+        if (!(subsets & (1U << bit))) {
+            continue;
+        }
+        const uint16_t end = index->subsets_start[bit + 1];
+        uint16_t cursor = iter->cursor[bit];
+        while (cursor < end && index->subsets[cursor] < iter->pos) {
+            cursor++;
+        }
+        iter->cursor[bit] = cursor;
+        if (cursor < end && index->subsets[cursor] < next) {
+            next = index->subsets[cursor];
+        }
+    }
+
+    // the lists were rebuilt by another context while reading them
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&index->subsets_seq, __ATOMIC_RELAXED) != seq) {
+        return _get_next_member_linear(ts, subsets, iter);
+    }
+
+    if (next < ts->num_objects) {
+        iter->pos = next + 1;
+        return &ts->data_objects[next];
+    }
+    iter->pos = ts->num_objects;
+    return NULL;
+}
+
+struct ts_data_object *ts_get_next_member_value(struct ts_context *ts, uint16_t subsets,
+                                                struct ts_member_iter *iter)
+{
+    struct ts_capture_state *capture = &ts->capture;
+    struct ts_data_object *member;
+
+    while ((member = ts_get_next_member(ts, subsets, iter)) != NULL) {
+        if (capture->values == NULL && capture->filter == NULL) {
+            return member;
+        }
+
+        // same layout as used by ts_capture_push
+        const uint16_t index = iter->index++;
+        const size_t size = ts_capture_value_size(member);
+        const size_t offset = ts_capture_align(iter->offset, size);
+        iter->offset = offset + size;
+
+        // the members may have been changed by a request since the values were captured
+        if (index >= capture->num_members
+            || (capture->values != NULL && (size == 0 || offset + size > capture->size)))
+        {
+            capture->mismatch = true;
+            return NULL;
+        }
+
+        if (capture->filter != NULL && !(capture->filter[index / 32] & (1U << (index % 32)))) {
+            continue;
+        }
+        if (capture->values == NULL) {
+            return member;
+        }
+
+        struct ts_data_object obj = {
+            member->id,     member->parent, member->name,   (void *)&capture->values[offset],
+            member->type,   member->detail, member->access, member->subsets,
+        };
+        memcpy(capture->obj, &obj, sizeof(obj));
+        return capture->obj;
+    }
+
+    if ((capture->values != NULL || capture->filter != NULL)
+        && iter->index != capture->num_members)
+    {
+        capture->mismatch = true;
+    }
+
+    return NULL;
+}
+
+int ts_index_build(struct ts_context *ts, uint16_t *buf, size_t len)
+{
+    const size_t num = ts->num_objects;
+
+    memset(&ts->index, 0, sizeof(ts->index));
+
+    if (num == 0) {
+        return 0;
+    }
+    else if (num >= TS_INDEX_EMPTY || buf == NULL || len < TS_INDEX_BUF_LEN(num)) {
+        return -ENOMEM;
+    }
+
+    _build_id_index(ts, buf, TS_ID_INDEX_LEN(num));
+    ts->index.ids = buf;
+    ts->index.ids_len = TS_ID_INDEX_LEN(num);
+    buf += TS_ID_INDEX_LEN(num);
+
+    _build_name_index(ts, buf, TS_NAME_INDEX_LEN(num));
+    ts->index.names = buf;
+    ts->index.names_len = TS_NAME_INDEX_LEN(num);
+    buf += TS_NAME_INDEX_LEN(num);
+
+    _build_child_index(ts, buf, TS_CHILD_INDEX_LEN(num));
+    ts->index.children = buf;
+    ts->index.children_len = TS_CHILD_INDEX_LEN(num);
+    buf += TS_CHILD_INDEX_LEN(num);
+
+    // subsets are searched linearly if the lists don't fit into the buffer
+    ts->index.subsets = buf;
+    ts->index.subsets_size = TS_SUBSET_INDEX_LEN(num);
+    (void)ts_index_update_subsets(ts);
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) The ThingSet Project Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Client-side helper to keep multiple requests with request ID in flight. */
+
+#include "thingset.h"
+
+#include <errno.h>
+#include <string.h>
+
+static struct ts_pipeline_slot *pipeline_find(struct ts_pipeline *pl, uint32_t id)
+{
+    for (size_t i = 0; i < pl->num_slots; i++) {
+        if (pl->slots[i].pending && pl->slots[i].id == id) {
+            return &pl->slots[i];
+        }
+    }
+    return NULL;
+}
+
+void ts_pipeline_init(struct ts_pipeline *pl, struct ts_pipeline_slot *slots, size_t num_slots)
+{
+    memset(slots, 0, num_slots * sizeof(struct ts_pipeline_slot));
+    pl->slots = slots;
+    pl->num_slots = num_slots;
+    pl->num_pending = 0;
+    pl->next_id = 0;
+}
+
+int ts_pipeline_request(struct ts_pipeline *pl, const uint8_t *req, size_t req_len, uint8_t *buf,
+                        size_t buf_size, void *user_data, uint32_t *id)
+{
+    struct ts_pipeline_slot *slot = NULL;
+
+    if (req == NULL || req_len < 1) {
+        return -EINVAL;
+    }
+
+    for (size_t i = 0; i < pl->num_slots; i++) {
+        if (!pl->slots[i].pending) {
+            slot = &pl->slots[i];
+            break;
+        }
+    }
+    if (slot == NULL) {
+        return -EBUSY;
+    }
+
+    // skip IDs still in use after a wrap-around
+    while (pipeline_find(pl, pl->next_id) != NULL) {
+        pl->next_id++;
+    }
+
+    int len = ts_request_id_serialize(buf, buf_size, pl->next_id, req[0] < 0x20);
+    if (len == 0 || req_len > buf_size - len) {
+        return -ENOMEM;
+    }
+    memcpy(&buf[len], req, req_len);
+
+    slot->id = pl->next_id++;
+    slot->user_data = user_data;
+    slot->pending = true;
+    pl->num_pending++;
+
+    if (id != NULL) {
+        *id = slot->id;
+    }
+
+    return len + req_len;
+}
+
+int ts_pipeline_response(struct ts_pipeline *pl, const uint8_t *resp, size_t resp_len,
+                         const uint8_t **payload, size_t *payload_len, void **user_data)
+{
+    uint32_t id;
+
+    int prefix_len = ts_request_id_parse(resp, resp_len, &id);
+    if (prefix_len <= 0) {
+        return -EINVAL;
+    }
+
+    struct ts_pipeline_slot *slot = pipeline_find(pl, id);
+    if (slot == NULL) {
+        return -ENOENT;
+    }
+
+    slot->pending = false;
+    pl->num_pending--;
+
+    *payload = &resp[prefix_len];
+    *payload_len = resp_len - prefix_len;
+    if (user_data != NULL) {
+        *user_data = slot->user_data;
+    }
+
+    return 0;
+}
+
+int ts_pipeline_cancel(struct ts_pipeline *pl, uint32_t id)
+{
+    struct ts_pipeline_slot *slot = pipeline_find(pl, id);
+    if (slot == NULL) {
+        return -ENOENT;
+    }
+
+    slot->pending = false;
+    pl->num_pending--;
+
+    return 0;
+}
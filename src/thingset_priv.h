@@ -50,9 +50,20 @@ extern "C" {
 /** Value to use for record index if no index was specified */
 #define RECORD_INDEX_NONE (-1)
 
+/** Marker for unused slots in the hash tables of the lookup index */
+#define TS_INDEX_EMPTY 0xFFFF
+
 /**
- * Prepares JSMN parser, performs initial check of payload data and calls get/fetch/patch
- * functions.
+ * Returns the context owning the data objects (see ts_init_shared), which stores the settings
+ * common to all contexts sharing them.
+ */
+static inline struct ts_context *ts_owner(struct ts_context *ts)
+{
+    return ts->shared ? ts->shared : ts;
+}
+
+/**
+ * Performs initial check of payload data and calls get/fetch/patch functions.
  */
 int ts_txt_process(struct ts_context *ts);
 
@@ -87,6 +98,29 @@ int ts_txt_get(struct ts_context *ts, const struct ts_data_object *endpoint, uin
 int ts_bin_get(struct ts_context *ts, const struct ts_data_object *endpoint, uint32_t ret_type,
                int record_index);
 
+/**
+ * Serialize the next child object of a GET request processed with ts_process_begin (text mode).
+ *
+ * The data is written to the scratch buffer of the chunk state. After the last child object,
+ * the end of the response is written and chunk.elements is cleared.
+ *
+ * @param ts Pointer to ThingSet context.
+ *
+ * @returns Number of bytes written to the scratch buffer or -ENOMEM if it is too small
+ */
+int ts_txt_get_next(struct ts_context *ts);
+
+/**
+ * Serialize the next child object of a GET request processed with ts_process_begin (binary mode).
+ *
+ * See ts_txt_get_next for details.
+ *
+ * @param ts Pointer to ThingSet context.
+ *
+ * @returns Number of bytes written to the scratch buffer or -ENOMEM if it is too small
+ */
+int ts_bin_get_next(struct ts_context *ts);
+
 /**
  * FETCH request (text mode).
  *
@@ -201,33 +235,179 @@ int ts_txt_response(struct ts_context *ts, int code);
  */
 int ts_bin_response(struct ts_context *ts, uint8_t code);
 
+/**
+ * State of the JSON writer used for all text mode serialization.
+ *
+ * The writer keeps track of the remaining capacity and of the separators between elements, so
+ * that JSON output is generated in a single pass. If the buffer is too small, the overflow flag
+ * is set and all further output is ignored.
+ */
+struct ts_json_writer
+{
+    /** Buffer to store the JSON string */
+    char *buf;
+    /** Size of the buffer (including space for the terminating NUL) */
+    size_t size;
+    /** Current position in the buffer */
+    size_t pos;
+    /** Sticky flag set if any output did not fit into the buffer */
+    bool overflow;
+    /** A comma has to be written before the next element */
+    bool separator;
+};
+
+/**
+ * Initialize a JSON writer.
+ *
+ * @param w JSON writer
+ * @param buf Pointer to the buffer where the JSON string should be stored.
+ * @param size Size of the buffer
+ */
+void ts_json_writer_init(struct ts_json_writer *w, char *buf, size_t size);
+
+/**
+ * Terminate the JSON string of a writer.
+ *
+ * @param w JSON writer
+ *
+ * @returns Length of the JSON string (without NUL) or 0 if the buffer was too small
+ */
+int ts_json_writer_finish(struct ts_json_writer *w);
+
 /**
  * Serialize a object value into a JSON string.
  *
+ * A separating comma is written before the value if it is not the first element of an array
+ * or object.
+ *
  * @param ts Pointer to ThingSet context.
- * @param buf Pointer to the buffer where the JSON value should be stored.
- * @param size Size of the buffer, i.e. maximum allowed length of the value.
+ * @param w JSON writer
  * @param object Pointer to object which should be serialized.
- *
- * @returns Length of data written to buffer or 0 in case of error.
  */
-int ts_json_serialize_value(struct ts_context *ts, char *buf, size_t size,
-                            const struct ts_data_object *object);
+void ts_json_serialize_value(struct ts_context *ts, struct ts_json_writer *w,
+                             const struct ts_data_object *object);
 
 /**
- * Serialize object name and value as JSON object.
+ * Serialize object name and value as member of a JSON object.
  *
  * Same as ts_json_serialize_value, just that the object name is also serialized.
  *
  * @param ts Pointer to ThingSet context.
- * @param buf Pointer to the buffer where the JSON value should be stored.
- * @param size Size of the buffer, i.e. maximum allowed length of the value.
+ * @param w JSON writer
  * @param object Pointer to object which should be serialized.
+ */
+void ts_json_serialize_name_value(struct ts_context *ts, struct ts_json_writer *w,
+                                  const struct ts_data_object *object);
+
+/**
+ * Format a signed integer as decimal text.
+ *
+ * @param buf Pointer to the buffer where the text should be stored.
+ * @param size Size of the buffer
+ * @param value Value to be formatted
+ *
+ * @returns Same as snprintf: Length of the text (without NUL), even if it was truncated
+ */
+int ts_txt_format_int(char *buf, size_t size, int32_t value);
+
+/**
+ * Format an unsigned integer as decimal text.
+ *
+ * @param buf Pointer to the buffer where the text should be stored.
+ * @param size Size of the buffer
+ * @param value Value to be formatted
  *
- * @returns Length of data written to buffer or 0 in case of error.
+ * @returns Same as snprintf: Length of the text (without NUL), even if it was truncated
+ */
+int ts_txt_format_uint(char *buf, size_t size, uint32_t value);
+
+/**
+ * Format a float with a fixed number of decimal digits.
+ *
+ * The output is identical to snprintf(buf, size, "%.*f", digits, value) (including correct
+ * rounding), but the common case of values below 2^30 and up to 9 digits is handled with integer
+ * arithmetics only. Other values are passed on to snprintf.
+ *
+ * @param buf Pointer to the buffer where the text should be stored.
+ * @param size Size of the buffer
+ * @param value Value to be formatted
+ * @param digits Number of digits after the decimal point
+ *
+ * @returns Same as snprintf: Length of the text (without NUL), even if it was truncated
+ */
+int ts_txt_format_float(char *buf, size_t size, float value, int digits);
+
+/**
+ * Types of the tokens returned by the JSON reader
+ */
+enum ts_json_type
+{
+    TS_JSON_END = 0,    /**< End of the JSON payload */
+    TS_JSON_OBJECT,     /**< Start of an object */
+    TS_JSON_OBJECT_END, /**< End of an object */
+    TS_JSON_ARRAY,      /**< Start of an array */
+    TS_JSON_ARRAY_END,  /**< End of an array */
+    TS_JSON_STRING,     /**< String (member names are also returned as strings) */
+    TS_JSON_PRIMITIVE,  /**< Number, true, false or null */
+};
+
+/**
+ * Token returned by the JSON reader
  */
-int ts_json_serialize_name_value(struct ts_context *ts, char *buf, size_t size,
-                                 const struct ts_data_object *object);
+struct ts_json_token
+{
+    /** Type of the token */
+    enum ts_json_type type;
+    /** Start of the token in the JSON string (without quotation marks for strings) */
+    const char *start;
+    /** Length of the token */
+    size_t len;
+};
+
+/**
+ * State of the pull-style JSON reader used for text mode requests.
+ *
+ * The reader tokenizes the payload on the fly, so the state only depends on the nesting depth
+ * and not on the size of the payload.
+ */
+struct ts_json_reader
+{
+    /** JSON string (does not need to be NUL-terminated) */
+    const char *str;
+    /** Length of the JSON string */
+    size_t len;
+    /** Current position in the JSON string */
+    size_t pos;
+    /** Bit n is set if nesting level n + 1 is an object (otherwise it is an array) */
+    uint32_t objects;
+    /** Current nesting depth */
+    uint8_t depth;
+    /** Expected next syntax element */
+    uint8_t state;
+};
+
+/**
+ * Initialize a JSON reader.
+ *
+ * @param r JSON reader
+ * @param str JSON string
+ * @param len Length of the JSON string
+ */
+void ts_json_reader_init(struct ts_json_reader *r, const char *str, size_t len);
+
+/**
+ * Read the next token from the JSON string.
+ *
+ * Commas and colons are checked and skipped by the reader. A JSON string must contain a single
+ * value (which may be an object or array) or nothing. The end of the string is returned as a
+ * token of type TS_JSON_END.
+ *
+ * @param r JSON reader
+ * @param tok Pointer to store the token
+ *
+ * @returns 0 for success, -EINVAL for invalid JSON or -ENOMEM if the nesting is too deep
+ */
+int ts_json_next(struct ts_json_reader *r, struct ts_json_token *tok);
 
 /**
  * Deserialize a object value from a JSON string.
@@ -235,13 +415,13 @@ int ts_json_serialize_name_value(struct ts_context *ts, char *buf, size_t size,
  * @param ts Pointer to ThingSet context.
  * @param buf Pointer to the position of the value in a buffer.
  * @param len Length of value in the buffer.
- * @param type Type of the JSMN token as identified by the parser.
+ * @param type Type of the JSON token as identified by the reader.
  * @param object Pointer to object where the deserialized value should be stored.
  *
- * @returns Number of tokens processed (always 1) or 0 in case of error.
+ * @returns 1 for success or 0 in case of error.
  */
-int ts_json_deserialize_value(struct ts_context *ts, char *buf, size_t len, jsmntype_t type,
-                              const struct ts_data_object *object);
+int ts_json_deserialize_value(struct ts_context *ts, const char *buf, size_t len,
+                              enum ts_json_type type, const struct ts_data_object *object);
 
 /**
  * Write the path of an object into a buffer.
@@ -272,6 +452,183 @@ int ts_get_path(struct ts_context *ts, char *buf, size_t size, const struct ts_d
 struct ts_data_object *ts_get_endpoint_by_path(struct ts_context *ts, const char *path, size_t len,
                                                int *index);
 
+/**
+ * Build the lookup index for the data objects of a context.
+ *
+ * @param ts Pointer to ThingSet context with data objects already assigned.
+ * @param buf Buffer to store the index tables.
+ * @param len Number of elements in the buffer (see TS_INDEX_BUF_LEN).
+ *
+ * The data objects are not validated. For duplicate IDs or names, the first object in the array
+ * is found (same as with the linear search).
+ *
+ * @returns 0 for success or -ENOMEM if the buffer is too small
+ */
+int ts_index_build(struct ts_context *ts, uint16_t *buf, size_t len);
+
+/**
+ * Find a data object by ID using the lookup index.
+ *
+ * @param ts Pointer to ThingSet context with valid index.
+ * @param id Data object ID
+ *
+ * @returns Pointer to data object or NULL if object is not found
+ */
+struct ts_data_object *ts_index_find_id(struct ts_context *ts, ts_object_id_t id);
+
+/**
+ * Find a data object by name and parent ID using the lookup index.
+ *
+ * @param ts Pointer to ThingSet context with valid index.
+ * @param name Data object name
+ * @param len Length of the object name
+ * @param parent Data object ID of the parent
+ *
+ * @returns Pointer to data object or NULL if object is not found
+ */
+struct ts_data_object *ts_index_find_name(struct ts_context *ts, const char *name, size_t len,
+                                          ts_object_id_t parent);
+
+/**
+ * Iterate over the child objects of a parent.
+ *
+ * The children are returned in the same order as they are stored in the data_objects array. If
+ * an index is available, only the children themselves are visited. Otherwise the entire array is
+ * searched linearly.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param parent Data object ID of the parent
+ * @param iter Iterator state, has to be initialized with 0 before the first call
+ *
+ * @returns Pointer to next child object or NULL if no more children are available
+ */
+struct ts_data_object *ts_get_next_child(struct ts_context *ts, ts_object_id_t parent,
+                                         unsigned int *iter);
+
+/**
+ * Rebuild the member lists of the subsets in the lookup index.
+ *
+ * Has to be called whenever the subsets of a data object were changed. If another context is
+ * currently rebuilding the lists, the rebuild is repeated by that context instead.
+ *
+ * @param ts Pointer to ThingSet context.
+ *
+ * @returns 0 for success or -ENOMEM if the lists don't fit into the buffer (subsets are searched
+ *          linearly in this case)
+ */
+int ts_index_update_subsets(struct ts_context *ts);
+
+/**
+ * State for iterating over the members of subsets (see ts_get_next_member).
+ *
+ * Has to be initialized with zeros, optionally with a different start position.
+ */
+struct ts_member_iter
+{
+    /** Position in the data_objects array to continue searching */
+    unsigned int pos;
+
+    /** Current positions in the member lists of the index */
+    uint16_t cursor[TS_NUM_SUBSETS];
+
+    /** True if the cursors were already set to the start position */
+    bool started;
+
+    /** Sequence number of the member lists the cursors refer to */
+    uint32_t seq;
+
+    /** Number of members already visited by ts_get_next_member_value */
+    uint16_t index;
+
+    /** Offset of the next captured value visited by ts_get_next_member_value */
+    size_t offset;
+};
+
+/**
+ * Iterate over the data objects contained in any of the specified subsets.
+ *
+ * The objects are returned in the same order as they are stored in the data_objects array. If
+ * the member lists of the index are available, only the members are visited.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param subsets Flags to select the subsets
+ * @param iter Iterator state
+ *
+ * @returns Pointer to next member or NULL if no more members are available
+ */
+struct ts_data_object *ts_get_next_member(struct ts_context *ts, uint16_t subsets,
+                                          struct ts_member_iter *iter);
+
+/**
+ * Size of the value of a data object stored in a capture queue.
+ *
+ * @param object Data object
+ *
+ * @returns Size in bytes or 0 if the type can't be captured
+ */
+size_t ts_capture_value_size(const struct ts_data_object *object);
+
+/**
+ * Align the offset of a captured value in a slot according to its size.
+ *
+ * @param offset Offset of the first free byte in the slot
+ * @param size Size of the value
+ *
+ * @returns Offset of the value
+ */
+static inline size_t ts_capture_align(size_t offset, size_t size)
+{
+    size_t align = 1;
+    while (align < 8 && align * 2 <= size) {
+        align *= 2;
+    }
+    return (offset + align - 1) & ~(align - 1);
+}
+
+/**
+ * Get the next member of subsets with the value to be serialized.
+ *
+ * Same as ts_get_next_member, but if a statement is generated from captured values (see
+ * ts_capture_bin_statement), a temporary data object pointing to the captured value is returned.
+ * Members not selected by the filter of a delta statement (see ts_bin_delta_statement) are
+ * skipped.
+ * The members have to be iterated in order, starting from the first member.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param subsets Flags to select the subsets
+ * @param iter Iterator state
+ *
+ * @returns Pointer to next member or NULL if no more members are available
+ */
+struct ts_data_object *ts_get_next_member_value(struct ts_context *ts, uint16_t subsets,
+                                                struct ts_member_iter *iter);
+
+#if CONFIG_THINGSET_SEQLOCK
+
+/**
+ * Start reading the values of subsets protected by sequence locks.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param subsets Flags to select the subsets
+ * @param seq Pointer to store the combined sequence number (passed to ts_seqlock_read_retry)
+ *
+ * @returns False if a writer is currently updating the values (reading has to be retried)
+ */
+bool ts_seqlock_read_begin(struct ts_context *ts, uint16_t subsets, uint32_t *seq);
+
+/**
+ * Check if the values of subsets protected by sequence locks were updated while reading.
+ *
+ * @param ts Pointer to ThingSet context.
+ * @param subsets Flags to select the subsets
+ * @param seq Combined sequence number returned by ts_seqlock_read_begin
+ *
+ * @returns True if the values have to be read again
+ */
+bool ts_seqlock_read_retry(struct ts_context *ts, uint16_t subsets, uint32_t seq);
+
+#endif /* CONFIG_THINGSET_SEQLOCK */
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -5,12 +5,10 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
-/* this must be included before thingset.h */
-#include "jsmn.h"
-
 #include "thingset_priv.h"
 
 #include <errno.h>
+#include <float.h>
 #include <inttypes.h>
 #include <math.h>
 #include <stdio.h>
@@ -98,233 +96,644 @@ int ts_txt_response(struct ts_context *ts, int code)
         return 0;
 }
 
-static int json_serialize_simple_value(char *buf, size_t size, void *data, int type, int detail)
+/* copies a string into the buffer with the same truncation and return value as snprintf */
+static int txt_put(char *buf, size_t size, const char *str, size_t len)
+{
+    if (size > 0) {
+        size_t num = (len < size) ? len : size - 1;
+        memcpy(buf, str, num);
+        buf[num] = '\0';
+    }
+    return len;
+}
+
+/* writes the decimal digits of value backwards, ending before end */
+static char *txt_utoa(char *end, uint32_t value)
+{
+    do {
+        *--end = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    return end;
+}
+
+#if CONFIG_THINGSET_64BIT_TYPES_SUPPORT
+static char *txt_utoa64(char *end, uint64_t value)
+{
+    // avoid slow 64-bit divisions for each digit on 32-bit MCUs
+    while (value > UINT32_MAX) {
+        uint32_t low = value % 1000000000U;
+        value /= 1000000000U;
+        char *start = txt_utoa(end, low);
+        while (start > end - 9) {
+            *--start = '0';
+        }
+        end = start;
+    }
+    return txt_utoa(end, (uint32_t)value);
+}
+#endif
+
+int ts_txt_format_int(char *buf, size_t size, int32_t value)
+{
+    char str[12];
+    char *end = str + sizeof(str);
+    char *start = txt_utoa(end, value < 0 ? -(uint32_t)value : (uint32_t)value);
+    if (value < 0) {
+        *--start = '-';
+    }
+    return txt_put(buf, size, start, end - start);
+}
+
+int ts_txt_format_uint(char *buf, size_t size, uint32_t value)
+{
+    char str[11];
+    char *end = str + sizeof(str);
+    char *start = txt_utoa(end, value);
+    return txt_put(buf, size, start, end - start);
+}
+
+int ts_txt_format_float(char *buf, size_t size, float value, int digits)
+{
+    static const uint32_t pow10[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+    };
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    const bool negative = bits >> 31;
+    int exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent >= 127 + 30 || digits < 0 || digits >= (int)(sizeof(pow10) / sizeof(pow10[0]))) {
+        // large numbers, NaN, Inf or precision not supported by the fast path
+        return snprintf(buf, size, "%.*f", digits, value);
+    }
+
+    if (exponent == 0) {
+        exponent = 1; // subnormal number
+    }
+    else {
+        mantissa |= 1U << 23;
+    }
+
+    // value = mantissa * 2^shift, so value * 10^digits can be calculated exactly with integers
+    int shift = exponent - 127 - 23;
+    uint64_t scaled = (uint64_t)mantissa * pow10[digits];
+    if (shift >= 0) {
+        scaled <<= shift;
+    }
+    else if (-shift < 64) {
+        // round half to even, same as printf
+        uint64_t rem = scaled & ((1ULL << -shift) - 1);
+        uint64_t half = 1ULL << (-shift - 1);
+        scaled >>= -shift;
+        if (rem > half || (rem == half && (scaled & 1))) {
+            scaled++;
+        }
+    }
+    else {
+        scaled = 0;
+    }
+
+    char str[24];
+    char *end = str + sizeof(str);
+    char *start = end;
+    uint32_t int_part = scaled / pow10[digits];
+    if (digits > 0) {
+        start = txt_utoa(end, scaled % pow10[digits]);
+        while (start > end - digits) {
+            *--start = '0';
+        }
+        *--start = '.';
+    }
+    start = txt_utoa(start, int_part);
+    if (negative) {
+        *--start = '-';
+    }
+
+    return txt_put(buf, size, start, end - start);
+}
+
+void ts_json_writer_init(struct ts_json_writer *w, char *buf, size_t size)
+{
+    w->buf = buf;
+    w->size = size;
+    w->pos = 0;
+    w->overflow = (size == 0);
+    w->separator = false;
+}
+
+int ts_json_writer_finish(struct ts_json_writer *w)
+{
+    if (w->overflow) {
+        return 0;
+    }
+    w->buf[w->pos] = '\0';
+    return w->pos;
+}
+
+/* appends text to the buffer, always keeping space for the terminating NUL */
+static void json_raw(struct ts_json_writer *w, const char *str, size_t len)
+{
+    if (w->overflow || len >= w->size - w->pos) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(&w->buf[w->pos], str, len);
+    w->pos += len;
+}
+
+static void json_char(struct ts_json_writer *w, char c)
+{
+    if (w->overflow || w->pos + 1 >= w->size) {
+        w->overflow = true;
+        return;
+    }
+    w->buf[w->pos++] = c;
+}
+
+/* accounts for text written to the end of the buffer by a function with snprintf semantics */
+static void json_advance(struct ts_json_writer *w, int len)
+{
+    if (w->overflow || len < 0 || (size_t)len >= w->size - w->pos) {
+        w->overflow = true;
+        return;
+    }
+    w->pos += len;
+}
+
+/* writes the comma before all but the first element of an array or object */
+static void json_separator(struct ts_json_writer *w)
+{
+    if (w->separator) {
+        json_char(w, ',');
+    }
+    w->separator = true;
+}
+
+static void json_begin(struct ts_json_writer *w, char bracket)
+{
+    json_separator(w);
+    json_char(w, bracket);
+    w->separator = false;
+}
+
+static void json_end(struct ts_json_writer *w, char bracket)
+{
+    json_char(w, bracket);
+    w->separator = true;
+}
+
+static void json_quoted(struct ts_json_writer *w, const char *str)
+{
+    json_char(w, '"');
+    json_raw(w, str, strlen(str));
+    json_char(w, '"');
+}
+
+static void json_string(struct ts_json_writer *w, const char *str)
+{
+    json_separator(w);
+    json_quoted(w, str);
+}
+
+/* writes the name of an object member, the value has to follow */
+static void json_name(struct ts_json_writer *w, const char *name)
+{
+    json_string(w, name);
+    json_char(w, ':');
+    w->separator = false;
+}
+
+static void json_simple_value(struct ts_json_writer *w, const void *data, int type, int detail)
 {
+    char *buf;
+    size_t size;
+
+    json_separator(w);
+    if (w->overflow) {
+        return;
+    }
+
+    buf = &w->buf[w->pos];
+    size = w->size - w->pos;
+
     switch (type) {
 #if CONFIG_THINGSET_64BIT_TYPES_SUPPORT
-        case TS_T_UINT64:
-            return snprintf(buf, size, "%" PRIu64 ",", *((uint64_t *)data));
-        case TS_T_INT64:
-            return snprintf(buf, size, "%" PRIi64 ",", *((int64_t *)data));
+        case TS_T_UINT64: {
+            char str[21];
+            char *start = txt_utoa64(str + sizeof(str), *((uint64_t *)data));
+            json_raw(w, start, str + sizeof(str) - start);
+            break;
+        }
+        case TS_T_INT64: {
+            int64_t value = *((int64_t *)data);
+            char str[21];
+            char *start = txt_utoa64(str + sizeof(str), value < 0 ? -(uint64_t)value : value);
+            if (value < 0) {
+                *--start = '-';
+            }
+            json_raw(w, start, str + sizeof(str) - start);
+            break;
+        }
 #endif
         case TS_T_UINT32:
-            return snprintf(buf, size, "%" PRIu32 ",", *((uint32_t *)data));
+            json_advance(w, ts_txt_format_uint(buf, size, *((uint32_t *)data)));
+            break;
         case TS_T_INT32:
-            return snprintf(buf, size, "%" PRIi32 ",", *((int32_t *)data));
+            json_advance(w, ts_txt_format_int(buf, size, *((int32_t *)data)));
+            break;
         case TS_T_UINT16:
-            return snprintf(buf, size, "%" PRIu16 ",", *((uint16_t *)data));
+            json_advance(w, ts_txt_format_uint(buf, size, *((uint16_t *)data)));
+            break;
         case TS_T_INT16:
-            return snprintf(buf, size, "%" PRIi16 ",", *((int16_t *)data));
+            json_advance(w, ts_txt_format_int(buf, size, *((int16_t *)data)));
+            break;
         case TS_T_UINT8:
-            return snprintf(buf, size, "%" PRIu8 ",", *((uint8_t *)data));
+            json_advance(w, ts_txt_format_uint(buf, size, *((uint8_t *)data)));
+            break;
         case TS_T_INT8:
-            return snprintf(buf, size, "%" PRIi8 ",", *((int8_t *)data));
+            json_advance(w, ts_txt_format_int(buf, size, *((int8_t *)data)));
+            break;
         case TS_T_FLOAT32: {
             float value = *((float *)data);
             if (isnan(value) || isinf(value)) {
                 /* JSON spec does not support NaN and Inf, so we need to use null instead */
-                return snprintf(buf, size, "null,");
+                json_raw(w, "null", 4);
             }
             else {
-                return snprintf(buf, size, "%.*f,", detail, value);
+                json_advance(w, ts_txt_format_float(buf, size, value, detail));
             }
+            break;
         }
 #if CONFIG_THINGSET_DECFRAC_TYPE_SUPPORT
         case TS_T_DECFRAC:
-            return snprintf(buf, size, "%" PRIi32 "e%" PRIi16 ",", *((uint32_t *)data), detail);
+            json_advance(w, ts_txt_format_int(buf, size, *((int32_t *)data)));
+            json_char(w, 'e');
+            if (!w->overflow) {
+                json_advance(w, ts_txt_format_int(&w->buf[w->pos], w->size - w->pos, detail));
+            }
+            break;
 #endif
         case TS_T_BOOL:
-            return snprintf(buf, size, "%s,", (*((bool *)data) == true ? "true" : "false"));
+            if (*((bool *)data) == true) {
+                json_raw(w, "true", 4);
+            }
+            else {
+                json_raw(w, "false", 5);
+            }
+            break;
         case TS_T_STRING:
-            return snprintf(buf, size, "\"%s\",", (char *)data);
+            json_quoted(w, (const char *)data);
+            break;
 #ifdef CONFIG_BASE64 /* Zephyr only */
         case TS_T_BYTES: {
             struct ts_bytes_buffer *bytes_buf = (struct ts_bytes_buffer *)data;
             size_t strlen;
-            int err = base64_encode((uint8_t *)buf + 1, size - 4, &strlen, bytes_buf->bytes,
-                                    bytes_buf->num_bytes);
-            if (err == 0) {
-                buf[0] = '\"';
-                buf[strlen + 1] = '\"';
-                buf[strlen + 2] = ',';
-                buf[strlen + 3] = '\0';
-                return strlen + 3;
+            // space for quotation marks and terminating NUL
+            if (size < 3 || base64_encode((uint8_t *)buf + 1, size - 3, &strlen, bytes_buf->bytes,
+                                          bytes_buf->num_bytes)
+                                != 0)
+            {
+                json_raw(w, "null", 4);
             }
             else {
-                return snprintf(buf, size, "null,");
+                buf[0] = '\"';
+                buf[strlen + 1] = '\"';
+                w->pos += strlen + 2;
             }
+            break;
         }
 #endif
+        default:
+            json_raw(w, "null", 4);
+            break;
     }
-    return 0;
 }
 
-int ts_json_serialize_value(struct ts_context *ts, char *buf, size_t size,
-                            const struct ts_data_object *object)
+/* finishes a response with the JSON payload written by w behind the status message */
+static int txt_response_payload(struct ts_context *ts, size_t status_len,
+                                struct ts_json_writer *w)
+{
+    if (ts_json_writer_finish(w) == 0) {
+        return ts_txt_response(ts, TS_STATUS_RESPONSE_TOO_LARGE);
+    }
+    return status_len + w->pos;
+}
+
+/* writes a subset member name, including the parent name for nested JSON */
+static void json_member_path(struct ts_context *ts, struct ts_json_writer *w,
+                             const struct ts_data_object *member)
 {
-    int pos = json_serialize_simple_value(buf, size, object->data, object->type, object->detail);
-
-    if (pos == 0) {
-        // not a simple value
-        if (object->type == TS_T_FN_VOID || object->type == TS_T_FN_INT32) {
-            pos = snprintf(buf, size, "[");
-            for (unsigned int i = 0; i < ts->num_objects; i++) {
-                if (ts->data_objects[i].parent == object->id) {
-                    pos += snprintf(buf + pos, size - pos, "\"%s\",", ts->data_objects[i].name);
-                }
-            }
-            if (pos > 1) {
-                pos--; // remove trailing comma
-            }
-            pos += snprintf(buf + pos, size - pos, "],");
-        }
-        else if (object->type == TS_T_SUBSET) {
-            pos = snprintf(buf, size, "[");
-            for (unsigned int i = 0; i < ts->num_objects; i++) {
-                if (ts->data_objects[i].subsets & (uint16_t)object->detail) {
 #if CONFIG_THINGSET_NESTED_JSON
-                    if (ts->data_objects[i].parent == 0) {
-                        pos += snprintf(buf + pos, size - pos, "\"%s\",", ts->data_objects[i].name);
-                    }
-                    else {
-                        struct ts_data_object *parent_obj =
-                            ts_get_object_by_id(ts, ts->data_objects[i].parent);
-                        if (parent_obj != NULL) {
-                            pos += snprintf(buf + pos, size - pos, "\"%s/%s\",", parent_obj->name,
-                                            ts->data_objects[i].name);
-                        }
-                    }
-#else
-                    pos += snprintf(buf + pos, size - pos, "\"%s\",", ts->data_objects[i].name);
+    if (member->parent != 0) {
+        struct ts_data_object *parent_obj = ts_get_object_by_id(ts, member->parent);
+        if (parent_obj != NULL) {
+            json_separator(w);
+            json_char(w, '"');
+            json_raw(w, parent_obj->name, strlen(parent_obj->name));
+            json_char(w, '/');
+            json_raw(w, member->name, strlen(member->name));
+            json_char(w, '"');
+        }
+        return;
+    }
 #endif
-                }
-            }
-            if (pos > 1) {
-                pos--; // remove trailing comma
-            }
-            pos += snprintf(buf + pos, size - pos, "],");
-        }
-        else if (object->type == TS_T_ARRAY && object->data != NULL) {
-            struct ts_array *array = (struct ts_array *)object->data;
-            pos += snprintf(buf + pos, size - pos, "[");
-            for (int i = 0; i < array->num_elements; i++) {
-                void *data = (uint8_t *)array->elements + i * array->type_size;
-                pos += json_serialize_simple_value(buf + pos, size - pos, data, array->type,
-                                                   object->detail);
-            }
-            if (array->num_elements > 0) {
-                pos--; // remove trailing comma
-            }
-            pos += snprintf(buf + pos, size - pos, "],");
+    json_string(w, member->name);
+}
+
+void ts_json_serialize_value(struct ts_context *ts, struct ts_json_writer *w,
+                             const struct ts_data_object *object)
+{
+    if (object->type == TS_T_FN_VOID || object->type == TS_T_FN_INT32) {
+        struct ts_data_object *child;
+        unsigned int iter = 0;
+        json_begin(w, '[');
+        while ((child = ts_get_next_child(ts, object->id, &iter)) != NULL && !w->overflow) {
+            json_string(w, child->name);
         }
-        else if (object->type == TS_T_GROUP) {
-            pos = snprintf(buf, size, "null,");
+        json_end(w, ']');
+    }
+    else if (object->type == TS_T_SUBSET) {
+        struct ts_data_object *member;
+        struct ts_member_iter iter = { 0 };
+        json_begin(w, '[');
+        while ((member = ts_get_next_member(ts, (uint16_t)object->detail, &iter)) != NULL
+               && !w->overflow)
+        {
+            json_member_path(ts, w, member);
         }
-        else if (object->type == TS_T_RECORDS) {
-            struct ts_records *records = (struct ts_records *)object->data;
-            pos = snprintf(buf, size, "%d,", records->num_records);
+        json_end(w, ']');
+    }
+    else if (object->type == TS_T_ARRAY) {
+        struct ts_array *array = (struct ts_array *)object->data;
+        json_begin(w, '[');
+        for (int i = 0; array != NULL && i < array->num_elements && !w->overflow; i++) {
+            void *data = (uint8_t *)array->elements + i * array->type_size;
+            json_simple_value(w, data, array->type, object->detail);
         }
+        json_end(w, ']');
     }
-
-    if (pos < size) {
-        return pos;
+    else if (object->type == TS_T_GROUP) {
+        json_separator(w);
+        json_raw(w, "null", 4);
+    }
+    else if (object->type == TS_T_RECORDS) {
+        struct ts_records *records = (struct ts_records *)object->data;
+        json_simple_value(w, &records->num_records, TS_T_UINT16, 0);
     }
     else {
-        return 0;
+        json_simple_value(w, object->data, object->type, object->detail);
     }
 }
 
-int ts_json_serialize_name_value(struct ts_context *ts, char *buf, size_t size,
-                                 const struct ts_data_object *object)
+void ts_json_serialize_name_value(struct ts_context *ts, struct ts_json_writer *w,
+                                  const struct ts_data_object *object)
 {
-    size_t len_name = snprintf(buf, size, "\"%s\":", object->name);
-    if (len_name < 0) {
-        return 0;
-    }
+    json_name(w, object->name);
+    ts_json_serialize_value(ts, w, object);
+}
 
-    int len_value = ts_json_serialize_value(ts, &buf[len_name], size - len_name, object);
-    if (len_value < 0) {
-        return 0;
-    }
+/* serializes name and value of a single record item */
+static void json_serialize_record_item(struct ts_json_writer *w,
+                                       const struct ts_data_object *endpoint,
+                                       const struct ts_data_object *item, int record_index)
+{
+    struct ts_records *records = (struct ts_records *)endpoint->data;
+    void *data =
+        (uint8_t *)records->data + record_index * records->record_size + (size_t)item->data;
 
-    return len_name + len_value;
+    json_name(w, item->name);
+    json_simple_value(w, data, item->type, item->detail);
 }
 
-int ts_json_serialize_record(struct ts_context *ts, char *buf, size_t size,
-                             const struct ts_data_object *endpoint, int record_index,
-                             int *objects_found)
+/* serializes all items of a record as members of a JSON object (without the brackets) */
+static int json_serialize_record(struct ts_context *ts, struct ts_json_writer *w,
+                                 const struct ts_data_object *endpoint, int record_index)
 {
-    struct ts_records *records = (struct ts_records *)endpoint->data;
-    size_t len = 0;
+    int objects_found = 0;
 
     /* record item definitions are expected to start behind endpoint data object */
     const struct ts_data_object *item = endpoint + 1;
-    while (item < &ts->data_objects[ts->num_objects] && item->parent == endpoint->id) {
-        size_t len_name = snprintf(buf + len, size - len, "\"%s\":", item->name);
-        if (len_name < 0) {
-            return 0;
-        }
-
-        void *data =
-            (uint8_t *)records->data + record_index * records->record_size + (size_t)item->data;
-        int len_value = json_serialize_simple_value(buf + len + len_name, size - len - len_name,
-                                                    data, item->type, item->detail);
-        if (len_value < 0) {
-            return 0;
-        }
-
-        len += len_name + len_value;
+    while (item < &ts->data_objects[ts->num_objects] && item->parent == endpoint->id
+           && !w->overflow)
+    {
+        json_serialize_record_item(w, endpoint, item, record_index);
+        objects_found++;
         item++;
-        if (objects_found != NULL) {
-            *objects_found += 1;
-        }
     }
 
-    return len;
+    return objects_found;
 }
 
 void ts_dump_json(struct ts_context *ts, ts_object_id_t obj_id, int level)
 {
-    uint8_t buf[100];
+    char buf[100];
     bool first = true;
     if (obj_id == 0) {
         printf("{");
     }
-    for (unsigned int i = 0; i < ts->num_objects; i++) {
-        if (ts->data_objects[i].parent == obj_id && ts->data_objects[i].type != TS_T_BYTES) {
-            if (!first) {
-                printf(",\n");
+    struct ts_data_object *child;
+    unsigned int iter = 0;
+    while ((child = ts_get_next_child(ts, obj_id, &iter)) != NULL) {
+        if (child->type == TS_T_BYTES) {
+            continue;
+        }
+        if (!first) {
+            printf(",\n");
+        }
+        else {
+            printf("\n");
+            first = false;
+        }
+        if (child->type == TS_T_GROUP) {
+            LOG_DBG("%*s\"%s\": {", 4 * (level + 1), "", child->name);
+            ts_dump_json(ts, child->id, level + 1);
+            LOG_DBG("\n%*s}", 4 * (level + 1), "");
+        }
+        else {
+            struct ts_json_writer w;
+            ts_json_writer_init(&w, buf, sizeof(buf));
+            ts_json_serialize_name_value(ts, &w, child);
+            if (ts_json_writer_finish(&w) > 0) {
+                LOG_DBG("%*s%s", 4 * (level + 1), "", buf);
             }
-            else {
-                printf("\n");
-                first = false;
+        }
+    }
+    if (obj_id == 0) {
+        LOG_DBG("\n}\n");
+    }
+}
+
+/* states of the JSON reader (expected next syntax element) */
+enum
+{
+    JSON_VALUE,       /* any value */
+    JSON_FIRST_VALUE, /* value or end of array */
+    JSON_KEY,         /* member name */
+    JSON_FIRST_KEY,   /* member name or end of object */
+    JSON_COLON,       /* colon after member name */
+    JSON_NEXT,        /* comma or end of array/object (or end of string at top level) */
+};
+
+/* maximum nesting depth supported by the bitmap in struct ts_json_reader */
+#define JSON_MAX_DEPTH 32
+
+void ts_json_reader_init(struct ts_json_reader *r, const char *str, size_t len)
+{
+    r->str = str;
+    r->len = len;
+    r->pos = 0;
+    r->objects = 0;
+    r->depth = 0;
+    r->state = JSON_VALUE;
+}
+
+static inline bool json_is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int json_read_string(struct ts_json_reader *r, struct ts_json_token *tok)
+{
+    size_t start = ++r->pos; // skip opening quotation mark
+
+    while (r->pos < r->len) {
+        char c = r->str[r->pos];
+        if (c == '"') {
+            tok->type = TS_JSON_STRING;
+            tok->start = &r->str[start];
+            tok->len = r->pos - start;
+            r->pos++;
+            return 0;
+        }
+        else if (c == '\\') {
+            r->pos++; // skip escaped character
+        }
+        else if ((unsigned char)c < 0x20) {
+            return -EINVAL;
+        }
+        r->pos++;
+    }
+
+    return -EINVAL; // unterminated string
+}
+
+static int json_read_primitive(struct ts_json_reader *r, struct ts_json_token *tok)
+{
+    size_t start = r->pos;
+
+    while (r->pos < r->len) {
+        char c = r->str[r->pos];
+        if (json_is_space(c) || c == ',' || c == ':' || c == ']' || c == '}') {
+            break;
+        }
+        else if ((unsigned char)c < 0x20 || c == '"' || c == '[' || c == '{') {
+            return -EINVAL;
+        }
+        r->pos++;
+    }
+
+    tok->type = TS_JSON_PRIMITIVE;
+    tok->start = &r->str[start];
+    tok->len = r->pos - start;
+    return 0;
+}
+
+int ts_json_next(struct ts_json_reader *r, struct ts_json_token *tok)
+{
+    while (true) {
+        while (r->pos < r->len && json_is_space(r->str[r->pos])) {
+            r->pos++;
+        }
+
+        bool in_object = r->depth > 0 && (r->objects & (1U << (r->depth - 1)));
+        char c = (r->pos < r->len) ? r->str[r->pos] : '\0';
+
+        tok->start = &r->str[r->pos];
+        tok->len = 0;
+
+        if (r->pos == r->len) {
+            if (r->depth == 0 && (r->state == JSON_VALUE || r->state == JSON_NEXT)) {
+                tok->type = TS_JSON_END;
+                return 0;
             }
-            if (ts->data_objects[i].type == TS_T_GROUP) {
-                LOG_DBG("%*s\"%s\": {", 4 * (level + 1), "", ts->data_objects[i].name);
-                ts_dump_json(ts, ts->data_objects[i].id, level + 1);
-                LOG_DBG("\n%*s}", 4 * (level + 1), "");
+            return -EINVAL;
+        }
+
+        if ((r->state == JSON_NEXT || r->state == JSON_FIRST_KEY || r->state == JSON_FIRST_VALUE)
+            && r->depth > 0 && c == (in_object ? '}' : ']'))
+        {
+            r->pos++;
+            r->depth--;
+            r->state = JSON_NEXT;
+            tok->type = in_object ? TS_JSON_OBJECT_END : TS_JSON_ARRAY_END;
+            return 0;
+        }
+
+        switch (r->state) {
+            case JSON_NEXT:
+                if (r->depth == 0 || c != ',') {
+                    return -EINVAL;
+                }
+                r->pos++;
+                r->state = in_object ? JSON_KEY : JSON_VALUE;
+                continue;
+            case JSON_COLON:
+                if (c != ':') {
+                    return -EINVAL;
+                }
+                r->pos++;
+                r->state = JSON_VALUE;
+                continue;
+            case JSON_KEY:
+            case JSON_FIRST_KEY:
+                if (c != '"') {
+                    return -EINVAL;
+                }
+                r->state = JSON_COLON;
+                return json_read_string(r, tok);
+            default:
+                break;
+        }
+
+        // any value expected
+        if (c == '{' || c == '[') {
+            if (r->depth >= JSON_MAX_DEPTH) {
+                return -ENOMEM;
+            }
+            if (c == '{') {
+                r->objects |= 1U << r->depth;
             }
             else {
-                int pos = ts_json_serialize_name_value(ts, (char *)buf, sizeof(buf),
-                                                       &ts->data_objects[i]);
-                if (pos > 0) {
-                    buf[pos - 1] = '\0'; // remove trailing comma
-                    LOG_DBG("%*s%s", 4 * (level + 1), "", (char *)buf);
-                }
+                r->objects &= ~(1U << r->depth);
             }
+            r->depth++;
+            r->pos++;
+            r->state = (c == '{') ? JSON_FIRST_KEY : JSON_FIRST_VALUE;
+            tok->type = (c == '{') ? TS_JSON_OBJECT : TS_JSON_ARRAY;
+            tok->len = 1;
+            return 0;
+        }
+
+        r->state = JSON_NEXT;
+        if (c == '"') {
+            return json_read_string(r, tok);
+        }
+        else {
+            int err = json_read_primitive(r, tok);
+            return (err == 0 && tok->len == 0) ? -EINVAL : err;
         }
-    }
-    if (obj_id == 0) {
-        LOG_DBG("\n}\n");
     }
 }
 
 int ts_txt_process(struct ts_context *ts)
 {
     int path_len = ts->req_len - 1;
-    char *path_end = strchr((char *)ts->req + 1, ' ');
+    const uint8_t *path_end = memchr(ts->req + 1, ' ', ts->req_len - 1);
     if (path_end) {
-        path_len = (uint8_t *)path_end - ts->req - 1;
+        path_len = path_end - ts->req - 1;
     }
 
     int record_index = RECORD_INDEX_NONE;
@@ -339,21 +748,17 @@ int ts_txt_process(struct ts_context *ts)
         }
     }
 
-    jsmn_parser parser;
-    jsmn_init(&parser);
-
     ts->json_str = (char *)ts->req + 1 + path_len;
-    ts->tok_count = jsmn_parse(&parser, ts->json_str, ts->req_len - path_len - 1, ts->tokens,
-                               sizeof(ts->tokens));
+    ts->json_len = ts->req_len - path_len - 1;
 
-    if (ts->tok_count == JSMN_ERROR_NOMEM) {
-        return ts_txt_response(ts, TS_STATUS_REQUEST_TOO_LARGE);
-    }
-    else if (ts->tok_count < 0) {
-        // other parsing error
+    // the payload is parsed by the request handlers, only check if there is any
+    struct ts_json_reader reader;
+    struct ts_json_token tok;
+    ts_json_reader_init(&reader, ts->json_str, ts->json_len);
+    if (ts_json_next(&reader, &tok) != 0) {
         return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
     }
-    else if (ts->tok_count == 0) {
+    else if (tok.type == TS_JSON_END) {
         if (ts->req[0] == '?') {
             // no payload data
             if ((char)ts->req[path_len] == '/') {
@@ -403,129 +808,381 @@ int ts_txt_process(struct ts_context *ts)
             return ts_txt_delete(ts, endpoint);
         }
     }
-    return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+    return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+}
+
+int ts_txt_fetch(struct ts_context *ts, const struct ts_data_object *endpoint)
+{
+    struct ts_json_writer w;
+    struct ts_json_reader r;
+    struct ts_json_token tok;
+
+    ts_object_id_t endpoint_id = (endpoint == NULL) ? 0 : endpoint->id;
+
+    ts_json_reader_init(&r, ts->json_str, ts->json_len);
+    if (ts_json_next(&r, &tok) != 0) {
+        return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+    }
+    const bool array = (tok.type == TS_JSON_ARRAY);
+
+    // initialize response with success message
+    int pos = ts_txt_response(ts, TS_STATUS_CONTENT);
+
+    ts_json_writer_init(&w, (char *)&ts->resp[pos], ts->resp_size - pos);
+    json_char(&w, ' ');
+    if (array) {
+        json_begin(&w, '[');
+        if (ts_json_next(&r, &tok) != 0) {
+            return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+        }
+    }
+
+    while (tok.type != TS_JSON_END && tok.type != TS_JSON_ARRAY_END) {
+
+        if (tok.type != TS_JSON_STRING) {
+            return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+        }
+
+        const struct ts_data_object *object =
+            ts_get_object_by_name(ts, tok.start, tok.len, endpoint_id);
+
+        if (object == NULL) {
+            return ts_txt_response(ts, TS_STATUS_NOT_FOUND);
+        }
+        else if (object->type == TS_T_GROUP) {
+            // bad request, as we can't read internal path object's values
+            return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+        }
+
+        if ((object->access & TS_READ_MASK & ts->_auth_flags) == 0) {
+            if (object->access & TS_READ_MASK) {
+                return ts_txt_response(ts, TS_STATUS_UNAUTHORIZED);
+            }
+            else {
+                return ts_txt_response(ts, TS_STATUS_FORBIDDEN);
+            }
+        }
+
+        ts_json_serialize_value(ts, &w, object);
+
+        if (ts_json_next(&r, &tok) != 0) {
+            return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+        }
+    }
+
+    if (array) {
+        json_end(&w, ']');
+        if (ts_json_next(&r, &tok) != 0 || tok.type != TS_JSON_END) {
+            return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+        }
+    }
+
+    return txt_response_payload(ts, pos, &w);
+}
+
+/* decimal number as parsed from JSON: value = (-1)^negative * mantissa * 10^exponent */
+struct txt_number
+{
+    uint64_t mantissa;
+    int exponent;
+    bool negative;
+    bool overflow; /* integer digits didn't fit into the mantissa */
+};
+
+/* maximum number of decimal digits which always fit into the uint64_t mantissa */
+#define TXT_MANTISSA_DIGITS 19
+
+/* maximum accepted length of a number token, limiting the time spent for parsing */
+#define TXT_NUMBER_MAX_LEN 32
+
+static const double txt_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/*
+ * Parses a number from the token span without requiring NUL termination and independent of the
+ * locale. Integers may also be given in hexadecimal notation with 0x prefix.
+ *
+ * Returns 0 for success, -EINVAL for an invalid format or -ERANGE if the exponent is out of range.
+ */
+static int txt_parse_number(const char *buf, size_t len, struct txt_number *num)
+{
+    const char *end = buf + len;
+    bool digits = false;
+
+    num->mantissa = 0;
+    num->exponent = 0;
+    num->negative = false;
+    num->overflow = false;
+
+    if (buf < end && (*buf == '-' || *buf == '+')) {
+        num->negative = (*buf == '-');
+        buf++;
+    }
+
+    if (end - buf > 2 && buf[0] == '0' && (buf[1] == 'x' || buf[1] == 'X')) {
+        for (buf += 2; buf < end; buf++) {
+            uint8_t c = *buf;
+            uint8_t nibble = (c >= '0' && c <= '9')   ? c - '0'
+                             : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                             : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+                                                      : 16;
+            if (nibble > 15) {
+                return -EINVAL;
+            }
+            else if (num->mantissa >> 60) {
+                return -ERANGE;
+            }
+            num->mantissa = num->mantissa << 4 | nibble;
+        }
+        return 0;
+    }
+
+    bool fraction = false;
+    for (; buf < end; buf++) {
+        if (*buf >= '0' && *buf <= '9') {
+            unsigned int digit = *buf - '0';
+            digits = true;
+            if (num->mantissa < UINT64_MAX / 10
+                || (num->mantissa == UINT64_MAX / 10 && digit <= UINT64_MAX % 10))
+            {
+                num->mantissa = num->mantissa * 10 + digit;
+                num->exponent -= fraction;
+            }
+            else {
+                // further digits don't fit into the mantissa and are ignored
+                num->exponent += !fraction;
+                num->overflow |= !fraction;
+            }
+        }
+        else if (*buf == '.' && !fraction) {
+            fraction = true;
+        }
+        else {
+            break;
+        }
+    }
+
+    if (!digits) {
+        return -EINVAL;
+    }
+
+    if (buf < end && (*buf == 'e' || *buf == 'E')) {
+        bool exp_negative = false;
+        int exp = 0;
+        buf++;
+        if (buf < end && (*buf == '-' || *buf == '+')) {
+            exp_negative = (*buf == '-');
+            buf++;
+        }
+        if (buf == end) {
+            return -EINVAL;
+        }
+        for (; buf < end && *buf >= '0' && *buf <= '9'; buf++) {
+            if (exp > 9999) {
+                return -ERANGE;
+            }
+            exp = exp * 10 + (*buf - '0');
+        }
+        num->exponent += exp_negative ? -exp : exp;
+    }
+
+    return (buf == end) ? 0 : -EINVAL;
 }
 
-int ts_txt_fetch(struct ts_context *ts, const struct ts_data_object *endpoint)
+/* converts a parsed number into the absolute value of an integer, truncating the fraction */
+static int txt_number_to_int(const struct txt_number *num, int64_t min, uint64_t max,
+                             uint64_t *abs)
 {
-    int pos = 0;
-    int tok = 0; // current token
+    uint64_t value = num->mantissa;
 
-    ts_object_id_t endpoint_id = (endpoint == NULL) ? 0 : endpoint->id;
+    if (num->overflow) {
+        return -ERANGE;
+    }
 
-    // initialize response with success message
-    pos += ts_txt_response(ts, TS_STATUS_CONTENT);
+    for (int i = num->exponent; i < 0 && value > 0; i++) {
+        value /= 10;
+    }
+    for (int i = 0; i < num->exponent && value > 0; i++) {
+        if (value > UINT64_MAX / 10) {
+            return -ERANGE;
+        }
+        value *= 10;
+    }
 
-    if (ts->tokens[0].type == JSMN_ARRAY) {
-        pos += snprintf((char *)&ts->resp[pos], ts->resp_size - pos, " [");
-        tok++;
+    if (num->negative ? (value > (uint64_t)-(min + 1) + 1) : (value > max)) {
+        return -ERANGE;
     }
-    else {
-        pos += snprintf((char *)&ts->resp[pos], ts->resp_size - pos, " ");
+
+    *abs = value;
+    return 0;
+}
+
+static int txt_number_to_float(const struct txt_number *num, float *value)
+{
+    if (num->mantissa == 0) {
+        *value = num->negative ? -0.0F : 0.0F;
+        return 0;
     }
 
-    while (tok < ts->tok_count) {
+    if (num->mantissa <= (1U << 24) && num->exponent >= -10 && num->exponent <= 10) {
+        // mantissa and power of 10 are exact in a float, so one operation rounds correctly
+        float f = (float)num->mantissa;
+        f = (num->exponent < 0) ? f / (float)txt_pow10[-num->exponent]
+                                : f * (float)txt_pow10[num->exponent];
+        *value = num->negative ? -f : f;
+        return 0;
+    }
 
-        if (ts->tokens[tok].type != JSMN_STRING) {
-            return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
-        }
+    const int max_exp = sizeof(txt_pow10) / sizeof(txt_pow10[0]) - 1;
+    double d = (double)num->mantissa;
+    int exp = num->exponent;
+    while (exp > max_exp && d < 1e300) {
+        d *= txt_pow10[max_exp];
+        exp -= max_exp;
+    }
+    while (exp < -max_exp && d > 1e-300) {
+        d /= txt_pow10[max_exp];
+        exp += max_exp;
+    }
+    if (exp > max_exp || exp < -max_exp) {
+        d = (exp > 0) ? INFINITY : 0.0;
+    }
+    else {
+        d = (exp < 0) ? d / txt_pow10[-exp] : d * txt_pow10[exp];
+    }
 
-        const struct ts_data_object *object =
-            ts_get_object_by_name(ts, ts->json_str + ts->tokens[tok].start,
-                                  ts->tokens[tok].end - ts->tokens[tok].start, endpoint_id);
+    if (d > FLT_MAX) {
+        return -ERANGE;
+    }
 
-        if (object == NULL) {
-            return ts_txt_response(ts, TS_STATUS_NOT_FOUND);
-        }
-        else if (object->type == TS_T_GROUP) {
-            // bad request, as we can't read internal path object's values
-            return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
-        }
+    *value = num->negative ? -(float)d : (float)d;
+    return 0;
+}
 
-        if ((object->access & TS_READ_MASK & ts->_auth_flags) == 0) {
-            if (object->access & TS_READ_MASK) {
-                return ts_txt_response(ts, TS_STATUS_UNAUTHORIZED);
-            }
-            else {
-                return ts_txt_response(ts, TS_STATUS_FORBIDDEN);
-            }
-        }
+#if CONFIG_THINGSET_DECFRAC_TYPE_SUPPORT
 
-        pos += ts_json_serialize_value(ts, (char *)&ts->resp[pos], ts->resp_size - pos, object);
+/* converts a parsed number into the mantissa of a decimal fraction with given exponent */
+static int txt_number_to_decfrac(const struct txt_number *num, int exponent, int32_t *value)
+{
+    int shift = num->exponent - exponent;
+    uint64_t abs = num->mantissa;
 
-        if (pos >= ts->resp_size - 2) {
-            return ts_txt_response(ts, TS_STATUS_RESPONSE_TOO_LARGE);
+    if (shift < -TXT_MANTISSA_DIGITS) {
+        abs = 0;
+    }
+    else if (shift < 0) {
+        // round half away from zero
+        uint64_t div = 1;
+        for (int i = shift; i < 0; i++) {
+            div *= 10;
         }
-        tok++;
+        abs = abs / div + (abs % div >= div / 2);
     }
-
-    pos--; // remove trailing comma
-    if (ts->tokens[0].type == JSMN_ARRAY) {
-        // buffer will be long enough as we dropped last 2 characters --> sprintf allowed
-        pos += sprintf((char *)&ts->resp[pos], "]");
+    for (int i = 0; i < shift && abs > 0; i++) {
+        if (abs > INT32_MAX) {
+            return -ERANGE;
+        }
+        abs *= 10;
     }
-    else {
-        ts->resp[pos] = '\0'; // terminate string
+
+    if (abs > (num->negative ? (uint64_t)INT32_MAX + 1 : INT32_MAX)) {
+        return -ERANGE;
     }
 
-    return pos;
+    *value = num->negative ? (int32_t)(0 - abs) : (int32_t)abs;
+    return 0;
 }
 
-int ts_json_deserialize_value(struct ts_context *ts, char *buf, size_t len, jsmntype_t type,
-                              const struct ts_data_object *object)
+#endif /* CONFIG_THINGSET_DECFRAC_TYPE_SUPPORT */
+
+int ts_json_deserialize_value(struct ts_context *ts, const char *buf, size_t len,
+                              enum ts_json_type type, const struct ts_data_object *object)
 {
-#if CONFIG_THINGSET_DECFRAC_TYPE_SUPPORT
-    float tmp;
-#endif
+    struct txt_number num;
+    uint64_t abs;
+    int err = 0;
 
-    if (type != JSMN_PRIMITIVE && type != JSMN_STRING) {
+    if (type != TS_JSON_PRIMITIVE && type != TS_JSON_STRING) {
         return 0;
     }
 
-    errno = 0;
     switch (object->type) {
         case TS_T_FLOAT32:
-            *((float *)object->data) = strtod(buf, NULL);
+        case TS_T_DECFRAC:
+        case TS_T_UINT64:
+        case TS_T_INT64:
+        case TS_T_UINT32:
+        case TS_T_INT32:
+        case TS_T_UINT16:
+        case TS_T_INT16:
+        case TS_T_UINT8:
+        case TS_T_INT8:
+            if (len > TXT_NUMBER_MAX_LEN || txt_parse_number(buf, len, &num) != 0) {
+                return 0;
+            }
+            break;
+    }
+
+    switch (object->type) {
+        case TS_T_FLOAT32:
+            err = txt_number_to_float(&num, (float *)object->data);
             break;
 #if CONFIG_THINGSET_DECFRAC_TYPE_SUPPORT
         case TS_T_DECFRAC:
-            tmp = strtod(buf, NULL);
-            // positive exponent
-            for (int16_t i = 0; i < object->detail; i++) {
-                tmp /= 10.0F;
-            }
-            // negative exponent
-            for (int16_t i = 0; i > object->detail; i--) {
-                tmp *= 10.0F;
-            }
-            *((int32_t *)object->data) = (int32_t)tmp;
+            err = txt_number_to_decfrac(&num, object->detail, (int32_t *)object->data);
             break;
 #endif
 #if CONFIG_THINGSET_64BIT_TYPES_SUPPORT
         case TS_T_UINT64:
-            *((uint64_t *)object->data) = strtoull(buf, NULL, 0);
+            err = txt_number_to_int(&num, 0, UINT64_MAX, &abs);
+            if (err == 0) {
+                *((uint64_t *)object->data) = abs;
+            }
             break;
         case TS_T_INT64:
-            *((int64_t *)object->data) = strtoll(buf, NULL, 0);
+            err = txt_number_to_int(&num, INT64_MIN, INT64_MAX, &abs);
+            if (err == 0) {
+                *((int64_t *)object->data) = num.negative ? 0 - abs : abs;
+            }
             break;
 #endif
         case TS_T_UINT32:
-            *((uint32_t *)object->data) = strtoul(buf, NULL, 0);
+            err = txt_number_to_int(&num, 0, UINT32_MAX, &abs);
+            if (err == 0) {
+                *((uint32_t *)object->data) = abs;
+            }
             break;
         case TS_T_INT32:
-            *((int32_t *)object->data) = strtol(buf, NULL, 0);
+            err = txt_number_to_int(&num, INT32_MIN, INT32_MAX, &abs);
+            if (err == 0) {
+                *((int32_t *)object->data) = num.negative ? 0 - abs : abs;
+            }
             break;
         case TS_T_UINT16:
-            *((uint16_t *)object->data) = strtoul(buf, NULL, 0);
+            err = txt_number_to_int(&num, 0, UINT16_MAX, &abs);
+            if (err == 0) {
+                *((uint16_t *)object->data) = abs;
+            }
             break;
         case TS_T_INT16:
-            *((uint16_t *)object->data) = strtol(buf, NULL, 0);
+            err = txt_number_to_int(&num, INT16_MIN, INT16_MAX, &abs);
+            if (err == 0) {
+                *((int16_t *)object->data) = num.negative ? 0 - abs : abs;
+            }
             break;
         case TS_T_UINT8:
-            *((uint8_t *)object->data) = strtoul(buf, NULL, 0);
+            err = txt_number_to_int(&num, 0, UINT8_MAX, &abs);
+            if (err == 0) {
+                *((uint8_t *)object->data) = abs;
+            }
             break;
         case TS_T_INT8:
-            *((uint8_t *)object->data) = strtol(buf, NULL, 0);
+            err = txt_number_to_int(&num, INT8_MIN, INT8_MAX, &abs);
+            if (err == 0) {
+                *((int8_t *)object->data) = num.negative ? 0 - abs : abs;
+            }
             break;
         case TS_T_BOOL:
             if (buf[0] == 't' || buf[0] == '1') {
@@ -539,7 +1196,7 @@ int ts_json_deserialize_value(struct ts_context *ts, char *buf, size_t len, jsmn
             }
             break;
         case TS_T_STRING:
-            if (type != JSMN_STRING || (unsigned int)object->detail <= len) {
+            if (type != TS_JSON_STRING || (unsigned int)object->detail <= len) {
                 return 0;
             }
             else if (object->id != 0) { // dummy object has id = 0
@@ -549,7 +1206,7 @@ int ts_json_deserialize_value(struct ts_context *ts, char *buf, size_t len, jsmn
             break;
         case TS_T_BYTES:
 #ifdef CONFIG_BASE64 /* Zephyr only */
-            if (type != JSMN_STRING || (unsigned int)object->detail < len / 4 * 3) {
+            if (type != TS_JSON_STRING || (unsigned int)object->detail < len / 4 * 3) {
                 return 0;
             }
             else if (object->id != 0) { // dummy object has id = 0
@@ -568,99 +1225,118 @@ int ts_json_deserialize_value(struct ts_context *ts, char *buf, size_t len, jsmn
 #endif
     }
 
-    if (errno == ERANGE) {
+    if (err != 0) {
         return 0;
     }
 
     return 1; // value always contained in one token (arrays not yet supported)
 }
 
-int ts_txt_patch(struct ts_context *ts, const struct ts_data_object *endpoint)
+/*
+ * Walks through the JSON object in the payload of a PATCH request and either only validates the
+ * values or writes them to the data objects. Nested JSON objects are resolved against the children
+ * of the group with the same name, so that values of multiple groups can be updated at once. The
+ * callbacks of nested groups are called after their values were written, the callback of the
+ * endpoint itself is handled by the caller.
+ *
+ * Returns 0 on success or the ThingSet status code of the first error.
+ */
+static int txt_patch_values(struct ts_context *ts, const struct ts_data_object *endpoint,
+                            bool write, bool *updated)
 {
-    int tok = 0; // current token
-    bool updated = false;
-
-    // buffer for data object value (largest negative 64bit integer has 20 digits)
-    char value_buf[21];
-    size_t value_len; // length of value in buffer
+    /* the reader limits the nesting, so each open JSON object has an entry in this stack */
+    const struct ts_data_object *parents[JSON_MAX_DEPTH];
+    struct ts_json_reader r;
+    struct ts_json_token name;
+    struct ts_json_token value;
+    int depth = 0;
+    int num_values = 0;
 
-    ts_object_id_t endpoint_id = (endpoint == NULL) ? 0 : endpoint->id;
+    ts_json_reader_init(&r, ts->json_str, ts->json_len);
+    if (ts_json_next(&r, &name) != 0 || name.type != TS_JSON_OBJECT) {
+        return TS_STATUS_BAD_REQUEST;
+    }
+    parents[depth++] = endpoint;
 
-    if (ts->tok_count < 2) {
-        if (ts->tok_count == JSMN_ERROR_NOMEM) {
-            return ts_txt_response(ts, TS_STATUS_REQUEST_TOO_LARGE);
+    while (depth > 0) {
+        if (ts_json_next(&r, &name) != 0) {
+            return TS_STATUS_BAD_REQUEST;
         }
-        else {
-            return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+        else if (name.type == TS_JSON_OBJECT_END) {
+            const struct ts_data_object *group = parents[--depth];
+            if (write && depth > 0 && group->data != NULL) {
+                void (*fun)(void) = (void (*)(void))group->data;
+                fun();
+            }
+            continue;
         }
-    }
 
-    if (ts->tokens[0].type == JSMN_OBJECT) { // object = map
-        tok++;
-    }
-
-    // loop through all elements to check if request is valid
-    while (tok + 1 < ts->tok_count) {
-
-        if (ts->tokens[tok].type != JSMN_STRING
-            || (ts->tokens[tok + 1].type != JSMN_PRIMITIVE
-                && ts->tokens[tok + 1].type != JSMN_STRING))
-        {
-            return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+        if (ts_json_next(&r, &value) != 0) {
+            return TS_STATUS_BAD_REQUEST;
         }
 
+        const struct ts_data_object *parent = parents[depth - 1];
         const struct ts_data_object *object =
-            ts_get_object_by_name(ts, ts->json_str + ts->tokens[tok].start,
-                                  ts->tokens[tok].end - ts->tokens[tok].start, endpoint_id);
+            ts_get_object_by_name(ts, name.start, name.len, parent == NULL ? 0 : parent->id);
 
         if (object == NULL) {
-            return ts_txt_response(ts, TS_STATUS_NOT_FOUND);
+            return TS_STATUS_NOT_FOUND;
+        }
+
+        if (value.type == TS_JSON_OBJECT) {
+            if (object->type != TS_T_GROUP) {
+                return TS_STATUS_BAD_REQUEST;
+            }
+            parents[depth++] = object;
+            continue;
+        }
+        else if (value.type != TS_JSON_STRING && value.type != TS_JSON_PRIMITIVE) {
+            return TS_STATUS_BAD_REQUEST;
+        }
+
+        if (write) {
+            // values were already validated in the first pass
+            ts_json_deserialize_value(ts, value.start, value.len, value.type, object);
+            if (ts_owner(ts)->_update_subsets & object->subsets) {
+                *updated = true;
+            }
+            continue;
         }
 
         if ((object->access & TS_WRITE_MASK & ts->_auth_flags) == 0) {
             if (object->access & TS_WRITE_MASK) {
-                return ts_txt_response(ts, TS_STATUS_UNAUTHORIZED);
+                return TS_STATUS_UNAUTHORIZED;
             }
             else {
-                return ts_txt_response(ts, TS_STATUS_FORBIDDEN);
+                return TS_STATUS_FORBIDDEN;
             }
         }
 
-        tok++;
+        num_values++;
 
-        // extract the value and check buffer lengths
-        value_len = ts->tokens[tok].end - ts->tokens[tok].start;
+        // check buffer lengths
         if (object->type == TS_T_STRING) {
-            if (value_len < (size_t)object->detail) {
+            if (value.len < (size_t)object->detail) {
                 // provided string fits into data object buffer
-                tok += 1;
                 continue;
             }
             else {
-                return ts_txt_response(ts, TS_STATUS_REQUEST_TOO_LARGE);
+                return TS_STATUS_REQUEST_TOO_LARGE;
             }
         }
         else if (object->type == TS_T_BYTES) {
 #ifdef CONFIG_BASE64 /* Zephyr only */
-            if (value_len / 4 * 3 <= (size_t)object->detail) {
+            if (value.len / 4 * 3 <= (size_t)object->detail) {
                 // decoded base64-encoded string fits into data object buffer
-                tok += 1;
                 continue;
             }
             else {
-                return ts_txt_response(ts, TS_STATUS_REQUEST_TOO_LARGE);
+                return TS_STATUS_REQUEST_TOO_LARGE;
             }
 #else
-            return ts_txt_response(ts, TS_STATUS_UNSUPPORTED_FORMAT);
+            return TS_STATUS_UNSUPPORTED_FORMAT;
 #endif
         }
-        else if (value_len >= sizeof(value_buf)) {
-            return ts_txt_response(ts, TS_STATUS_UNSUPPORTED_FORMAT);
-        }
-        else {
-            strncpy(value_buf, &ts->json_str[ts->tokens[tok].start], value_len);
-            value_buf[value_len] = '\0';
-        }
 
         // create dummy object to test formats
         uint8_t dummy_data[8]; // enough to fit also 64-bit values
@@ -668,47 +1344,36 @@ int ts_txt_patch(struct ts_context *ts, const struct ts_data_object *endpoint)
             0, 0, "Dummy", (void *)dummy_data, object->type, object->detail
         };
 
-        int res = ts_json_deserialize_value(ts, value_buf, value_len, ts->tokens[tok].type,
-                                            &dummy_object);
-        if (res == 0) {
-            return ts_txt_response(ts, TS_STATUS_UNSUPPORTED_FORMAT);
+        if (ts_json_deserialize_value(ts, value.start, value.len, value.type, &dummy_object) == 0) {
+            return TS_STATUS_UNSUPPORTED_FORMAT;
         }
-        tok += res;
     }
 
-    if (ts->tokens[0].type == JSMN_OBJECT) {
-        tok = 1;
-    }
-    else {
-        tok = 0;
+    if (ts_json_next(&r, &name) != 0 || name.type != TS_JSON_END) {
+        return TS_STATUS_BAD_REQUEST;
     }
 
-    // actually write data
-    while (tok + 1 < ts->tok_count) {
-
-        const struct ts_data_object *object =
-            ts_get_object_by_name(ts, ts->json_str + ts->tokens[tok].start,
-                                  ts->tokens[tok].end - ts->tokens[tok].start, endpoint_id);
-
-        tok++;
+    if (!write && num_values == 0) {
+        return TS_STATUS_BAD_REQUEST;
+    }
 
-        // extract the value again (max. size was checked before)
-        value_len = ts->tokens[tok].end - ts->tokens[tok].start;
-        if (value_len < sizeof(value_buf)) {
-            strncpy(value_buf, &ts->json_str[ts->tokens[tok].start], value_len);
-            value_buf[value_len] = '\0';
-        }
+    return 0;
+}
 
-        tok += ts_json_deserialize_value(ts, &ts->json_str[ts->tokens[tok].start], value_len,
-                                         ts->tokens[tok].type, object);
+int ts_txt_patch(struct ts_context *ts, const struct ts_data_object *endpoint)
+{
+    bool updated = false;
 
-        if (ts->_update_subsets & object->subsets) {
-            updated = true;
-        }
+    // check the entire request first, so that either all or none of the values are written
+    int status = txt_patch_values(ts, endpoint, false, NULL);
+    if (status != 0) {
+        return ts_txt_response(ts, status);
     }
 
-    if (updated && ts->update_cb != NULL) {
-        ts->update_cb();
+    txt_patch_values(ts, endpoint, true, &updated);
+
+    if (updated && ts_owner(ts)->update_cb != NULL) {
+        ts_owner(ts)->update_cb();
     }
 
     return ts_txt_response(ts, TS_STATUS_CHANGED);
@@ -717,11 +1382,15 @@ int ts_txt_patch(struct ts_context *ts, const struct ts_data_object *endpoint)
 int ts_txt_get(struct ts_context *ts, const struct ts_data_object *endpoint, uint32_t ret_type,
                int record_index)
 {
+    struct ts_json_writer w;
     bool include_values = (ret_type & TS_RET_VALUES);
 
     // initialize response with success message
     size_t len = ts_txt_response(ts, TS_STATUS_CONTENT);
 
+    ts_json_writer_init(&w, (char *)&ts->resp[len], ts->resp_size - len);
+    json_char(&w, ' ');
+
     ts_object_id_t endpoint_id = 0;
 
     if (endpoint != NULL) {
@@ -737,76 +1406,125 @@ int ts_txt_get(struct ts_context *ts, const struct ts_data_object *endpoint, uin
                 break;
             case TS_T_RECORDS:
                 if (ret_type == TS_RET_NAMES || record_index == RECORD_INDEX_NONE) {
-                    struct ts_records *records = (struct ts_records *)endpoint->data;
-                    len += snprintf((char *)&ts->resp[len], ts->resp_size - len, " %d",
-                                    records->num_records);
-                    return len;
+                    // number of records
+                    ts_json_serialize_value(ts, &w, endpoint);
+                    return txt_response_payload(ts, len, &w);
                 }
                 break;
             default:
                 // get value of data object
-                ts->resp[len++] = ' ';
-                len += ts_json_serialize_value(ts, (char *)&ts->resp[len], ts->resp_size - len,
-                                               endpoint);
-                ts->resp[--len] = '\0'; // remove trailing comma again
-                return len;
+                ts_json_serialize_value(ts, &w, endpoint);
+                return txt_response_payload(ts, len, &w);
         }
         endpoint_id = endpoint->id;
     }
 
-    len += sprintf((char *)&ts->resp[len], include_values ? " {" : " [");
-    int objects_found = 0;
+    json_begin(&w, include_values ? '{' : '[');
+
+    if (ts->chunk.active) {
+        // child objects are serialized one by one in ts_txt_get_next
+        ts->chunk.endpoint = endpoint;
+        ts->chunk.ret_type = ret_type;
+        ts->chunk.record_index = record_index;
+        ts->chunk.iter = 0;
+        ts->chunk.num_elements = 0;
+        ts->chunk.elements = true;
+        return txt_response_payload(ts, len, &w);
+    }
+
     if (endpoint && endpoint->type == TS_T_RECORDS) {
-        int record_len = ts_json_serialize_record(ts, (char *)ts->resp + len, ts->resp_size - len,
-                                                  endpoint, record_index, &objects_found);
-        if (record_len > 0) {
-            len += record_len;
-        }
-        else {
+        if (json_serialize_record(ts, &w, endpoint, record_index) == 0) {
             return 0;
         }
     }
     else {
-        for (unsigned int i = 0; i < ts->num_objects; i++) {
-            if ((ts->data_objects[i].access & TS_READ_MASK)
-                && (ts->data_objects[i].parent == endpoint_id))
-            {
-                if (include_values) {
-                    int ret = ts_json_serialize_name_value(
-                        ts, (char *)&ts->resp[len], ts->resp_size - len, &ts->data_objects[i]);
-                    if (ret > 0) {
-                        len += ret;
-                    }
-                    else {
-                        return ts_txt_response(ts, TS_STATUS_RESPONSE_TOO_LARGE);
-                    }
-                }
-                else {
-                    len += snprintf((char *)&ts->resp[len], ts->resp_size - len, "\"%s\",",
-                                    ts->data_objects[i].name);
-                }
-                objects_found++;
+        struct ts_data_object *child;
+        unsigned int iter = 0;
+        while ((child = ts_get_next_child(ts, endpoint_id, &iter)) != NULL && !w.overflow) {
+            if (!(child->access & TS_READ_MASK)) {
+                continue;
+            }
+            if (include_values) {
+                ts_json_serialize_name_value(ts, &w, child);
+            }
+            else {
+                json_string(&w, child->name);
+            }
+        }
+    }
 
-                if (len >= ts->resp_size - 1) {
-                    return ts_txt_response(ts, TS_STATUS_RESPONSE_TOO_LARGE);
-                }
+    json_end(&w, include_values ? '}' : ']');
+
+    return txt_response_payload(ts, len, &w);
+}
+
+int ts_txt_get_next(struct ts_context *ts)
+{
+    struct ts_chunk_state *chunk = &ts->chunk;
+    const struct ts_data_object *endpoint = chunk->endpoint;
+    const struct ts_data_object *child = NULL;
+    struct ts_json_writer w;
+
+    ts_json_writer_init(&w, (char *)chunk->scratch, chunk->scratch_size);
+    w.separator = (chunk->num_elements > 0);
+
+    if (endpoint && endpoint->type == TS_T_RECORDS) {
+        /* record item definitions are expected to start behind endpoint data object */
+        const struct ts_data_object *item = endpoint + 1 + chunk->iter;
+        if (item < &ts->data_objects[ts->num_objects] && item->parent == endpoint->id) {
+            json_serialize_record_item(&w, endpoint, item, chunk->record_index);
+            chunk->iter++;
+            child = item;
+        }
+    }
+    else {
+        ts_object_id_t endpoint_id = endpoint ? endpoint->id : 0;
+        while ((child = ts_get_next_child(ts, endpoint_id, &chunk->iter)) != NULL) {
+            if (!(child->access & TS_READ_MASK)) {
+                continue;
+            }
+            if (chunk->ret_type & TS_RET_VALUES) {
+                ts_json_serialize_name_value(ts, &w, child);
+            }
+            else {
+                json_string(&w, child->name);
             }
+            break;
         }
     }
 
-    // remove trailing comma and add closing bracket
-    if (objects_found == 0) {
-        len++;
+    if (child == NULL) {
+        // all child objects serialized, so only the closing bracket is missing
+        chunk->elements = false;
+        json_end(&w, (chunk->ret_type & TS_RET_VALUES) ? '}' : ']');
+    }
+    else {
+        chunk->num_elements++;
     }
-    ts->resp[len - 1] = include_values ? '}' : ']';
-    ts->resp[len] = '\0';
 
-    return len;
+    int len = ts_json_writer_finish(&w);
+    return (len > 0) ? len : -ENOMEM;
+}
+
+/* reads a payload consisting of a single JSON value, returns -EINVAL if there is more */
+static int txt_read_single_value(struct ts_context *ts, struct ts_json_token *tok)
+{
+    struct ts_json_reader r;
+    struct ts_json_token end;
+
+    ts_json_reader_init(&r, ts->json_str, ts->json_len);
+    if (ts_json_next(&r, tok) != 0 || ts_json_next(&r, &end) != 0 || end.type != TS_JSON_END) {
+        return -EINVAL;
+    }
+
+    return 0;
 }
 
 int ts_txt_create(struct ts_context *ts, const struct ts_data_object *object)
 {
-    if (ts->tok_count > 1) {
+    struct ts_json_token tok;
+
+    if (txt_read_single_value(ts, &tok) != 0) {
         // only single JSON primitive supported at the moment
         return ts_txt_response(ts, TS_STATUS_NOT_IMPLEMENTED);
     }
@@ -817,17 +1535,15 @@ int ts_txt_create(struct ts_context *ts, const struct ts_data_object *object)
     }
 #ifndef CONFIG_THINGSET_IMMUTABLE_OBJECTS /* Zephyr only */
     else if (object->type == TS_T_SUBSET) {
-        if (ts->tokens[0].type == JSMN_STRING) {
+        if (tok.type == TS_JSON_STRING) {
 #if CONFIG_THINGSET_NESTED_JSON
-            struct ts_data_object *add_object = ts_get_object_by_path(
-                ts, ts->json_str + ts->tokens[0].start, ts->tokens[0].end - ts->tokens[0].start);
+            struct ts_data_object *add_object = ts_get_object_by_path(ts, tok.start, tok.len);
 #else
-            struct ts_data_object *add_object =
-                ts_get_object_by_name(ts, ts->json_str + ts->tokens[0].start,
-                                      ts->tokens[0].end - ts->tokens[0].start, -1);
+            struct ts_data_object *add_object = ts_get_object_by_name(ts, tok.start, tok.len, -1);
 #endif
             if (add_object != NULL) {
                 add_object->subsets |= (uint16_t)object->detail;
+                ts_index_update_subsets(ts);
                 return ts_txt_response(ts, TS_STATUS_CREATED);
             }
             return ts_txt_response(ts, TS_STATUS_NOT_FOUND);
@@ -840,7 +1556,9 @@ int ts_txt_create(struct ts_context *ts, const struct ts_data_object *object)
 
 int ts_txt_delete(struct ts_context *ts, const struct ts_data_object *object)
 {
-    if (ts->tok_count > 1) {
+    struct ts_json_token tok;
+
+    if (txt_read_single_value(ts, &tok) != 0) {
         // only single JSON primitive supported at the moment
         return ts_txt_response(ts, TS_STATUS_NOT_IMPLEMENTED);
     }
@@ -851,17 +1569,15 @@ int ts_txt_delete(struct ts_context *ts, const struct ts_data_object *object)
     }
 #ifndef CONFIG_THINGSET_IMMUTABLE_OBJECTS /* Zephyr only */
     else if (object->type == TS_T_SUBSET) {
-        if (ts->tokens[0].type == JSMN_STRING) {
+        if (tok.type == TS_JSON_STRING) {
 #if CONFIG_THINGSET_NESTED_JSON
-            struct ts_data_object *del_object = ts_get_object_by_path(
-                ts, ts->json_str + ts->tokens[0].start, ts->tokens[0].end - ts->tokens[0].start);
+            struct ts_data_object *del_object = ts_get_object_by_path(ts, tok.start, tok.len);
 #else
-            struct ts_data_object *del_object =
-                ts_get_object_by_name(ts, ts->json_str + ts->tokens[0].start,
-                                      ts->tokens[0].end - ts->tokens[0].start, -1);
+            struct ts_data_object *del_object = ts_get_object_by_name(ts, tok.start, tok.len, -1);
 #endif
             if (del_object != NULL) {
                 del_object->subsets &= ~((uint16_t)object->detail);
+                ts_index_update_subsets(ts);
                 return ts_txt_response(ts, TS_STATUS_DELETED);
             }
             return ts_txt_response(ts, TS_STATUS_NOT_FOUND);
@@ -874,13 +1590,9 @@ int ts_txt_delete(struct ts_context *ts, const struct ts_data_object *object)
 
 int ts_txt_exec(struct ts_context *ts, const struct ts_data_object *object)
 {
+    struct ts_json_reader r;
+    struct ts_json_token tok;
     int len;
-    int tok = 0;           // current token
-    int objects_found = 0; // number of child objects found
-
-    if (ts->tok_count > 0 && ts->tokens[tok].type == JSMN_ARRAY) {
-        tok++; // go to first element of array
-    }
 
     if ((object->access & TS_WRITE_MASK)
         && (object->type == TS_T_FN_VOID || object->type == TS_T_FN_INT32))
@@ -894,25 +1606,36 @@ int ts_txt_exec(struct ts_context *ts, const struct ts_data_object *object)
         return ts_txt_response(ts, TS_STATUS_FORBIDDEN);
     }
 
-    for (unsigned int i = 0; i < ts->num_objects; i++) {
-        if (ts->data_objects[i].parent == object->id) {
-            if (tok >= ts->tok_count) {
-                // more child objects found than parameters were passed
-                return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
-            }
-            int res = ts_json_deserialize_value(ts, ts->json_str + ts->tokens[tok].start,
-                                                ts->tokens[tok].end - ts->tokens[tok].start,
-                                                ts->tokens[tok].type, &ts->data_objects[i]);
-            if (res == 0) {
-                // deserializing the value was not successful
-                return ts_txt_response(ts, TS_STATUS_UNSUPPORTED_FORMAT);
-            }
-            tok += res;
-            objects_found++;
+    // parameters are passed as single value or array
+    ts_json_reader_init(&r, ts->json_str, ts->json_len);
+    if (ts_json_next(&r, &tok) != 0) {
+        return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+    }
+    const bool array = (tok.type == TS_JSON_ARRAY);
+    if (array && ts_json_next(&r, &tok) != 0) {
+        return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+    }
+
+    struct ts_data_object *child;
+    unsigned int iter = 0;
+    while ((child = ts_get_next_child(ts, object->id, &iter)) != NULL) {
+        if (tok.type == TS_JSON_END || tok.type == TS_JSON_ARRAY_END) {
+            // more child objects found than parameters were passed
+            return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+        }
+        if (ts_json_deserialize_value(ts, tok.start, tok.len, tok.type, child) == 0) {
+            // deserializing the value was not successful
+            return ts_txt_response(ts, TS_STATUS_UNSUPPORTED_FORMAT);
+        }
+        if (ts_json_next(&r, &tok) != 0) {
+            return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
         }
     }
 
-    if (ts->tok_count > tok) {
+    if (array && tok.type == TS_JSON_ARRAY_END && ts_json_next(&r, &tok) != 0) {
+        return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
+    }
+    if (tok.type != TS_JSON_END) {
         // more parameters passed than child objects found
         return ts_txt_response(ts, TS_STATUS_BAD_REQUEST);
     }
@@ -923,10 +1646,11 @@ int ts_txt_exec(struct ts_context *ts, const struct ts_data_object *object)
     if (object->type == TS_T_FN_INT32) {
         int32_t (*fun)(void) = (int32_t(*)(void))object->data;
         int32_t ret = fun();
-        ts->resp[len++] = ' ';
-        len +=
-            json_serialize_simple_value(&ts->resp[len], ts->resp_size - len, &ret, TS_T_INT32, 0);
-        ts->resp[--len] = '\0'; // remove trailing comma again
+        struct ts_json_writer w;
+        ts_json_writer_init(&w, (char *)&ts->resp[len], ts->resp_size - len);
+        json_char(&w, ' ');
+        json_simple_value(&w, &ret, TS_T_INT32, 0);
+        len = txt_response_payload(ts, len, &w);
     }
     else {
         void (*fun)(void) = (void (*)(void))object->data;
@@ -938,141 +1662,175 @@ int ts_txt_exec(struct ts_context *ts, const struct ts_data_object *object)
 
 #if CONFIG_THINGSET_NESTED_JSON
 
-/* currently only supporting nesting of depth 2 (parent and grandparent != 0) */
-int ts_txt_export(struct ts_context *ts, char *buf, size_t buf_size, uint16_t subsets)
+/*
+ * Exports the members with their parent groups as nested JSON objects. Members with the same
+ * parent are expected to be stored next to each other in the data objects array.
+ */
+static void ts_txt_export_members(struct ts_context *ts, struct ts_json_writer *w,
+                                  uint16_t subsets)
 {
-    struct ts_data_object *ancestors[2];
+    /* ids of the currently open parent objects, starting at the root */
+    ts_object_id_t open[JSON_MAX_DEPTH];
+    /* ancestors of the current member, starting at its parent */
+    struct ts_data_object *ancestors[JSON_MAX_DEPTH];
+    struct ts_data_object *member;
+    struct ts_member_iter iter = { 0 };
     int depth = 0;
-    int len = 1;
-    buf[0] = '{';
-
-    for (unsigned int i = 0; i < ts->num_objects; i++) {
-        if (ts->data_objects[i].subsets & subsets) {
-            const uint16_t parent_id = ts->data_objects[i].parent;
-            if (depth > 0 && parent_id != ancestors[depth - 1]->id) {
-                // close object of previous parent
-                buf[len - 1] = '}'; // overwrite comma
-                buf[len++] = ',';
-                depth--;
-            }
 
-            if (depth == 0 && parent_id != 0) {
-                struct ts_data_object *parent = ts_get_object_by_id(ts, parent_id);
-                if (parent != NULL) {
-                    if (parent->parent != 0) {
-                        struct ts_data_object *grandparent =
-                            ts_get_object_by_id(ts, parent->parent);
-                        if (grandparent != NULL) {
-                            len +=
-                                snprintf(&buf[len], buf_size - len, "\"%s\":{", grandparent->name);
-                            ancestors[depth++] = grandparent;
-                        }
-                    }
-                    len += snprintf(&buf[len], buf_size - len, "\"%s\":{", parent->name);
-                    ancestors[depth++] = parent;
+    json_begin(w, '{');
+
+    while ((member = ts_get_next_member_value(ts, subsets, &iter)) != NULL && !w->overflow) {
+        if (member->parent != (depth > 0 ? open[depth - 1] : 0)) {
+            int num_ancestors = 0;
+            ts_object_id_t id = member->parent;
+            while (id != 0) {
+                struct ts_data_object *parent = ts_get_object_by_id(ts, id);
+                if (parent == NULL) {
+                    break;
                 }
-            }
-            else if (depth > 0 && parent_id != ancestors[depth - 1]->id) {
-                struct ts_data_object *parent = ts_get_object_by_id(ts, parent_id);
-                if (parent != NULL) {
-                    len += snprintf(&buf[len], buf_size - len, "\"%s\":{", parent->name);
-                    ancestors[depth++] = parent;
+                else if (num_ancestors == JSON_MAX_DEPTH) {
+                    // nesting too deep (or a loop in the object tree), so give up
+                    w->overflow = true;
+                    return;
                 }
+                ancestors[num_ancestors++] = parent;
+                id = parent->parent;
+            }
+
+            // keep the open objects shared with the previous member and close the others
+            int common = 0;
+            while (common < depth && common < num_ancestors
+                   && open[common] == ancestors[num_ancestors - 1 - common]->id)
+            {
+                common++;
+            }
+            for (; depth > common; depth--) {
+                json_end(w, '}');
+            }
+
+            for (; depth < num_ancestors; depth++) {
+                struct ts_data_object *parent = ancestors[num_ancestors - 1 - depth];
+                json_name(w, parent->name);
+                json_begin(w, '{');
+                open[depth] = parent->id;
             }
-            len +=
-                ts_json_serialize_name_value(ts, &buf[len], buf_size - len, &ts->data_objects[i]);
-        }
-        if (len >= buf_size - 1 - depth) {
-            return 0;
         }
+        ts_json_serialize_name_value(ts, w, member);
     }
 
-    len--; // to overwrite comma
-
     while (depth >= 0) {
-        buf[len++] = '}';
-        buf[len] = '\0';
+        json_end(w, '}');
         depth--;
     }
-
-    return len;
 }
 
 #else
 
-int ts_txt_export(struct ts_context *ts, char *buf, size_t buf_size, uint16_t subsets)
+static void ts_txt_export_members(struct ts_context *ts, struct ts_json_writer *w,
+                                  uint16_t subsets)
 {
-    unsigned int len = 1;
-    buf[0] = '{';
+    struct ts_data_object *member;
+    struct ts_member_iter iter = { 0 };
 
-    for (unsigned int i = 0; i < ts->num_objects; i++) {
-        if (ts->data_objects[i].subsets & subsets) {
-            len +=
-                ts_json_serialize_name_value(ts, &buf[len], buf_size - len, &ts->data_objects[i]);
-        }
-        if (len >= buf_size - 1) {
-            return 0;
-        }
-    }
+    json_begin(w, '{');
 
-    buf[len - 1] = '}'; // overwrite comma
-    buf[len] = '\0';
+    while ((member = ts_get_next_member_value(ts, subsets, &iter)) != NULL && !w->overflow) {
+        ts_json_serialize_name_value(ts, w, member);
+    }
 
-    return len;
+    json_end(w, '}');
 }
 
 #endif /* CONFIG_THINGSET_NESTED_JSON */
 
+/* exports the subsets with consistent values, returns false if the seqlocks could not be taken */
+static bool ts_txt_export_consistent(struct ts_context *ts, struct ts_json_writer *w,
+                                     uint16_t subsets)
+{
+#if CONFIG_THINGSET_SEQLOCK
+    if (ts->capture.values != NULL) {
+        // captured values are a stable snapshot, which is not changed by the writers
+        ts_txt_export_members(ts, w, subsets);
+        return true;
+    }
+
+    const struct ts_json_writer start = *w;
+    for (int i = 0; i <= CONFIG_THINGSET_SEQLOCK_RETRIES; i++) {
+        uint32_t seq;
+        if (ts_seqlock_read_begin(ts, subsets, &seq)) {
+            ts_txt_export_members(ts, w, subsets);
+            if (!ts_seqlock_read_retry(ts, subsets, seq)) {
+                return true;
+            }
+            *w = start;
+        }
+    }
+    return false;
+#else
+    ts_txt_export_members(ts, w, subsets);
+    return true;
+#endif
+}
+
+int ts_txt_export(struct ts_context *ts, char *buf, size_t buf_size, uint16_t subsets)
+{
+    struct ts_json_writer w;
+
+    ts_json_writer_init(&w, buf, buf_size);
+    if (!ts_txt_export_consistent(ts, &w, subsets)) {
+        return 0;
+    }
+
+    return ts_json_writer_finish(&w);
+}
+
 static int ts_serialize_statement(struct ts_context *ts, char *buf, size_t buf_size,
                                   struct ts_data_object *object, int record_index)
 {
-    unsigned int len = 0;
+    struct ts_json_writer w;
 
     if (!object) {
         return 0;
     }
 
-    buf[len++] = '#';
-    len += ts_get_path(ts, &buf[len], buf_size - len, object);
-    if (record_index != RECORD_INDEX_NONE) {
-        len += snprintf(buf + len, buf_size - len, "/%d", record_index);
-    }
-
-    if (len > 1 && buf_size > len) {
-        buf[len++] = ' ';
+    ts_json_writer_init(&w, buf, buf_size);
+    json_char(&w, '#');
+    if (!w.overflow) {
+        int len = ts_get_path(ts, &buf[w.pos], buf_size - w.pos, object);
+        json_advance(&w, len > 0 ? len : -1);
     }
-    else {
-        return 0;
+    if (record_index != RECORD_INDEX_NONE) {
+        json_char(&w, '/');
+        if (!w.overflow) {
+            json_advance(&w, ts_txt_format_int(&buf[w.pos], buf_size - w.pos, record_index));
+        }
     }
+    json_char(&w, ' ');
 
     if (object->type == TS_T_SUBSET) {
-        len += ts_txt_export(ts, &buf[len], buf_size - len, object->detail);
+        if (!ts_txt_export_consistent(ts, &w, object->detail)) {
+            return 0;
+        }
     }
     else if (object->type == TS_T_GROUP) {
-        buf[len++] = '{';
-        for (unsigned int i = 0; i < ts->num_objects; i++) {
-            if (ts->data_objects[i].parent == object->id) {
-                len += ts_json_serialize_name_value(ts, &buf[len], buf_size - len,
-                                                    &ts->data_objects[i]);
-            }
-            if (len >= buf_size - 1) {
-                return 0;
-            }
+        struct ts_data_object *child;
+        unsigned int iter = 0;
+        json_begin(&w, '{');
+        while ((child = ts_get_next_child(ts, object->id, &iter)) != NULL && !w.overflow) {
+            ts_json_serialize_name_value(ts, &w, child);
         }
-        buf[len - 1] = '}'; // overwrite comma
-        buf[len] = '\0';
+        json_end(&w, '}');
     }
     else if (object->type == TS_T_RECORDS) {
-        buf[len++] = '{';
-        len += ts_json_serialize_record(ts, buf + len, buf_size - len, object, record_index, NULL);
-        buf[len - 1] = '}'; // overwrite comma
-        buf[len] = '\0';
+        json_begin(&w, '{');
+        json_serialize_record(ts, &w, object, record_index);
+        json_end(&w, '}');
     }
     else {
         return 0;
     }
 
-    return len;
+    return ts_json_writer_finish(&w);
 }
 
 int ts_txt_statement(struct ts_context *ts, char *buf, size_t buf_size,
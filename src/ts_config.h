@@ -24,17 +24,6 @@
 #define CONFIG_THINGSET_CPP_LEGACY 1
 #endif
 
-/*
- * Maximum number of expected JSON tokens (i.e. arrays, map keys, values,
- * primitives, etc.)
- *
- * Thingset throws an error if maximum number of tokens is reached in a
- * request or response.
- */
-#ifndef CONFIG_THINGSET_NUM_JSON_TOKENS
-#define CONFIG_THINGSET_NUM_JSON_TOKENS 50
-#endif
-
 /*
  * If verbose status messages are switched on, a response in text-based mode
  * contains not only the status code, but also a message.
@@ -87,6 +76,107 @@
 #define CONFIG_THINGSET_NESTED_JSON 1
 #endif
 
+/*
+ * Use a hash table instead of a sorted table with binary search to find data objects by their
+ * ID if the context was initialized with an index (see ts_init_indexed).
+ *
+ * The hash table needs twice the memory of the sorted table, but the lookup time does not
+ * depend on the number of data objects.
+ */
+#ifndef CONFIG_THINGSET_ID_INDEX_HASH
+#define CONFIG_THINGSET_ID_INDEX_HASH 0
+#endif
+
+/*
+ * Use indefinite-length arrays and maps in binary mode responses and statements.
+ *
+ * The data is serialized in a single pass in any case. Without this option, the header with the
+ * number of elements is updated after serializing the elements, which requires to move the data
+ * in the buffer if less than 3 bytes are needed for the header. With this option, a break stop
+ * code is appended instead, but the receiver has to support indefinite-length containers.
+ *
+ * Data exported with ts_bin_export always uses definite lengths, as ts_bin_import does not
+ * support indefinite-length maps.
+ */
+#ifndef CONFIG_THINGSET_CBOR_INDEFINITE_LENGTH
+#define CONFIG_THINGSET_CBOR_INDEFINITE_LENGTH 0
+#endif
+
+/*
+ * Serialize numeric arrays (TS_T_ARRAY) in binary mode as typed arrays according to RFC 8746.
+ *
+ * The elements are stored as a tagged byte string in the byte order of the device, so the array
+ * is copied with memcpy instead of encoding each element separately. Floats are always sent with
+ * full precision, i.e. the decimal digits of the data object are ignored. The receiver has to
+ * support typed arrays.
+ *
+ * Typed arrays in PATCH requests are accepted in both byte orders if this option is enabled.
+ */
+#ifndef CONFIG_THINGSET_CBOR_TYPED_ARRAYS
+#define CONFIG_THINGSET_CBOR_TYPED_ARRAYS 0
+#endif
+
+/*
+ * Number of entries of the cache for resolved text mode paths (0 to disable the cache).
+ *
+ * Devices polled with the same requests again and again can skip the path resolution for the
+ * most recently used paths. Each entry stores a copy of the path to rule out hash collisions.
+ */
+#ifndef CONFIG_THINGSET_PATH_CACHE_SIZE
+#define CONFIG_THINGSET_PATH_CACHE_SIZE 0
+#endif
+
+/*
+ * Maximum length of paths stored in the path cache. Longer paths are always resolved.
+ */
+#ifndef CONFIG_THINGSET_PATH_CACHE_MAX_LEN
+#define CONFIG_THINGSET_PATH_CACHE_MAX_LEN 32
+#endif
+
+/*
+ * Size of the buffer in struct ts_patch_stream used to store a partially received CBOR data item
+ * of a binary PATCH request (see ts_bin_patch_stream_push).
+ *
+ * The buffer has to be large enough for the endpoint path and the largest value in the request.
+ */
+#ifndef CONFIG_THINGSET_PATCH_STREAM_BUF_SIZE
+#define CONFIG_THINGSET_PATCH_STREAM_BUF_SIZE 32
+#endif
+
+/*
+ * Enable sequence locks, which can be assigned to subsets to make sure that exports and
+ * statements of a subset contain a consistent set of values (see ts_set_seqlock).
+ */
+#ifndef CONFIG_THINGSET_SEQLOCK
+#define CONFIG_THINGSET_SEQLOCK 0
+#endif
+
+/*
+ * Number of times the serialization of a subset is repeated if the values were changed while
+ * reading them, before the export or statement fails.
+ */
+#ifndef CONFIG_THINGSET_SEQLOCK_RETRIES
+#define CONFIG_THINGSET_SEQLOCK_RETRIES 3
+#endif
+
+/*
+ * Size of the buffer in struct ts_can_pub_stream used to store the ID and value of the data object
+ * currently published in packed CAN frames (see ts_bin_pub_can_packed).
+ *
+ * Data objects with a larger encoded size are encoded in multiple parts.
+ */
+#ifndef CONFIG_THINGSET_CAN_PUB_BUF_SIZE
+#define CONFIG_THINGSET_CAN_PUB_BUF_SIZE 32
+#endif
+
+/*
+ * Minimum size of byte strings which are referenced in the response of ts_process_iov instead of
+ * copying them into the response buffer.
+ */
+#ifndef CONFIG_THINGSET_IOV_MIN_SIZE
+#define CONFIG_THINGSET_IOV_MIN_SIZE 32
+#endif
+
 #endif /* __ZEPHYR__ */
 
 #endif /* TS_CONFIG_H_ */
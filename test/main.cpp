@@ -10,9 +10,18 @@
 #error "You have to include unity.h. Should be done by test.h->thingset_priv.h"
 #endif
 
+// all tests are run twice: with the default linear search and with the lookup index
+static bool use_index;
+
 void setUp(void)
 {
-    (void)ts_init(&ts, &data_objects[0], data_objects_size);
+    if (use_index) {
+        (void)ts_init_indexed(&ts, &data_objects[0], data_objects_size, index_buf,
+                              ARRAY_SIZE(index_buf));
+    }
+    else {
+        (void)ts_init(&ts, &data_objects[0], data_objects_size);
+    }
 }
 
 void tearDown(void)
@@ -28,6 +37,26 @@ void tests_common()
     RUN_TEST(test_txt_patch_bin_fetch);
     RUN_TEST(test_bin_patch_txt_fetch);
 
+    // data object lookup
+    RUN_TEST(test_ts_init_indexed);
+    RUN_TEST(test_ts_init_prebuilt);
+    RUN_TEST(test_ts_get_next_child);
+    RUN_TEST(test_ts_get_next_member);
+#if CONFIG_THINGSET_PATH_CACHE_SIZE > 0
+    RUN_TEST(test_ts_path_cache);
+#endif
+    RUN_TEST(test_ts_process_chunked);
+    RUN_TEST(test_ts_process_batch);
+    RUN_TEST(test_ts_request_id);
+    RUN_TEST(test_ts_pipeline);
+    RUN_TEST(test_ts_init_shared);
+#if CONFIG_THINGSET_SEQLOCK
+    RUN_TEST(test_ts_seqlock);
+#endif
+    RUN_TEST(test_ts_capture);
+    RUN_TEST(test_ts_delta_statement);
+    RUN_TEST(test_ts_check_objects);
+
     UNITY_END();
 }
 
@@ -56,6 +85,9 @@ void tests_text_mode()
     // PATCH request
     RUN_TEST(test_txt_patch_wrong_data_structure);
     RUN_TEST(test_txt_patch_whitespaces);
+    RUN_TEST(test_txt_patch_number_range);
+    RUN_TEST(test_txt_patch_many_values);
+    RUN_TEST(test_txt_patch_nested);
     RUN_TEST(test_txt_patch_bytes_buffer);
     RUN_TEST(test_txt_patch_readonly);
     RUN_TEST(test_txt_patch_wrong_path);
@@ -87,10 +119,15 @@ void tests_text_mode()
 
     // data export
     RUN_TEST(test_txt_export);
+    RUN_TEST(test_txt_export_buffer_overflow);
 
     // update notification
     RUN_TEST(test_txt_update_callback);
 
+    // number formatting and JSON parsing
+    RUN_TEST(test_txt_number_formatting);
+    RUN_TEST(test_txt_json_reader);
+
     UNITY_END();
 }
 
@@ -107,6 +144,7 @@ void tests_binary_mode()
     RUN_TEST(test_bin_patch_multiple_objects);
     RUN_TEST(test_bin_patch_float_array);
     RUN_TEST(test_bin_patch_rounded_float); // writes an integer to float
+    RUN_TEST(test_bin_patch_stream);
 
     // FETCH request
     RUN_TEST(test_bin_fetch_meas_ids);
@@ -126,10 +164,16 @@ void tests_binary_mode()
     RUN_TEST(test_bin_statement_subset);
     RUN_TEST(test_bin_statement_group);
     RUN_TEST(test_bin_pub_can);
+    RUN_TEST(test_bin_pub_can_packed);
+    RUN_TEST(test_bin_can_sched);
+#if CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT
+    RUN_TEST(test_bin_process_iov);
+#endif
 
     // general tests
     RUN_TEST(test_bin_num_elem);
     RUN_TEST(test_bin_serialize_long_string);
+    RUN_TEST(test_bin_serialize_container);
 
     // binary (bytes) data type
 #if CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT
@@ -149,6 +193,10 @@ void tests_binary_mode()
     // request paths by IDs and vice versa
     RUN_TEST(test_bin_fetch_paths);
     RUN_TEST(test_bin_fetch_ids);
+    RUN_TEST(test_bin_array_elements);
+#if CONFIG_THINGSET_CBOR_TYPED_ARRAYS
+    RUN_TEST(test_bin_patch_typed_array);
+#endif
 
     UNITY_END();
 }
@@ -165,8 +213,11 @@ void tests_shim()
 
 int main()
 {
-    tests_common();
-    tests_text_mode();
-    tests_binary_mode();
-    tests_shim();
+    for (int i = 0; i < 2; i++) {
+        use_index = (i == 1);
+        tests_common();
+        tests_text_mode();
+        tests_binary_mode();
+        tests_shim();
+    }
 }
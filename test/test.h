@@ -43,6 +43,8 @@ extern "C" {
 extern char manufacturer[];
 extern bool pub_report_enable;
 extern uint16_t pub_serial_interval;
+extern uint16_t pub_report_interval;
+extern bool pub_info_enable;
 extern bool pub_can_enable;
 extern uint16_t pub_can_interval;
 extern char auth_password[11];
@@ -67,10 +69,12 @@ extern size_t data_objects_size;
  */
 #define TS_REQ_BUFFER_LEN  500
 #define TS_RESP_BUFFER_LEN 500
+#define TS_INDEX_BUFFER_LEN TS_INDEX_BUF_LEN(200)
 
 extern struct ts_context ts;
 extern uint8_t req_buf[TS_REQ_BUFFER_LEN];
 extern uint8_t resp_buf[TS_RESP_BUFFER_LEN];
+extern uint16_t index_buf[TS_INDEX_BUFFER_LEN];
 
 extern bool group_callback_called;
 extern bool update_callback_called;
@@ -107,6 +111,24 @@ void assert_cbor2json(char const *name, char const *json_value, uint16_t id,
 #define _STRINGIFY(x) #x
 #endif
 
+/*
+ * Headers of arrays and maps with a number of elements not known in advance in expected binary
+ * responses (see CONFIG_THINGSET_CBOR_INDEFINITE_LENGTH)
+ */
+#if CONFIG_THINGSET_CBOR_INDEFINITE_LENGTH
+#define CBOR_ARRAY_HEX(num) "9F "
+#define CBOR_MAP_HEX(num)   "BF "
+#define CBOR_BREAK_HEX      "FF "
+#define CBOR_MAP_BYTE(num)  0xBF
+#define CBOR_BREAK_BYTE     , 0xFF
+#else
+#define CBOR_ARRAY_HEX(num) "8" #num " "
+#define CBOR_MAP_HEX(num)   "A" #num " "
+#define CBOR_BREAK_HEX      ""
+#define CBOR_MAP_BYTE(num)  (0xA0 + (num))
+#define CBOR_BREAK_BYTE
+#endif
+
 #define ASSERT_MSG(assert_func) \
     _ASSERT_MSG("Assertion triggered by " assert_func " at #" STRINGIFY(__LINE__) " " __FILE__)
 #define _ASSERT_MSG(assert_msg) assert_msg
@@ -147,6 +169,20 @@ void test_assert(void);
 void test_txt_patch_bin_fetch(void);
 void test_bin_patch_txt_fetch(void);
 void test_ts_init(void);
+void test_ts_init_indexed(void);
+void test_ts_init_prebuilt(void);
+void test_ts_get_next_child(void);
+void test_ts_get_next_member(void);
+void test_ts_path_cache(void);
+void test_ts_process_chunked(void);
+void test_ts_process_batch(void);
+void test_ts_request_id(void);
+void test_ts_pipeline(void);
+void test_ts_init_shared(void);
+void test_ts_seqlock(void);
+void test_ts_capture(void);
+void test_ts_delta_statement(void);
+void test_ts_check_objects(void);
 
 void test_txt_get_root(void);
 void test_txt_get_meas_names(void);
@@ -164,6 +200,9 @@ void test_txt_fetch_num_records(void);
 void test_txt_fetch_record(void);
 void test_txt_patch_wrong_data_structure(void);
 void test_txt_patch_whitespaces(void);
+void test_txt_patch_number_range(void);
+void test_txt_patch_many_values(void);
+void test_txt_patch_nested(void);
 void test_txt_patch_bytes_buffer(void);
 void test_txt_patch_readonly(void);
 void test_txt_patch_wrong_path(void);
@@ -185,7 +224,10 @@ void test_txt_auth_reset(void);
 void test_txt_wrong_command(void);
 void test_txt_get_endpoint(void);
 void test_txt_export(void);
+void test_txt_export_buffer_overflow(void);
+void test_txt_json_reader(void);
 void test_txt_update_callback(void);
+void test_txt_number_formatting(void);
 
 void test_bin_get_meas_ids_values(void);
 void test_bin_get_meas_names_values(void);
@@ -195,6 +237,7 @@ void test_bin_fetch_meas_ids(void);
 void test_bin_fetch_meas_names(void);
 void test_bin_fetch_multiple_objects(void);
 void test_bin_patch_float_array(void);
+void test_bin_patch_stream(void);
 void test_bin_fetch_float_array(void);
 void test_bin_patch_rounded_float(void);
 void test_bin_fetch_rounded_float(void);
@@ -205,9 +248,15 @@ void test_bin_fetch_by_name(void);
 void test_bin_statement_subset(void);
 void test_bin_statement_group(void);
 void test_bin_pub_can(void);
+void test_bin_pub_can_packed(void);
+void test_bin_can_sched(void);
+#if CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT
+void test_bin_process_iov(void);
+#endif
 void test_bin_exec(void);
 void test_bin_num_elem(void);
 void test_bin_serialize_long_string(void);
+void test_bin_serialize_container(void);
 void test_bin_serialize_bytes(void);
 void test_bin_deserialize_bytes(void);
 void test_bin_patch_fetch_bytes(void);
@@ -217,6 +266,10 @@ void test_bin_import_record(void);
 void test_bin_update_callback(void);
 void test_bin_fetch_paths(void);
 void test_bin_fetch_ids(void);
+void test_bin_array_elements(void);
+#if CONFIG_THINGSET_CBOR_TYPED_ARRAYS
+void test_bin_patch_typed_array(void);
+#endif
 
 #ifdef __cplusplus
 } /* extern "C" */
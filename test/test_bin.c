@@ -6,17 +6,20 @@
 
 #include "test.h"
 
+#include <errno.h>
+#include <string.h>
+
 void test_bin_get_meas_ids_values(void)
 {
     const uint8_t req[] = { TS_GET, ID_MEAS };
     const char resp_hex[] =
-        "85 A3 " // successful response: map with 3 elements
+        "85 " CBOR_MAP_HEX(3) // successful response: map with 3 elements
         "18 71 "
         "FA 41 61 99 9A " // 14.1
         "18 72 "
         "FA 40 A4 28 F6 " // 5.13
         "18 73 "
-        "16";
+        "16 " CBOR_BREAK_HEX;
 
     TEST_ASSERT_BIN_REQ(req, sizeof(req), resp_hex);
 }
@@ -25,13 +28,13 @@ void test_bin_get_meas_names_values()
 {
     const uint8_t req[] = { TS_GET, 0x64, 0x4D, 0x65, 0x61, 0x73 };
     const char resp_hex[] =
-        "85 A3 " // successful response: map with 3 elements
+        "85 " CBOR_MAP_HEX(3) // successful response: map with 3 elements
         "66 72 42 61 74 5F 56 "
         "FA 41 61 99 9A " // 14.1
         "66 72 42 61 74 5F 41 "
         "FA 40 A4 28 F6 " // 5.13
         "6D 72 41 6D 62 69 65 6E 74 5F 64 65 67 43 "
-        "16";
+        "16 " CBOR_BREAK_HEX;
 
     TEST_ASSERT_BIN_REQ(req, sizeof(req), resp_hex);
 }
@@ -48,10 +51,10 @@ void test_bin_fetch_meas_ids(void)
 {
     const uint8_t req[] = { TS_FETCH, ID_MEAS, 0xF7 };
     const char resp_hex[] =
-        "85 83 " // successful response: array with 3 elements
+        "85 " CBOR_ARRAY_HEX(3) // successful response: array with 3 elements
         "18 71 "
         "18 72 "
-        "18 73 ";
+        "18 73 " CBOR_BREAK_HEX;
 
     TEST_ASSERT_BIN_REQ(req, sizeof(req), resp_hex);
 }
@@ -61,10 +64,10 @@ void test_bin_fetch_meas_names(void)
     const uint8_t req[] = { TS_FETCH, 0x64, 0x4D, 0x65, 0x61, 0x73, // "Meas"
                             0xF7 };                                 // CBOR undefined
     const char resp_hex[] =
-        "85 83 " // successful response: array with 3 elements
+        "85 " CBOR_ARRAY_HEX(3) // successful response: array with 3 elements
         "66 72 42 61 74 5F 56 "
         "66 72 42 61 74 5F 41 "
-        "6D 72 41 6D 62 69 65 6E 74 5F 64 65 67 43";
+        "6D 72 41 6D 62 69 65 6E 74 5F 64 65 67 43 " CBOR_BREAK_HEX;
 
     TEST_ASSERT_BIN_REQ(req, sizeof(req), resp_hex);
 }
@@ -92,6 +95,104 @@ void test_bin_patch_multiple_objects(void)
     TEST_ASSERT_BIN_REQ_HEX(req_hex, resp_hex);
 }
 
+static void assert_bin_patch_stream(const uint8_t *req, size_t req_len, size_t fragment_size,
+                                    uint8_t status_expected)
+{
+    struct ts_patch_stream stream;
+    uint8_t resp[10];
+    int resp_len = 0;
+
+    ts_bin_patch_stream_begin(&stream);
+    // errors are reported as soon as they are detected, i.e. possibly before the last fragment
+    for (size_t pos = 0; pos < req_len && resp_len == 0; pos += fragment_size) {
+        size_t len = (req_len - pos < fragment_size) ? req_len - pos : fragment_size;
+        resp_len = ts_bin_patch_stream_push(&ts, &stream, &req[pos], len, resp, sizeof(resp));
+    }
+    TEST_ASSERT_EQUAL(1, resp_len);
+    TEST_ASSERT_EQUAL_HEX8(status_expected, resp[0]);
+}
+
+void test_bin_patch_stream(void)
+{
+    const uint8_t req_array[] = {
+        TS_PATCH, 0x18, ID_CONF, 0xA1, 0x19, 0x70, 0x04, 0x82, 0xFA, 0x40, 0x11, 0x47, 0xAE, // 2.27
+        0xFA,     0x40, 0x5C,    0x28, 0xF6                                                  // 3.44
+    };
+    const uint8_t req_path[] = {
+        TS_PATCH, 0x64, 'C',  'o',  'n',  'f', 0xA2, 0x19, 0x60, 0x07, 0xFA, 0x40,
+        0xFC,     0x7A, 0xE1, 0x19, 0x60, 0x09, 0x64, 't',  'e',  's',  't' // f32, strbuf
+    };
+    const uint8_t req_forbidden[] = { TS_PATCH, 0x18, ID_MEAS, 0xA1, 0x18, 0x71, 0x05 };
+    const uint8_t req_too_long[] = {
+        TS_PATCH, 0x18, ID_CONF, 0xA1, 0x19, 0x60, 0x09, 0x78, 40, 'x' // string with 40 chars
+    };
+    float *arr = (float *)float32_array.elements;
+
+    for (size_t fragment_size = 1; fragment_size <= sizeof(req_path); fragment_size++) {
+        arr[0] = 0;
+        arr[1] = 0;
+        assert_bin_patch_stream(req_array, sizeof(req_array), fragment_size, TS_STATUS_CHANGED);
+        TEST_ASSERT_EQUAL_FLOAT(2.27, arr[0]);
+        TEST_ASSERT_EQUAL_FLOAT(3.44, arr[1]);
+
+        f32 = 0;
+        strbuf[0] = '\0';
+        assert_bin_patch_stream(req_path, sizeof(req_path), fragment_size, TS_STATUS_CHANGED);
+        TEST_ASSERT_EQUAL_FLOAT(7.89, f32);
+        TEST_ASSERT_EQUAL_STRING("test", strbuf);
+    }
+
+    // same status codes as for ts_process
+    TEST_ASSERT_EQUAL(1, ts_process(&ts, req_forbidden, sizeof(req_forbidden), resp_buf,
+                                    sizeof(resp_buf)));
+    assert_bin_patch_stream(req_forbidden, sizeof(req_forbidden), 3, resp_buf[0]);
+
+    // request ID prefix is added to the response like by ts_process
+    const uint8_t req_id[] = {
+        TS_REQUEST_ID, 0x18, 0xC8,                                              // ID 200
+        TS_PATCH,      0x18, ID_CONF, 0xA1, 0x19, 0x60, 0x07, 0xFA, 0x40, 0xFC, 0x7A, 0xE1 // f32
+    };
+    uint8_t expected[10];
+    int expected_len = ts_process(&ts, req_id, sizeof(req_id), expected, sizeof(expected));
+    TEST_ASSERT_EQUAL(4, expected_len);
+    for (size_t fragment_size = 1; fragment_size <= sizeof(req_id); fragment_size++) {
+        struct ts_patch_stream stream;
+        int resp_len = 0;
+        f32 = 0;
+        ts_bin_patch_stream_begin(&stream);
+        for (size_t pos = 0; pos < sizeof(req_id) && resp_len == 0; pos += fragment_size) {
+            size_t len = (sizeof(req_id) - pos < fragment_size) ? sizeof(req_id) - pos
+                                                                 : fragment_size;
+            resp_len = ts_bin_patch_stream_push(&ts, &stream, &req_id[pos], len, resp_buf,
+                                                sizeof(resp_buf));
+        }
+        TEST_ASSERT_EQUAL(expected_len, resp_len);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, resp_buf, expected_len);
+        TEST_ASSERT_EQUAL_FLOAT(7.89, f32);
+    }
+
+    // value does not fit into the buffer of the parser
+    struct ts_patch_stream stream;
+    ts_bin_patch_stream_begin(&stream);
+    TEST_ASSERT_EQUAL(1, ts_bin_patch_stream_push(&ts, &stream, req_too_long, sizeof(req_too_long),
+                                                  resp_buf, sizeof(resp_buf)));
+    TEST_ASSERT_EQUAL_HEX8(TS_STATUS_REQUEST_TOO_LARGE, resp_buf[0]);
+
+    // deeply nested items must not exhaust the stack
+    static uint8_t nested[4096];
+    memset(nested, 0x81, sizeof(nested));
+    TEST_ASSERT_EQUAL(0, cbor_item_size(nested, sizeof(nested)));
+    nested[sizeof(nested) - 1] = 0x00;
+    TEST_ASSERT_EQUAL(sizeof(nested), cbor_item_size(nested, sizeof(nested)));
+    nested[0] = TS_REQUEST_ID;
+    TEST_ASSERT_EQUAL(0, ts_process(&ts, nested, sizeof(nested), resp_buf, sizeof(resp_buf)));
+
+    // string lengths beyond INT_MAX are not truncated
+    const uint8_t huge_string[] = { 0x5A, 0xFF, 0xFF, 0xFF, 0xFF };
+    TEST_ASSERT_EQUAL(-1, cbor_item_size(huge_string, sizeof(huge_string)));
+    TEST_ASSERT_EQUAL(0, cbor_item_size(huge_string, 3));
+}
+
 void test_bin_fetch_multiple_objects(void)
 {
     f32 = 7.89;
@@ -173,9 +274,17 @@ void test_bin_fetch_float_array(void)
     arr[1] = 3.44;
 
     const uint8_t req[] = { TS_FETCH, 0x18, ID_CONF, 0x19, 0x70, 0x04 };
+#if CONFIG_THINGSET_CBOR_TYPED_ARRAYS
+    // typed array in the byte order of the device
+    uint8_t resp_expected[] = { TS_STATUS_CONTENT, 0xD8,
+                                CBOR_TYPED_ARRAY_FLOAT32 | CBOR_TYPED_ARRAY_NATIVE,
+                                0x48, 0, 0, 0, 0, 0, 0, 0, 0 };
+    memcpy(&resp_expected[4], arr, 2 * sizeof(float));
+#else
     const uint8_t resp_expected[] = {
         TS_STATUS_CONTENT, 0x82, 0xFA, 0x40, 0x11, 0x47, 0xAE, 0xFA, 0x40, 0x5C, 0x28, 0xF6
     };
+#endif
 
     TEST_ASSERT_BIN_REQ_EXP_BIN(req, sizeof(req), resp_expected, sizeof(resp_expected));
 }
@@ -219,9 +328,9 @@ void test_bin_fetch_record()
         TS_FETCH, 0x19, 0x70, 0x05,
         0x01 // second record
     };
-    const uint8_t resp_expected[] = { 0x85, 0xA3, 0x18, 0x81, 0x18, 0x7B,       // 123
-                                      0x18, 0x82, 0xFA, 0x41, 0x68, 0x00, 0x00, // 14.5
-                                      0x18, 0x83, 0x02 };
+    const uint8_t resp_expected[] = { 0x85, CBOR_MAP_BYTE(3), 0x18, 0x81, 0x18, 0x7B, // 123
+                                      0x18, 0x82, 0xFA, 0x41, 0x68, 0x00, 0x00,   // 14.5
+                                      0x18, 0x83, 0x02 CBOR_BREAK_BYTE };
 
     TEST_ASSERT_BIN_REQ_EXP_BIN(req, sizeof(req), resp_expected, sizeof(resp_expected));
 }
@@ -246,11 +355,12 @@ void test_bin_statement_subset(void)
     const char resp_expected[] =
         "1F "
         "0A "             // ID of "mReport"
-        "84 "             // array with 4 elements
+        CBOR_ARRAY_HEX(4) // array with 4 elements
         "1A 00 BC 61 4E " // int 12345678
         "FA 41 61 99 9a " // float 14.10
         "FA 40 a4 28 f6 " // float 5.13
-        "16 ";            // int 22
+        "16 "             // int 22
+        CBOR_BREAK_HEX;
 
     int resp_len = ts_bin_statement_by_path(&ts, resp_buf, sizeof(resp_buf), "mReport");
 
@@ -266,9 +376,10 @@ void test_bin_statement_group(void)
     const char resp_expected[] =
         "1F "
         "01 "                                  // ID of "Info"
-        "82 "                                  // array with 2 elements
+        CBOR_ARRAY_HEX(2)                      // array with 2 elements
         "6B 4C 69 62 72 65 20 53 6F 6C 61 72 " // "Libre Solar"
-        "68 41 42 43 44 31 32 33 34 ";         // "ABCD1234"
+        "68 41 42 43 44 31 32 33 34 "          // "ABCD1234"
+        CBOR_BREAK_HEX;
 
     int resp_len = ts_bin_statement_by_path(&ts, resp_buf, sizeof(resp_buf), "Info");
 
@@ -317,6 +428,247 @@ void test_bin_pub_can(void)
     TEST_ASSERT_EQUAL(-1, can_data_len);
 }
 
+void test_bin_pub_can_packed(void)
+{
+    struct ts_can_pub_stream stream = { 0 };
+    uint32_t msg_id;
+    uint8_t can_data[64];
+
+    const uint8_t payload[] = {
+        0x18, 0x71, 0xFA, 0x41, 0x61, 0x99, 0x9a, // rBat_V
+        0x18, 0x72, 0xFA, 0x40, 0xa4, 0x28, 0xf6, // rBat_A
+    };
+
+    TEST_ASSERT_EQUAL(-EINVAL, ts_bin_pub_can_packed_begin(&ts, &stream, SUBSET_CAN, 123, 10));
+
+    // classic CAN: second object is split across both frames
+    TEST_ASSERT_EQUAL(0, ts_bin_pub_can_packed_begin(&ts, &stream, SUBSET_CAN, 123, 8));
+    TEST_ASSERT_EQUAL(8, ts_bin_pub_can_packed(&ts, &stream, &msg_id, can_data));
+    TEST_ASSERT_TRUE(TS_CAN_PACKED(msg_id));
+    TEST_ASSERT_EQUAL_UINT32(TS_CAN_PRIO_PUBSUB_LOW, msg_id & TS_CAN_PRIO_MASK);
+    TEST_ASSERT_EQUAL_UINT32(SUBSET_CAN, TS_CAN_PACKED_SUBSETS_GET(msg_id));
+    TEST_ASSERT_EQUAL_UINT32(TS_CAN_PACKED_TYPE_FIRST, msg_id & TS_CAN_PACKED_TYPE_MASK);
+    TEST_ASSERT_EQUAL_UINT32(0, TS_CAN_PACKED_SEQ_GET(msg_id));
+    TEST_ASSERT_EQUAL_UINT32(123, TS_CAN_SOURCE_GET(msg_id));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(payload, can_data, 8);
+    uint32_t msg_num = TS_CAN_PACKED_MSG_GET(msg_id);
+
+    TEST_ASSERT_EQUAL(6, ts_bin_pub_can_packed(&ts, &stream, &msg_id, can_data));
+    TEST_ASSERT_EQUAL_UINT32(TS_CAN_PACKED_TYPE_LAST, msg_id & TS_CAN_PACKED_TYPE_MASK);
+    TEST_ASSERT_EQUAL_UINT32(1, TS_CAN_PACKED_SEQ_GET(msg_id));
+    TEST_ASSERT_EQUAL_UINT32(msg_num, TS_CAN_PACKED_MSG_GET(msg_id));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&payload[8], can_data, 6);
+
+    TEST_ASSERT_EQUAL(0, ts_bin_pub_can_packed(&ts, &stream, &msg_id, can_data));
+
+    // CAN FD: single frame padded to valid length
+    TEST_ASSERT_EQUAL(0, ts_bin_pub_can_packed_begin(&ts, &stream, SUBSET_CAN, 123, 64));
+    TEST_ASSERT_EQUAL(16, ts_bin_pub_can_packed(&ts, &stream, &msg_id, can_data));
+    TEST_ASSERT_EQUAL_UINT32(TS_CAN_PACKED_TYPE_SINGLE, msg_id & TS_CAN_PACKED_TYPE_MASK);
+    TEST_ASSERT_EQUAL_UINT32((msg_num + 1) & 0x3, TS_CAN_PACKED_MSG_GET(msg_id));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(payload, can_data, sizeof(payload));
+    TEST_ASSERT_EQUAL_HEX8(0xF7, can_data[14]);
+    TEST_ASSERT_EQUAL_HEX8(0xF7, can_data[15]);
+    TEST_ASSERT_EQUAL(0, ts_bin_pub_can_packed(&ts, &stream, &msg_id, can_data));
+
+    // data objects larger than the stream buffer are split across multiple frames
+    static int32_t large_elements[12];
+    static struct ts_array large_array = { large_elements, ARRAY_SIZE(large_elements),
+                                           ARRAY_SIZE(large_elements), TS_T_INT32,
+                                           sizeof(int32_t) };
+    static char long_string[] = "a string longer than the stream buffer..";
+    struct ts_data_object large_objects[] = {
+        TS_ITEM_ARRAY(0x7100, "large", &large_array, 0, 0, TS_ANY_R, SUBSET_CAN),
+        TS_ITEM_STRING(0x7101, "long", long_string, 0, 0, TS_ANY_R, SUBSET_CAN),
+        TS_ITEM_FLOAT(0x7102, "f32", &f32, 2, 0, TS_ANY_R, SUBSET_CAN),
+    };
+    struct ts_context ts_large;
+    uint8_t expected[150];
+    uint8_t received[150];
+    size_t expected_len = 0;
+
+    TEST_ASSERT_EQUAL(0, ts_init(&ts_large, large_objects, ARRAY_SIZE(large_objects)));
+    expected_len += cbor_serialize_uint(&expected[expected_len], 0x7100, 3);
+    for (size_t i = 0; i < ARRAY_SIZE(large_elements); i++) {
+        large_elements[i] = 100000 + i;
+    }
+#if CONFIG_THINGSET_CBOR_TYPED_ARRAYS
+    expected_len += cbor_serialize_typed_array(
+        &expected[expected_len], CBOR_TYPED_ARRAY_SINT32 | CBOR_TYPED_ARRAY_NATIVE, large_elements,
+        ARRAY_SIZE(large_elements), sizeof(expected) - expected_len);
+#else
+    expected_len += cbor_serialize_array(&expected[expected_len], ARRAY_SIZE(large_elements), 1);
+    for (size_t i = 0; i < ARRAY_SIZE(large_elements); i++) {
+        expected_len += cbor_serialize_int(&expected[expected_len], large_elements[i], 5);
+    }
+#endif
+    expected_len += cbor_serialize_uint(&expected[expected_len], 0x7101, 3);
+    expected_len += cbor_serialize_string(&expected[expected_len], long_string, 50);
+    expected_len += cbor_serialize_uint(&expected[expected_len], 0x7102, 3);
+    f32 = 7.89F;
+    expected_len += cbor_serialize_float(&expected[expected_len], f32, 5);
+    TEST_ASSERT_TRUE(expected_len > 2 * CONFIG_THINGSET_CAN_PUB_BUF_SIZE);
+
+    const uint8_t frame_sizes[] = { 8, 12, 64 };
+    for (size_t i = 0; i < ARRAY_SIZE(frame_sizes); i++) {
+        size_t received_len = 0;
+        int len;
+        TEST_ASSERT_EQUAL(0, ts_bin_pub_can_packed_begin(&ts_large, &stream, SUBSET_CAN, 123,
+                                                         frame_sizes[i]));
+        while ((len = ts_bin_pub_can_packed(&ts_large, &stream, &msg_id, can_data)) > 0) {
+            TEST_ASSERT_TRUE(received_len + len <= sizeof(received));
+            memcpy(&received[received_len], can_data, len);
+            received_len += len;
+        }
+        TEST_ASSERT_EQUAL(0, len);
+        TEST_ASSERT_TRUE(received_len >= expected_len);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, received, expected_len);
+        for (size_t pos = expected_len; pos < received_len; pos++) {
+            TEST_ASSERT_EQUAL_HEX8(0xF7, received[pos]);
+        }
+    }
+}
+
+static uint16_t sched_next_id(struct ts_can_sched *sched, uint32_t now_ms, uint32_t prio)
+{
+    uint32_t msg_id;
+    uint8_t can_data[8];
+
+    TEST_ASSERT_TRUE(ts_can_sched_next(&ts, sched, now_ms, &msg_id, can_data) > 0);
+    TEST_ASSERT_EQUAL_UINT32(prio, msg_id & TS_CAN_PRIO_MASK);
+    return TS_CAN_DATA_ID_GET(msg_id);
+}
+
+void test_bin_can_sched(void)
+{
+    struct ts_can_sched sched;
+    struct ts_can_sched_entry entries[] = {
+        { .subsets = SUBSET_REPORT, .period_ms = 100, .prio = TS_CAN_PRIO_PUBSUB_LOW },
+        { .subsets = SUBSET_CAN, .period_ms = 10, .prio = TS_CAN_PRIO_PUBSUB_HIGH },
+    };
+    uint32_t msg_id;
+    uint8_t can_data[8];
+
+    ts_can_sched_init(&sched, entries, ARRAY_SIZE(entries), 123, 0);
+
+    // high-priority entry first
+    TEST_ASSERT_EQUAL_UINT16(0x71, sched_next_id(&sched, 0, TS_CAN_PRIO_PUBSUB_HIGH));
+    TEST_ASSERT_EQUAL_UINT16(0x72, sched_next_id(&sched, 0, TS_CAN_PRIO_PUBSUB_HIGH));
+    TEST_ASSERT_EQUAL_UINT16(0x10, sched_next_id(&sched, 1, TS_CAN_PRIO_PUBSUB_LOW));
+    TEST_ASSERT_EQUAL_UINT16(0x71, sched_next_id(&sched, 2, TS_CAN_PRIO_PUBSUB_LOW));
+
+    // low-priority publication is interrupted when high-priority entry is due again
+    TEST_ASSERT_EQUAL_UINT16(0x71, sched_next_id(&sched, 12, TS_CAN_PRIO_PUBSUB_HIGH));
+    TEST_ASSERT_EQUAL_UINT16(0x72, sched_next_id(&sched, 12, TS_CAN_PRIO_PUBSUB_HIGH));
+    TEST_ASSERT_EQUAL_UINT16(0x72, sched_next_id(&sched, 12, TS_CAN_PRIO_PUBSUB_LOW));
+    TEST_ASSERT_EQUAL_UINT16(0x73, sched_next_id(&sched, 12, TS_CAN_PRIO_PUBSUB_LOW));
+    TEST_ASSERT_EQUAL(0, ts_can_sched_next(&ts, &sched, 12, &msg_id, can_data));
+
+    TEST_ASSERT_EQUAL(1, entries[0].count);
+    TEST_ASSERT_EQUAL(2, entries[1].count);
+    TEST_ASSERT_EQUAL(2, entries[1].max_jitter_ms);
+    TEST_ASSERT_EQUAL(0, entries[1].overruns);
+
+    // missed periods are counted as overruns
+    TEST_ASSERT_EQUAL_UINT16(0x71, sched_next_id(&sched, 35, TS_CAN_PRIO_PUBSUB_HIGH));
+    TEST_ASSERT_EQUAL(15, entries[1].max_jitter_ms);
+    TEST_ASSERT_EQUAL(1, entries[1].overruns);
+    TEST_ASSERT_EQUAL(45, entries[1].next_ms);
+
+    // time overflow
+    ts_can_sched_init(&sched, entries, ARRAY_SIZE(entries), 123, UINT32_MAX - 5);
+    TEST_ASSERT_EQUAL_UINT16(0x71, sched_next_id(&sched, UINT32_MAX, TS_CAN_PRIO_PUBSUB_HIGH));
+    TEST_ASSERT_EQUAL_UINT16(0x72, sched_next_id(&sched, UINT32_MAX, TS_CAN_PRIO_PUBSUB_HIGH));
+    TEST_ASSERT_EQUAL_UINT16(0x10, sched_next_id(&sched, UINT32_MAX, TS_CAN_PRIO_PUBSUB_LOW));
+    TEST_ASSERT_EQUAL_UINT16(0x71, sched_next_id(&sched, 4, TS_CAN_PRIO_PUBSUB_HIGH));
+    TEST_ASSERT_EQUAL(0, entries[1].overruns);
+}
+
+#if CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT
+
+static size_t iov_concat(uint8_t *buf, const struct ts_iovec *iov, int num)
+{
+    size_t len = 0;
+    for (int i = 0; i < num; i++) {
+        memcpy(&buf[len], iov[i].base, iov[i].len);
+        len += iov[i].len;
+    }
+    return len;
+}
+
+void test_bin_process_iov(void)
+{
+    static uint8_t wave[100];
+    static uint8_t small[4] = { 1, 2, 3, 4 };
+    static struct ts_bytes_buffer wave_buf = { wave, sizeof(wave) };
+    static struct ts_bytes_buffer small_buf = { small, sizeof(small) };
+    static struct ts_data_object iov_objects[] = {
+        TS_GROUP(0x01, "Wave", TS_NO_CALLBACK, ID_ROOT),
+        TS_ITEM_BYTES(0x40, "bData", &wave_buf, sizeof(wave), 0x01, TS_ANY_RW, 0),
+        TS_ITEM_BYTES(0x41, "bSmall", &small_buf, sizeof(small), 0x01, TS_ANY_RW, 0),
+        TS_ITEM_BYTES(0x42, "bData2", &wave_buf, sizeof(wave), 0x01, TS_ANY_RW, 0),
+    };
+    struct ts_context ts_iov;
+    struct ts_iovec iov[5];
+    uint8_t expected[300];
+    uint8_t resp[300];
+    uint8_t hdr[30];
+    const uint8_t req[] = { TS_GET, 0x01 };
+
+    for (size_t i = 0; i < sizeof(wave); i++) {
+        wave[i] = i;
+    }
+    ts_init(&ts_iov, iov_objects, ARRAY_SIZE(iov_objects));
+
+    int len = ts_process(&ts_iov, req, sizeof(req), expected, sizeof(expected));
+    // the break of an indefinite-length map needs an additional byte and segment at the end
+    const int indef = CONFIG_THINGSET_CBOR_INDEFINITE_LENGTH;
+    TEST_ASSERT_EQUAL(1 + 1 + (2 + 2 + 100) * 2 + (2 + 1 + 4) + indef, len);
+
+    // payload of both large byte strings is referenced
+    int num = ts_process_iov(&ts_iov, req, sizeof(req), hdr, sizeof(hdr), iov, ARRAY_SIZE(iov));
+    TEST_ASSERT_EQUAL(4 + indef, num);
+    TEST_ASSERT_EQUAL_PTR(wave, iov[1].base);
+    TEST_ASSERT_EQUAL_PTR(wave, iov[3].base);
+    TEST_ASSERT_EQUAL(len, iov_concat(resp, iov, num));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, resp, len);
+
+    // remaining byte strings are copied if there are not enough segments
+    uint8_t buf[150];
+    num = ts_process_iov(&ts_iov, req, sizeof(req), buf, sizeof(buf), iov, 3);
+    TEST_ASSERT_EQUAL(3, num);
+    TEST_ASSERT_EQUAL(len, iov_concat(resp, iov, num));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, resp, len);
+
+    // single data object
+    const uint8_t req_item[] = { TS_GET, 0x18, 0x42 };
+    len = ts_process(&ts_iov, req_item, sizeof(req_item), expected, sizeof(expected));
+    num = ts_process_iov(&ts_iov, req_item, sizeof(req_item), hdr, sizeof(hdr), iov, 3);
+    TEST_ASSERT_EQUAL(2, num);
+    TEST_ASSERT_EQUAL(len, iov_concat(resp, iov, num));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, resp, len);
+
+    // request ID prefix in front of the referenced payload
+    const uint8_t req_id[] = { TS_REQUEST_ID, 0x05, TS_GET, 0x18, 0x42 };
+    len = ts_process(&ts_iov, req_id, sizeof(req_id), expected, sizeof(expected));
+    num = ts_process_iov(&ts_iov, req_id, sizeof(req_id), hdr, sizeof(hdr), iov, 3);
+    TEST_ASSERT_EQUAL(2, num);
+    TEST_ASSERT_EQUAL_PTR(wave, iov[1].base);
+    TEST_ASSERT_EQUAL(len, iov_concat(resp, iov, num));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, resp, len);
+
+    // error responses don't reference any payload
+    const uint8_t req_invalid[] = { TS_GET, 0x18, 0x50 };
+    num = ts_process_iov(&ts_iov, req_invalid, sizeof(req_invalid), hdr, sizeof(hdr), iov, 3);
+    TEST_ASSERT_EQUAL(1, num);
+    TEST_ASSERT_EQUAL(1, iov[0].len);
+    TEST_ASSERT_EQUAL_HEX8(TS_STATUS_BAD_REQUEST, hdr[0]);
+
+    TEST_ASSERT_EQUAL(-EINVAL, ts_process_iov(&ts_iov, req, sizeof(req), hdr, sizeof(hdr), iov, 0));
+}
+
+#endif /* CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT */
+
 void test_bin_import(void)
 {
     const char req_hex[] =
@@ -349,9 +701,9 @@ void test_bin_import_record(void)
         TS_FETCH, 0x19, 0x70, 0x05,
         0x00 // first record
     };
-    const uint8_t resp_expected[] = { 0x85, 0xA3, 0x18, 0x81, 0x18, 0x7C,       // 124
-                                      0x18, 0x82, 0xFA, 0x41, 0x48, 0x00, 0x00, // 12.5
-                                      0x18, 0x83, 0x05 };
+    const uint8_t resp_expected[] = { 0x85, CBOR_MAP_BYTE(3), 0x18, 0x81, 0x18, 0x7C, // 124
+                                      0x18, 0x82, 0xFA, 0x41, 0x48, 0x00, 0x00,   // 12.5
+                                      0x18, 0x83, 0x05 CBOR_BREAK_BYTE };
 
     TEST_ASSERT_BIN_REQ_EXP_BIN(req, sizeof(req), resp_expected, sizeof(resp_expected));
 }
@@ -402,6 +754,48 @@ void test_bin_serialize_long_string(void)
     TEST_ASSERT_EQUAL_UINT(0x00, buf[2]); // null-termination is not stored
 }
 
+void test_bin_serialize_container(void)
+{
+    uint8_t *buf = &resp_buf[0];
+    int len;
+
+    // header needs 1 byte, so the elements are moved
+    len = cbor_serialize_array_start(buf, 10);
+    TEST_ASSERT_EQUAL(3, len);
+    len += cbor_serialize_uint(&buf[len], 1, 10 - len);
+    len += cbor_serialize_uint(&buf[len], 2, 10 - len);
+    len = cbor_serialize_container_end(buf, len, 2);
+    TEST_ASSERT_EQUAL(3, len);
+    TEST_ASSERT_EQUAL_HEX8(0x82, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, buf[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, buf[2]);
+
+    // header needs 2 bytes
+    len = cbor_serialize_map_start(buf, 100);
+    for (int i = 0; i < 30; i++) {
+        len += cbor_serialize_uint(&buf[len], i, 100 - len);
+        len += cbor_serialize_bool(&buf[len], true, 100 - len);
+    }
+    len = cbor_serialize_container_end(buf, len, 30);
+    TEST_ASSERT_EQUAL(2 + 30 * 2 + 6, len); // IDs >= 24 need 2 bytes
+    TEST_ASSERT_EQUAL_HEX8(0xB8, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(30, buf[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, buf[2]);
+    TEST_ASSERT_EQUAL_HEX8(CBOR_TRUE, buf[len - 1]);
+
+    // not enough space for reserved header
+    TEST_ASSERT_EQUAL(0, cbor_serialize_array_start(buf, 2));
+
+    // indefinite length
+    len = cbor_serialize_array_indefinite(buf, 10);
+    len += cbor_serialize_uint(&buf[len], 1, 10 - len);
+    len += cbor_serialize_break(&buf[len], 10 - len);
+    TEST_ASSERT_EQUAL(3, len);
+    TEST_ASSERT_EQUAL_HEX8(0x9F, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, buf[1]);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, buf[2]);
+}
+
 #if CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT
 void test_bin_serialize_bytes(void)
 {
@@ -546,3 +940,121 @@ void test_bin_fetch_ids(void)
 
     TEST_ASSERT_BIN_REQ_HEX(req, resp_expected);
 }
+
+void test_bin_array_elements(void)
+{
+    const int16_t i16_values[] = { -1, 0, 23, 24, -25, 300, -32768, 32767 };
+    const uint32_t ui32_values[] = { 0, 255, 256, 65536, UINT32_MAX };
+    const float f32_values[] = { 2.27F, -3.44F, 0.0F };
+    uint8_t expected[60];
+    uint8_t cbor[60];
+    size_t len = 0;
+
+    // bulk kernels must produce the same encoding as the single value functions
+    for (size_t i = 0; i < ARRAY_SIZE(i16_values); i++) {
+        len += cbor_serialize_int(&expected[len], i16_values[i], sizeof(expected) - len);
+    }
+    TEST_ASSERT_EQUAL(len, cbor_serialize_int_elements(cbor, i16_values, sizeof(int16_t), true,
+                                                       ARRAY_SIZE(i16_values), sizeof(cbor)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, cbor, len);
+
+    // buffer smaller than the worst case, but large enough
+    memset(cbor, 0, sizeof(cbor));
+    TEST_ASSERT_EQUAL(len, cbor_serialize_int_elements(cbor, i16_values, sizeof(int16_t), true,
+                                                       ARRAY_SIZE(i16_values), len));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, cbor, len);
+    TEST_ASSERT_EQUAL(0, cbor_serialize_int_elements(cbor, i16_values, sizeof(int16_t), true,
+                                                     ARRAY_SIZE(i16_values), len - 1));
+
+    len = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(ui32_values); i++) {
+        len += cbor_serialize_uint(&expected[len], ui32_values[i], sizeof(expected) - len);
+    }
+    TEST_ASSERT_EQUAL(len, cbor_serialize_int_elements(cbor, ui32_values, sizeof(uint32_t), false,
+                                                       ARRAY_SIZE(ui32_values), sizeof(cbor)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, cbor, len);
+
+    len = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(f32_values); i++) {
+        len += cbor_serialize_float(&expected[len], f32_values[i], sizeof(expected) - len);
+    }
+    TEST_ASSERT_EQUAL(len, cbor_serialize_float_elements(cbor, f32_values, ARRAY_SIZE(f32_values),
+                                                         sizeof(cbor)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, cbor, len);
+    TEST_ASSERT_EQUAL(0, cbor_serialize_float_elements(cbor, f32_values, ARRAY_SIZE(f32_values),
+                                                       len - 1));
+
+    // floats and integers mixed
+    float f32_decoded[4];
+    cbor[len] = 0x38; // -25
+    cbor[len + 1] = 24;
+    TEST_ASSERT_EQUAL(len + 2, cbor_deserialize_float_elements(cbor, f32_decoded, 4));
+    TEST_ASSERT_EQUAL(0, memcmp(f32_values, f32_decoded, sizeof(f32_values)));
+    TEST_ASSERT_EQUAL_FLOAT(-25.0F, f32_decoded[3]);
+
+    // typed arrays in big-endian byte order are swapped
+    const uint8_t typed_be[] = {
+        0xD8, CBOR_TYPED_ARRAY_SINT16, 0x44, 0xFF, 0xFF, 0x01, 0x2C // -1, 300
+    };
+    const uint8_t typed_le[] = {
+        0xD8, CBOR_TYPED_ARRAY_SINT16 | CBOR_TYPED_ARRAY_LE, 0x44, 0xFF, 0xFF, 0x2C, 0x01
+    };
+    const int16_t typed_values[] = { -1, 300 };
+    int16_t i16_decoded[2];
+    uint16_t num_elements;
+
+    TEST_ASSERT_EQUAL(sizeof(typed_be),
+                      cbor_serialize_typed_array(cbor, CBOR_TYPED_ARRAY_SINT16, typed_values, 2,
+                                                 sizeof(cbor)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(typed_be, cbor, sizeof(typed_be));
+    len = cbor_serialize_typed_array(cbor, CBOR_TYPED_ARRAY_SINT16 | CBOR_TYPED_ARRAY_LE,
+                                     typed_values, 2, sizeof(cbor));
+    TEST_ASSERT_EQUAL(sizeof(typed_le), len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(typed_le, cbor, sizeof(typed_le));
+    TEST_ASSERT_EQUAL(0, cbor_serialize_typed_array(cbor, CBOR_TYPED_ARRAY_SINT16, typed_values,
+                                                    2, sizeof(typed_be) - 1));
+
+    memset(i16_decoded, 0, sizeof(i16_decoded));
+    len = cbor_deserialize_typed_array(typed_be, CBOR_TYPED_ARRAY_SINT16, i16_decoded, 2,
+                                       &num_elements);
+    TEST_ASSERT_EQUAL(sizeof(typed_be), len);
+    TEST_ASSERT_EQUAL(2, num_elements);
+    TEST_ASSERT_EQUAL(0, memcmp(typed_values, i16_decoded, sizeof(typed_values)));
+
+    memset(i16_decoded, 0, sizeof(i16_decoded));
+    len = cbor_deserialize_typed_array(typed_le, CBOR_TYPED_ARRAY_SINT16, i16_decoded, 2,
+                                       &num_elements);
+    TEST_ASSERT_EQUAL(sizeof(typed_le), len);
+    TEST_ASSERT_EQUAL(0, memcmp(typed_values, i16_decoded, sizeof(typed_values)));
+
+    // wrong element type or too many elements
+    TEST_ASSERT_EQUAL(0, cbor_deserialize_typed_array(typed_be, CBOR_TYPED_ARRAY_UINT16,
+                                                      i16_decoded, 2, &num_elements));
+    TEST_ASSERT_EQUAL(0, cbor_deserialize_typed_array(typed_be, CBOR_TYPED_ARRAY_SINT16,
+                                                      i16_decoded, 1, &num_elements));
+}
+
+#if CONFIG_THINGSET_CBOR_TYPED_ARRAYS
+
+void test_bin_patch_typed_array(void)
+{
+    int32_t *arr = (int32_t *)int32_array.elements;
+
+    const uint8_t req[] = {
+        TS_PATCH, 0x18, ID_CONF, 0xA1, 0x19, 0x70, 0x03, // arrayi32
+        0xD8,     CBOR_TYPED_ARRAY_SINT32, 0x48, 0x00, 0x00, 0x00, 0x07, 0xFF, 0xFF, 0xFF, 0xFE
+    };
+    const uint8_t resp_expected[] = { TS_STATUS_CHANGED };
+
+    TEST_ASSERT_BIN_REQ_EXP_BIN(req, sizeof(req), resp_expected, sizeof(resp_expected));
+
+    TEST_ASSERT_EQUAL(2, int32_array.num_elements);
+    TEST_ASSERT_EQUAL(7, arr[0]);
+    TEST_ASSERT_EQUAL(-2, arr[1]);
+
+    arr[0] = 4;
+    arr[1] = 2;
+    int32_array.num_elements = 4;
+}
+
+#endif
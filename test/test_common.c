@@ -6,6 +6,9 @@
 
 #include "test.h"
 
+#include <errno.h>
+#include <string.h>
+
 /**
  * @brief Test Asserts
  *
@@ -334,3 +337,827 @@ void test_ts_init(void)
 
     TEST_ASSERT_EQUAL(0, ret);
 }
+
+/**
+ * @brief Test ts_init_indexed
+ *
+ * All data objects must be found via the index, same as with the linear search.
+ */
+void test_ts_init_indexed(void)
+{
+    struct ts_context ts_linear;
+    int ret;
+
+    (void)ts_init(&ts_linear, &data_objects[0], data_objects_size);
+
+    ret = ts_init_indexed(&ts, &data_objects[0], data_objects_size, index_buf,
+                          ARRAY_SIZE(index_buf));
+    TEST_ASSERT_EQUAL(0, ret);
+    TEST_ASSERT_NOT_NULL(ts.index.ids);
+
+    for (size_t i = 0; i < data_objects_size; i++) {
+        TEST_ASSERT_EQUAL_PTR(ts_get_object_by_id(&ts_linear, data_objects[i].id),
+                              ts_get_object_by_id(&ts, data_objects[i].id));
+    }
+    TEST_ASSERT_NULL(ts_get_object_by_id(&ts, 0xFFFE));
+
+    for (size_t i = 0; i < data_objects_size; i++) {
+        const char *name = data_objects[i].name;
+        TEST_ASSERT_EQUAL_PTR(
+            ts_get_object_by_name(&ts_linear, name, strlen(name), data_objects[i].parent),
+            ts_get_object_by_name(&ts, name, strlen(name), data_objects[i].parent));
+    }
+    TEST_ASSERT_NULL(ts_get_object_by_name(&ts, "rBat", 4, ID_MEAS)); // prefix of rBat_V
+    TEST_ASSERT_NULL(ts_get_object_by_name(&ts, "rBat_V", 6, ID_ROOT));
+
+    // context still usable with linear search if buffer is too small
+    ret = ts_init_indexed(&ts, &data_objects[0], data_objects_size, index_buf, 1);
+    TEST_ASSERT_EQUAL(-ENOMEM, ret);
+    TEST_ASSERT_NULL(ts.index.ids);
+    TEST_ASSERT_EQUAL_PTR(&data_objects[0], ts_get_object_by_id(&ts, 0x10));
+}
+
+/**
+ * @brief Test ts_init_prebuilt
+ *
+ * Uses an index built at runtime instead of a generated one, as the generated index depends on
+ * the configuration.
+ */
+void test_ts_init_prebuilt(void)
+{
+    static uint16_t subsets_buf[TS_SUBSET_INDEX_LEN(200)];
+    struct ts_context ts_prebuilt;
+    int ret;
+
+    (void)ts_init_indexed(&ts, &data_objects[0], data_objects_size, index_buf,
+                          ARRAY_SIZE(index_buf));
+    const struct ts_index index = ts.index;
+
+    ret = ts_init_prebuilt(&ts_prebuilt, &data_objects[0], data_objects_size, &index, subsets_buf,
+                           ARRAY_SIZE(subsets_buf));
+    TEST_ASSERT_EQUAL(0, ret);
+
+    for (size_t i = 0; i < data_objects_size; i++) {
+        TEST_ASSERT_EQUAL_PTR(&data_objects[i],
+                              ts_get_object_by_id(&ts_prebuilt, data_objects[i].id));
+    }
+
+    // subset member lists are built in the separate RAM buffer
+    TEST_ASSERT_EQUAL_PTR(subsets_buf, ts_prebuilt.index.subsets);
+    TEST_ASSERT_TRUE(ts_prebuilt.index.subsets_valid);
+    struct ts_data_object *member;
+    struct ts_member_iter iter = { 0 };
+    struct ts_member_iter iter_prebuilt = { 0 };
+    do {
+        member = ts_get_next_member(&ts, SUBSET_REPORT, &iter);
+        TEST_ASSERT_EQUAL_PTR(member, ts_get_next_member(&ts_prebuilt, SUBSET_REPORT,
+                                                         &iter_prebuilt));
+    } while (member != NULL);
+
+    // without buffer, subsets are searched linearly
+    ret = ts_init_prebuilt(&ts_prebuilt, &data_objects[0], data_objects_size, &index, NULL, 0);
+    TEST_ASSERT_EQUAL(0, ret);
+    TEST_ASSERT_NULL(ts_prebuilt.index.subsets);
+    TEST_ASSERT_FALSE(ts_prebuilt.index.subsets_valid);
+
+    // index generated for a different array
+    ret = ts_init_prebuilt(&ts_prebuilt, &data_objects[0], data_objects_size - 1, &index,
+                           subsets_buf, ARRAY_SIZE(subsets_buf));
+    TEST_ASSERT_EQUAL(-EINVAL, ret);
+    TEST_ASSERT_NULL(ts_prebuilt.index.ids);
+}
+
+/**
+ * @brief Test ts_get_next_child
+ *
+ * The children table must return the same objects in the same order as the linear search.
+ */
+void test_ts_get_next_child(void)
+{
+    struct ts_context ts_linear;
+
+    (void)ts_init(&ts_linear, &data_objects[0], data_objects_size);
+    (void)ts_init_indexed(&ts, &data_objects[0], data_objects_size, index_buf,
+                          ARRAY_SIZE(index_buf));
+    TEST_ASSERT_NOT_NULL(ts.index.children);
+
+    for (size_t i = 0; i < data_objects_size; i++) {
+        struct ts_data_object *child;
+        unsigned int iter_linear = 0;
+        unsigned int iter = 0;
+        do {
+            child = ts_get_next_child(&ts_linear, data_objects[i].id, &iter_linear);
+            TEST_ASSERT_EQUAL_PTR(child, ts_get_next_child(&ts, data_objects[i].id, &iter));
+        } while (child != NULL);
+
+        // iteration must not be restarted after the last child
+        TEST_ASSERT_NULL(ts_get_next_child(&ts, data_objects[i].id, &iter));
+    }
+
+    unsigned int iter = 0;
+    TEST_ASSERT_NULL(ts_get_next_child(&ts, 0xFFFE, &iter));
+}
+
+/**
+ * @brief Test ts_get_next_member
+ *
+ * The subset lists must return the same objects in the same order as the linear search, also
+ * for combinations of subsets.
+ */
+void test_ts_get_next_member(void)
+{
+    struct ts_context ts_linear;
+
+    (void)ts_init(&ts_linear, &data_objects[0], data_objects_size);
+    (void)ts_init_indexed(&ts, &data_objects[0], data_objects_size, index_buf,
+                          ARRAY_SIZE(index_buf));
+    TEST_ASSERT_TRUE(ts.index.subsets_valid);
+
+    for (uint16_t subsets = 0; subsets < (1U << TS_NUM_SUBSETS); subsets++) {
+        struct ts_data_object *member;
+        struct ts_member_iter iter_linear = { 0 };
+        struct ts_member_iter iter = { 0 };
+        do {
+            member = ts_get_next_member(&ts_linear, subsets, &iter_linear);
+            TEST_ASSERT_EQUAL_PTR(member, ts_get_next_member(&ts, subsets, &iter));
+        } while (member != NULL);
+    }
+
+    // linear search while the lists are rebuilt by another context, which repeats the rebuild
+    struct ts_data_object *member;
+    struct ts_member_iter iter_linear = { 0 };
+    struct ts_member_iter iter = { 0 };
+    member = ts_get_next_member(&ts_linear, SUBSET_REPORT, &iter_linear);
+    TEST_ASSERT_EQUAL_PTR(member, ts_get_next_member(&ts, SUBSET_REPORT, &iter));
+    ts.index.subsets_seq++;
+    TEST_ASSERT_EQUAL(0, ts_index_update_subsets(&ts));
+    TEST_ASSERT_TRUE(ts.index.subsets_dirty);
+    member = ts_get_next_member(&ts_linear, SUBSET_REPORT, &iter_linear);
+    TEST_ASSERT_EQUAL_PTR(member, ts_get_next_member(&ts, SUBSET_REPORT, &iter));
+    ts.index.subsets_seq++;
+    TEST_ASSERT_EQUAL(0, ts_index_update_subsets(&ts));
+    TEST_ASSERT_FALSE(ts.index.subsets_dirty);
+    do {
+        member = ts_get_next_member(&ts_linear, SUBSET_REPORT, &iter_linear);
+        TEST_ASSERT_EQUAL_PTR(member, ts_get_next_member(&ts, SUBSET_REPORT, &iter));
+    } while (member != NULL);
+
+    // fall back to linear search if the lists don't fit into the buffer
+    ts.index.subsets_size = 1;
+    TEST_ASSERT_EQUAL(-ENOMEM, ts_index_update_subsets(&ts));
+    TEST_ASSERT_FALSE(ts.index.subsets_valid);
+    memset(&iter, 0, sizeof(iter));
+    TEST_ASSERT_EQUAL_PTR(ts_get_object_by_id(&ts, 0x10),
+                          ts_get_next_member(&ts, SUBSET_REPORT, &iter));
+}
+
+#if CONFIG_THINGSET_PATH_CACHE_SIZE > 0
+
+/**
+ * @brief Test path cache
+ *
+ * Cached paths must return the same object and record index as resolved paths. The least
+ * recently used entry is replaced if the cache is full.
+ */
+void test_ts_path_cache(void)
+{
+    struct ts_path_cache *cache = &ts.path_cache;
+    char path[CONFIG_THINGSET_PATH_CACHE_MAX_LEN];
+    int record_index = RECORD_INDEX_NONE;
+
+    TEST_ASSERT_EQUAL(0, cache->hits);
+    TEST_ASSERT_EQUAL(0, cache->misses);
+
+    struct ts_data_object *obj = ts_get_object_by_path(&ts, "Meas/rBat_V", 11);
+    TEST_ASSERT_EQUAL_PTR(ts_get_object_by_id(&ts, 0x71), obj);
+    TEST_ASSERT_EQUAL_PTR(obj, ts_get_object_by_path(&ts, "Meas/rBat_V", 11));
+    TEST_ASSERT_EQUAL(1, cache->hits);
+    TEST_ASSERT_EQUAL(1, cache->misses);
+
+    // prefix of a cached path
+    TEST_ASSERT_NULL(ts_get_object_by_path(&ts, "Meas/rBat", 9));
+    TEST_ASSERT_EQUAL(2, cache->misses);
+
+    // record index is restored from the cache
+    obj = ts_get_endpoint_by_path(&ts, "Log/3", 5, &record_index);
+    TEST_ASSERT_EQUAL_HEX(0x7005, obj->id);
+    TEST_ASSERT_EQUAL(3, record_index);
+    record_index = RECORD_INDEX_NONE;
+    TEST_ASSERT_EQUAL_PTR(obj, ts_get_endpoint_by_path(&ts, "Log/3", 5, &record_index));
+    TEST_ASSERT_EQUAL(3, record_index);
+    TEST_ASSERT_EQUAL(2, cache->hits);
+
+    // use the other paths once more, so that Log/3 is the least recently used one
+    ts_get_object_by_path(&ts, "Meas/rBat_V", 11);
+    for (int i = 0; i < CONFIG_THINGSET_PATH_CACHE_SIZE - 2; i++) {
+        // different (invalid) record indices result in different paths
+        int len = snprintf(path, sizeof(path), "Log/%d", 100 + i);
+        ts_get_object_by_path(&ts, path, len);
+    }
+    TEST_ASSERT_EQUAL(3, cache->hits);
+
+    // cache is full, so Log/3 is replaced
+    ts_get_object_by_path(&ts, "Meas/rBat_A", 11);
+    uint32_t misses = cache->misses;
+    ts_get_object_by_path(&ts, "Log/3", 5);
+    TEST_ASSERT_EQUAL(misses + 1, cache->misses);
+
+    ts_clear_path_cache(&ts);
+    TEST_ASSERT_EQUAL(0, cache->hits);
+    ts_get_object_by_path(&ts, "Meas/rBat_V", 11);
+    TEST_ASSERT_EQUAL(0, cache->hits);
+}
+
+#endif /* CONFIG_THINGSET_PATH_CACHE_SIZE > 0 */
+
+static void assert_chunked_response(const uint8_t *req, size_t req_len)
+{
+    uint8_t resp[TS_RESP_BUFFER_LEN];
+    uint8_t chunked[TS_RESP_BUFFER_LEN];
+    uint8_t scratch[100];
+    uint8_t chunk[7];
+    size_t len = 0;
+    int ret;
+
+    int resp_len = ts_process(&ts, req, req_len, resp, sizeof(resp));
+    TEST_ASSERT_TRUE(resp_len > 0);
+
+    TEST_ASSERT_EQUAL(0, ts_process_begin(&ts, req, req_len, scratch, sizeof(scratch)));
+    while ((ret = ts_process_next_chunk(&ts, chunk, sizeof(chunk))) > 0) {
+        TEST_ASSERT_TRUE(len + ret <= sizeof(chunked));
+        memcpy(&chunked[len], chunk, ret);
+        len += ret;
+    }
+    TEST_ASSERT_EQUAL(0, ret);
+
+    TEST_ASSERT_EQUAL(resp_len, len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(resp, chunked, resp_len);
+}
+
+/**
+ * @brief Test response generation in chunks
+ *
+ * The concatenated chunks must be identical to the response of ts_process, also if the response
+ * is larger than the scratch buffer.
+ */
+void test_ts_process_chunked(void)
+{
+    const char *txt_requests[] = {
+        "?", "?Meas", "?Meas/", "?Meas/rBat_V", "?Nested", "?RPC", "?Log/1", "?Log", "?Unknown",
+        "@7 ?Conf",
+    };
+    const uint8_t bin_get_meas_id[] = { TS_GET, ID_MEAS };
+    const uint8_t bin_get_meas_name[] = { TS_GET, 0x64, 'M', 'e', 'a', 's' };
+    const uint8_t bin_get_record[] = { TS_GET, 0x65, 'L', 'o', 'g', '/', '1' };
+    const uint8_t bin_get_value[] = { TS_GET, 0x18, 0x71 };
+    const uint8_t bin_get_meas_with_id[] = { TS_REQUEST_ID, 0x18, 0xC8, TS_GET, ID_MEAS };
+    uint8_t scratch[64];
+    uint8_t chunk[16];
+
+    for (size_t i = 0; i < ARRAY_SIZE(txt_requests); i++) {
+        assert_chunked_response((const uint8_t *)txt_requests[i], strlen(txt_requests[i]));
+    }
+
+    assert_chunked_response(bin_get_meas_id, sizeof(bin_get_meas_id));
+    assert_chunked_response(bin_get_meas_name, sizeof(bin_get_meas_name));
+    assert_chunked_response(bin_get_record, sizeof(bin_get_record));
+    assert_chunked_response(bin_get_value, sizeof(bin_get_value));
+    assert_chunked_response(bin_get_meas_with_id, sizeof(bin_get_meas_with_id));
+
+    // ts_process resets the chunk state
+    TEST_ASSERT_EQUAL(0, ts_process_begin(&ts, (const uint8_t *)"?", 1, scratch, sizeof(scratch)));
+    ts_process(&ts, (const uint8_t *)"?", 1, scratch, sizeof(scratch));
+    TEST_ASSERT_EQUAL(0, ts_process_next_chunk(&ts, chunk, sizeof(chunk)));
+
+    // scratch buffer too small for a single element
+    TEST_ASSERT_EQUAL(0, ts_process_begin(&ts, (const uint8_t *)"?Meas", 5, scratch, 16));
+    int ret;
+    do {
+        ret = ts_process_next_chunk(&ts, chunk, sizeof(chunk));
+    } while (ret > 0);
+    TEST_ASSERT_EQUAL(-ENOMEM, ret);
+
+    // same for binary mode if only the key of an element fits
+    const uint8_t bin_get_info[] = { TS_GET, 0x64, 'I', 'n', 'f', 'o' };
+    TEST_ASSERT_EQUAL(0, ts_process_begin(&ts, bin_get_info, sizeof(bin_get_info), scratch, 20));
+    do {
+        ret = ts_process_next_chunk(&ts, chunk, sizeof(chunk));
+    } while (ret > 0);
+    TEST_ASSERT_EQUAL(-ENOMEM, ret);
+
+    TEST_ASSERT_EQUAL(-EINVAL,
+                      ts_process_begin(&ts, (const uint8_t *)"foo", 3, scratch, sizeof(scratch)));
+    TEST_ASSERT_EQUAL(-EINVAL, ts_process_begin(&ts, (const uint8_t *)"@7 @8 ?Conf", 11, scratch,
+                                                sizeof(scratch)));
+}
+
+/**
+ * @brief Test processing of multiple requests in a single call
+ *
+ * The responses in the batch must be the same as for separate calls of ts_process.
+ */
+void test_ts_process_batch(void)
+{
+    const uint8_t bin_batch[] = {
+        0x83,                                          // array with 3 elements
+        0x43, TS_GET, 0x18, 0x71,                      // GET rBat_V by ID
+        0x46, TS_GET, 0x64, 'M', 'e', 'a', 's',        // GET Meas by name
+        0x4C, '?', 'M', 'e', 'a', 's', '/', 'r', 'B', 'a', 't', '_', 'V', // text request
+    };
+    const char txt_batch[] = "?Meas/rBat_V\n?Unknown\r\n\n#Meas {\"rBat_V\":14.1}\n?Conf/i32";
+    uint8_t expected[TS_RESP_BUFFER_LEN];
+    size_t pos = 1;
+    int len;
+
+    expected[0] = 0x83;
+    for (size_t i = 1; i < sizeof(bin_batch); i += (bin_batch[i] & 0x1F) + 1) {
+        uint8_t sub_resp[100];
+        len = ts_process(&ts, &bin_batch[i + 1], bin_batch[i] & 0x1F, sub_resp, sizeof(sub_resp));
+        TEST_ASSERT_TRUE(len > 0 && len < 256);
+        if (len <= 23) {
+            expected[pos++] = 0x40 + len;
+        }
+        else {
+            expected[pos++] = 0x58;
+            expected[pos++] = len;
+        }
+        memcpy(&expected[pos], sub_resp, len);
+        pos += len;
+    }
+
+    len = ts_process_batch(&ts, bin_batch, sizeof(bin_batch), resp_buf, TS_RESP_BUFFER_LEN);
+    TEST_ASSERT_EQUAL(pos, len);
+    TEST_ASSERT_EQUAL(0, memcmp(expected, resp_buf, pos));
+
+    // responses of a malformed batch must not be generated
+    TEST_ASSERT_EQUAL(-EINVAL,
+                      ts_process_batch(&ts, bin_batch, sizeof(bin_batch) - 1, resp_buf, 100));
+    TEST_ASSERT_EQUAL(-EINVAL, ts_process_batch(&ts, bin_batch, 1, resp_buf, 100));
+    const uint8_t truncated_head8[] = { 0x98 };
+    const uint8_t truncated_head16[] = { 0x99, 0x00 };
+    TEST_ASSERT_EQUAL(-EINVAL, ts_process_batch(&ts, truncated_head8, 1, resp_buf, 100));
+    TEST_ASSERT_EQUAL(-EINVAL, ts_process_batch(&ts, truncated_head16, 2, resp_buf, 100));
+    TEST_ASSERT_EQUAL(-ENOMEM, ts_process_batch(&ts, bin_batch, sizeof(bin_batch), resp_buf, 10));
+
+    const char *txt_requests[] = { "?Meas/rBat_V", "?Unknown", "#Meas {\"rBat_V\":14.1}",
+                                   "?Conf/i32" };
+    pos = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(txt_requests); i++) {
+        len = ts_process(&ts, (const uint8_t *)txt_requests[i], strlen(txt_requests[i]),
+                         &expected[pos], sizeof(expected) - pos);
+        pos += len;
+        expected[pos++] = '\n';
+    }
+    expected[pos] = '\0';
+
+    len = ts_process_batch(&ts, (const uint8_t *)txt_batch, strlen(txt_batch), resp_buf,
+                           TS_RESP_BUFFER_LEN);
+    TEST_ASSERT_EQUAL(pos, len);
+    TEST_ASSERT_EQUAL_STRING((char *)expected, (char *)resp_buf);
+
+    TEST_ASSERT_EQUAL(-ENOMEM, ts_process_batch(&ts, (const uint8_t *)txt_batch,
+                                                strlen(txt_batch), resp_buf, 20));
+
+    // binary requests can't be part of a text mode batch
+    const uint8_t bin_in_txt[] = { TS_GET, 0x18, 0x71 };
+    len = ts_process(&ts, bin_in_txt, sizeof(bin_in_txt), expected, sizeof(expected));
+    TEST_ASSERT_EQUAL(-EINVAL, ts_process_batch(&ts, bin_in_txt, sizeof(bin_in_txt), resp_buf,
+                                                len + 1));
+    const char mixed_batch[] = "?Meas/rBat_V\n\x01\x18\x71";
+    TEST_ASSERT_EQUAL(-EINVAL, ts_process_batch(&ts, (const uint8_t *)mixed_batch,
+                                                strlen(mixed_batch), resp_buf, 100));
+}
+
+void test_ts_request_id(void)
+{
+    const uint8_t bin_req[] = { TS_REQUEST_ID, 0x18, 0xC8, TS_GET, 0x18, 0x71 };
+    uint8_t expected[100];
+    uint32_t id;
+
+    // binary mode: same response as without ID, but with the same ID prefix
+    int len = ts_process(&ts, &bin_req[3], sizeof(bin_req) - 3, expected, sizeof(expected));
+    TEST_ASSERT_TRUE(len > 0);
+    TEST_ASSERT_EQUAL(len + 3, ts_process(&ts, bin_req, sizeof(bin_req), resp_buf, 100));
+    TEST_ASSERT_EQUAL(3, ts_request_id_parse(resp_buf, len + 3, &id));
+    TEST_ASSERT_EQUAL_UINT32(200, id);
+    TEST_ASSERT_EQUAL(0, memcmp(expected, &resp_buf[3], len));
+
+    // text mode
+    TEST_ASSERT_TXT_REQ("@42 ?Meas/rBat_V", "@42 :85 Content. 14.10");
+    TEST_ASSERT_TXT_REQ("@4294967295 =Conf {\"i32\":50}", "@4294967295 :84 Changed.");
+
+    // no response for statements and invalid prefixes
+    TEST_ASSERT_EQUAL(0, ts_process(&ts, (const uint8_t *)"@1 #Meas {\"rBat_V\":14.1}", 25,
+                                    resp_buf, 100));
+    TEST_ASSERT_EQUAL(0, ts_process(&ts, (const uint8_t *)"@4294967296 ?Meas", 17, resp_buf, 100));
+    TEST_ASSERT_EQUAL(0, ts_process(&ts, (const uint8_t *)"@ ?Meas", 7, resp_buf, 100));
+    TEST_ASSERT_EQUAL(0, ts_process(&ts, (const uint8_t *)"@1 @2 ?Meas", 11, resp_buf, 100));
+    TEST_ASSERT_EQUAL(0, ts_process(&ts, bin_req, 2, resp_buf, 100));
+
+    TEST_ASSERT_EQUAL(0, ts_request_id_parse((const uint8_t *)"?Meas", 5, &id));
+    TEST_ASSERT_EQUAL(-EINVAL, ts_request_id_parse((const uint8_t *)"@12", 3, &id));
+}
+
+/**
+ * @brief Test matching of out-of-order responses with the pipelined requests
+ */
+void test_ts_pipeline(void)
+{
+    const char *requests[] = { "?Meas/rBat_V", "?Meas/rBat_A", "?Meas/rAmbient_degC" };
+    struct ts_pipeline_slot slots[3];
+    struct ts_pipeline pl;
+    uint8_t framed[3][40];
+    uint8_t responses[3][60];
+    int resp_len[3];
+    uint32_t ids[3];
+    const uint8_t *payload;
+    size_t payload_len;
+    void *user_data;
+
+    ts_pipeline_init(&pl, slots, ARRAY_SIZE(slots));
+
+    for (int i = 0; i < 3; i++) {
+        int len = ts_pipeline_request(&pl, (const uint8_t *)requests[i], strlen(requests[i]),
+                                      framed[i], sizeof(framed[i]), (void *)requests[i], &ids[i]);
+        TEST_ASSERT_TRUE(len > 0);
+        resp_len[i] = ts_process(&ts, framed[i], len, responses[i], sizeof(responses[i]));
+        TEST_ASSERT_TRUE(resp_len[i] > 0);
+    }
+    TEST_ASSERT_EQUAL(3, pl.num_pending);
+    TEST_ASSERT_EQUAL(-EBUSY, ts_pipeline_request(&pl, (const uint8_t *)"?", 1, framed[0],
+                                                  sizeof(framed[0]), NULL, NULL));
+
+    // responses arrive in reverse order
+    for (int i = 2; i >= 0; i--) {
+        uint8_t expected[60];
+        int len = ts_process(&ts, (const uint8_t *)requests[i], strlen(requests[i]), expected,
+                             sizeof(expected));
+
+        TEST_ASSERT_EQUAL(0, ts_pipeline_response(&pl, responses[i], resp_len[i], &payload,
+                                                  &payload_len, &user_data));
+        TEST_ASSERT_EQUAL_PTR(requests[i], user_data);
+        TEST_ASSERT_EQUAL(len, payload_len);
+        TEST_ASSERT_EQUAL(0, memcmp(expected, payload, len));
+    }
+    TEST_ASSERT_EQUAL(0, pl.num_pending);
+
+    // duplicate or unknown responses are rejected
+    TEST_ASSERT_EQUAL(-ENOENT, ts_pipeline_response(&pl, responses[0], resp_len[0], &payload,
+                                                    &payload_len, NULL));
+    TEST_ASSERT_EQUAL(-EINVAL, ts_pipeline_response(&pl, (const uint8_t *)":85 Content.", 12,
+                                                    &payload, &payload_len, NULL));
+
+    // cancelled requests release their slot
+    uint8_t bin_req[] = { TS_GET, 0x18, 0x71 };
+    int len = ts_pipeline_request(&pl, bin_req, sizeof(bin_req), framed[0], sizeof(framed[0]),
+                                  NULL, &ids[0]);
+    TEST_ASSERT_EQUAL(TS_REQUEST_ID, framed[0][0]);
+    TEST_ASSERT_EQUAL(sizeof(bin_req) + 2, len);
+    TEST_ASSERT_EQUAL(0, ts_pipeline_cancel(&pl, ids[0]));
+    TEST_ASSERT_EQUAL(-ENOENT, ts_pipeline_cancel(&pl, ids[0]));
+    TEST_ASSERT_EQUAL(0, pl.num_pending);
+    resp_len[0] = ts_process(&ts, framed[0], len, responses[0], sizeof(responses[0]));
+    TEST_ASSERT_EQUAL(-ENOENT, ts_pipeline_response(&pl, responses[0], resp_len[0], &payload,
+                                                    &payload_len, NULL));
+}
+
+static bool is_member(struct ts_context *ts_ctx, uint16_t subsets,
+                      const struct ts_data_object *obj)
+{
+    struct ts_data_object *member;
+    struct ts_member_iter iter = { 0 };
+    while ((member = ts_get_next_member(ts_ctx, subsets, &iter)) != NULL) {
+        if (member == obj) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Test context sharing the data objects with another context
+ *
+ * The request state must be independent, while data objects and subsets are shared.
+ */
+void test_ts_init_shared(void)
+{
+    struct ts_context ts_shared;
+    uint8_t resp[TS_RESP_BUFFER_LEN];
+    uint8_t chunked[TS_RESP_BUFFER_LEN];
+    uint8_t scratch[100];
+    size_t len = 0;
+    int ret;
+
+    TEST_ASSERT_EQUAL(0, ts_init_shared(&ts_shared, &ts));
+    TEST_ASSERT_EQUAL_PTR(ts_get_object_by_id(&ts, 0x71), ts_get_object_by_id(&ts_shared, 0x71));
+    TEST_ASSERT_EQUAL_PTR(ts_get_object_by_path(&ts, "Meas/rBat_V", 11),
+                          ts_get_object_by_path(&ts_shared, "Meas/rBat_V", 11));
+
+    // authentication is stored per context
+    ts_set_authentication(&ts, TS_EXP_MASK | TS_USR_MASK);
+    TEST_ASSERT_EQUAL_HEX8(TS_USR_MASK, ts_shared._auth_flags);
+    ts_set_authentication(&ts, TS_USR_MASK);
+
+    // requests of the other context don't interfere with a response generated in chunks
+    int resp_len = ts_process(&ts, (const uint8_t *)"?Meas", 5, resp, sizeof(resp));
+    TEST_ASSERT_EQUAL(0, ts_process_begin(&ts_shared, (const uint8_t *)"?Meas", 5, scratch,
+                                          sizeof(scratch)));
+    len += ts_process_next_chunk(&ts_shared, chunked, 10);
+    TEST_ASSERT_TRUE(ts_process(&ts, (const uint8_t *)"?Conf", 5, resp_buf, sizeof(resp_buf)) > 0);
+    while ((ret = ts_process_next_chunk(&ts_shared, &chunked[len], 10)) > 0) {
+        len += ret;
+    }
+    TEST_ASSERT_EQUAL(resp_len, len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(resp, chunked, resp_len);
+
+    // subsets changed via one context are updated in the shared index
+    struct ts_data_object *obj = ts_get_object_by_id(&ts, 0x71);
+    const char *path = CONFIG_THINGSET_NESTED_JSON ? "\"Meas/rBat_V\"" : "\"rBat_V\"";
+    char req[30];
+    TEST_ASSERT_TRUE(is_member(&ts, SUBSET_REPORT, obj));
+    len = snprintf(req, sizeof(req), "-mReport %s", path);
+    ts_process(&ts_shared, (const uint8_t *)req, len, resp_buf, sizeof(resp_buf));
+    TEST_ASSERT_FALSE(is_member(&ts, SUBSET_REPORT, obj));
+    TEST_ASSERT_FALSE(is_member(&ts_shared, SUBSET_REPORT, obj));
+    len = snprintf(req, sizeof(req), "+mReport %s", path);
+    ts_process(&ts, (const uint8_t *)req, len, resp_buf, sizeof(resp_buf));
+    TEST_ASSERT_TRUE(is_member(&ts_shared, SUBSET_REPORT, obj));
+
+    // update callback configured after sharing applies to all contexts
+    update_callback_called = false;
+    ts_set_update_callback(&ts, SUBSET_NVM, update_callback);
+    ts_process(&ts_shared, (const uint8_t *)"=Conf {\"sBatCharging_V\":52}", 27, resp_buf,
+               sizeof(resp_buf));
+    TEST_ASSERT_EQUAL_STRING(":84 Changed.", (char *)resp_buf);
+    TEST_ASSERT_TRUE(update_callback_called);
+    ts_set_update_callback(&ts_shared, SUBSET_NVM, NULL);
+    update_callback_called = false;
+    ts_process(&ts, (const uint8_t *)"=Conf {\"sBatCharging_V\":52}", 27, resp_buf,
+               sizeof(resp_buf));
+    TEST_ASSERT_FALSE(update_callback_called);
+}
+
+#if CONFIG_THINGSET_SEQLOCK
+
+/**
+ * @brief Test sequence locks for subsets
+ *
+ * Exports and statements of a subset must fail while its values are updated.
+ */
+void test_ts_seqlock(void)
+{
+    struct ts_seqlock lock = { 0 };
+    char txt[TS_RESP_BUFFER_LEN];
+
+    ts_set_seqlock(&ts, SUBSET_REPORT, &lock);
+
+    TEST_ASSERT_TRUE(ts_bin_export(&ts, resp_buf, sizeof(resp_buf), SUBSET_REPORT) > 0);
+
+    ts_seqlock_write_begin(&lock);
+    TEST_ASSERT_EQUAL(0, ts_bin_export(&ts, resp_buf, sizeof(resp_buf), SUBSET_REPORT));
+    TEST_ASSERT_EQUAL(0, ts_txt_export(&ts, txt, sizeof(txt), SUBSET_REPORT));
+    TEST_ASSERT_EQUAL(0, ts_bin_statement_by_path(&ts, resp_buf, sizeof(resp_buf), "mReport"));
+    TEST_ASSERT_EQUAL(0, ts_txt_statement_by_path(&ts, txt, sizeof(txt), "mReport"));
+
+    // delta statements can't take a snapshot, while captured values are not affected
+    struct ts_data_object *report = ts_get_object_by_path(&ts, "mReport", 7);
+    struct ts_delta_state delta;
+    struct ts_capture_queue queue;
+    uint8_t buf[64];
+    TEST_ASSERT_EQUAL(0, ts_delta_init(&ts, &delta, report, buf, sizeof(buf), 0));
+    TEST_ASSERT_EQUAL(-EBUSY, ts_txt_delta_statement(&ts, &delta, txt, sizeof(txt)));
+    TEST_ASSERT_EQUAL(0, ts_capture_init(&ts, &queue, report, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(0, ts_capture_push(&ts, &queue));
+    TEST_ASSERT_TRUE(ts_capture_txt_statement(&ts, &queue, txt, sizeof(txt)) > 0);
+
+    // other subsets are not affected
+    TEST_ASSERT_TRUE(ts_bin_export(&ts, resp_buf, sizeof(resp_buf), SUBSET_NVM) > 0);
+
+    ts_seqlock_write_end(&lock);
+    TEST_ASSERT_EQUAL(2, lock.seq);
+    TEST_ASSERT_TRUE(ts_bin_export(&ts, resp_buf, sizeof(resp_buf), SUBSET_REPORT) > 0);
+    TEST_ASSERT_TRUE(ts_txt_export(&ts, txt, sizeof(txt), SUBSET_REPORT) > 0);
+    TEST_ASSERT_TRUE(ts_bin_statement_by_path(&ts, resp_buf, sizeof(resp_buf), "mReport") > 0);
+
+    // locks are registered in the owning context
+    struct ts_context ts_shared;
+    ts_init_shared(&ts_shared, &ts);
+    ts_seqlock_write_begin(&lock);
+    TEST_ASSERT_EQUAL(0, ts_txt_export(&ts_shared, txt, sizeof(txt), SUBSET_REPORT));
+    ts_seqlock_write_end(&lock);
+
+    ts_set_seqlock(&ts_shared, SUBSET_REPORT, NULL);
+    ts_seqlock_write_begin(&lock);
+    TEST_ASSERT_TRUE(ts_txt_export(&ts, txt, sizeof(txt), SUBSET_REPORT) > 0);
+    ts_seqlock_write_end(&lock);
+}
+
+#endif /* CONFIG_THINGSET_SEQLOCK */
+
+/**
+ * @brief Test capture queue
+ *
+ * Statements generated from captured values must contain the values at the time of the capture.
+ */
+void test_ts_capture(void)
+{
+    struct ts_capture_queue queue;
+    struct ts_data_object *report = ts_get_object_by_path(&ts, "mReport", 7);
+    uint32_t *timestamp = (uint32_t *)ts_get_object_by_id(&ts, 0x10)->data;
+    const uint32_t timestamp_orig = *timestamp;
+    uint8_t buf[64];
+    char expected_txt[TS_RESP_BUFFER_LEN];
+    uint8_t expected_bin[TS_RESP_BUFFER_LEN];
+    char txt[TS_RESP_BUFFER_LEN];
+
+    TEST_ASSERT_EQUAL(-EINVAL, ts_capture_init(&ts, &queue, ts_get_object_by_id(&ts, 0x10), buf,
+                                               sizeof(buf)));
+    TEST_ASSERT_EQUAL(-ENOMEM, ts_capture_init(&ts, &queue, report, buf, 8));
+    TEST_ASSERT_EQUAL(0, ts_capture_init(&ts, &queue, report, buf, sizeof(buf)));
+
+    // empty queue
+    TEST_ASSERT_EQUAL(0, ts_capture_txt_statement(&ts, &queue, txt, sizeof(txt)));
+
+    *timestamp = 12345;
+    int txt_len = ts_txt_statement(&ts, expected_txt, sizeof(expected_txt), report);
+    int bin_len = ts_bin_statement(&ts, expected_bin, sizeof(expected_bin), report);
+    TEST_ASSERT_EQUAL(0, ts_capture_push(&ts, &queue));
+    TEST_ASSERT_EQUAL(0, ts_capture_push(&ts, &queue));
+
+    // fill remaining slots
+    int pushed = 2;
+    while (ts_capture_push(&ts, &queue) == 0) {
+        pushed++;
+    }
+    TEST_ASSERT_EQUAL(queue.num_slots - 1, pushed);
+    TEST_ASSERT_EQUAL(-ENOSPC, ts_capture_push(&ts, &queue));
+
+    *timestamp = 54321;
+
+    TEST_ASSERT_EQUAL(txt_len, ts_capture_txt_statement(&ts, &queue, txt, sizeof(txt)));
+    TEST_ASSERT_EQUAL_STRING(expected_txt, txt);
+    TEST_ASSERT_EQUAL(bin_len, ts_capture_bin_statement(&ts, &queue, resp_buf, sizeof(resp_buf)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected_bin, resp_buf, bin_len);
+
+    // captured values are kept if the buffer is too small
+    TEST_ASSERT_EQUAL(-ENOMEM, ts_capture_txt_statement(&ts, &queue, txt, 10));
+    pushed -= 2;
+    while (pushed-- > 0) {
+        TEST_ASSERT_EQUAL(txt_len, ts_capture_txt_statement(&ts, &queue, txt, sizeof(txt)));
+    }
+    TEST_ASSERT_EQUAL(0, ts_capture_txt_statement(&ts, &queue, txt, sizeof(txt)));
+
+    // changed subset members don't match the layout of the slots anymore
+    const char *path = CONFIG_THINGSET_NESTED_JSON ? "\"Meas/rAmbient_degC\"" : "\"rAmbient_degC\"";
+    char req[40];
+    TEST_ASSERT_EQUAL(0, ts_capture_push(&ts, &queue));
+    snprintf(req, sizeof(req), "-mReport %s", path);
+    TEST_ASSERT_TXT_REQ(req, ":82 Deleted.");
+    TEST_ASSERT_EQUAL(-EINVAL, ts_capture_push(&ts, &queue));
+    TEST_ASSERT_EQUAL(-EINVAL, ts_capture_txt_statement(&ts, &queue, txt, sizeof(txt)));
+    TEST_ASSERT_EQUAL(-EINVAL, ts_capture_bin_statement(&ts, &queue, resp_buf, sizeof(resp_buf)));
+    snprintf(req, sizeof(req), "+mReport %s", path);
+    TEST_ASSERT_TXT_REQ(req, ":81 Created.");
+    TEST_ASSERT_EQUAL(txt_len, ts_capture_txt_statement(&ts, &queue, txt, sizeof(txt)));
+
+    // regular statements use the current values again
+    TEST_ASSERT_TRUE(ts_txt_statement(&ts, txt, sizeof(txt), report) > 0);
+    TEST_ASSERT_TRUE(strstr(txt, "54321") != NULL);
+
+    *timestamp = timestamp_orig;
+}
+
+/**
+ * @brief Test delta statements
+ *
+ * Only members changed beyond their deadband are published, except for full statements.
+ */
+void test_ts_delta_statement(void)
+{
+    struct ts_delta_state delta;
+    struct ts_data_object *report = ts_get_object_by_path(&ts, "mReport", 7);
+    float *bat_voltage = (float *)ts_get_object_by_id(&ts, 0x71)->data;
+    int16_t *ambient_temp = (int16_t *)ts_get_object_by_id(&ts, 0x73)->data;
+    const float bat_voltage_orig = *bat_voltage;
+    const int16_t ambient_temp_orig = *ambient_temp;
+    const struct ts_delta_deadband deadbands[] = { { 0x71, 0.1F } };
+    uint8_t buf[64];
+    char expected[TS_RESP_BUFFER_LEN];
+    char txt[TS_RESP_BUFFER_LEN];
+
+    TEST_ASSERT_EQUAL(-ENOMEM, ts_delta_init(&ts, &delta, report, buf, 8, 3));
+    TEST_ASSERT_EQUAL(0, ts_delta_init(&ts, &delta, report, buf, sizeof(buf), 3));
+    ts_delta_set_deadbands(&delta, deadbands, ARRAY_SIZE(deadbands));
+
+    // first statement contains all members
+    int len = ts_txt_statement(&ts, expected, sizeof(expected), report);
+    TEST_ASSERT_EQUAL(len, ts_txt_delta_statement(&ts, &delta, txt, sizeof(txt)));
+    TEST_ASSERT_EQUAL_STRING(expected, txt);
+    TEST_ASSERT_EQUAL(0, ts_txt_delta_statement(&ts, &delta, txt, sizeof(txt)));
+
+    // changes within the deadband are ignored
+    *bat_voltage += 0.05F;
+    *ambient_temp += 1;
+    len = ts_txt_delta_statement(&ts, &delta, txt, sizeof(txt));
+    TEST_ASSERT_EQUAL(strlen(txt), len);
+    if (CONFIG_THINGSET_NESTED_JSON) {
+        TEST_ASSERT_EQUAL_STRING("#mReport {\"Meas\":{\"rAmbient_degC\":23}}", txt);
+    }
+    else {
+        TEST_ASSERT_EQUAL_STRING("#mReport {\"rAmbient_degC\":23}", txt);
+    }
+
+    // full statement after the sync interval
+    len = ts_txt_statement(&ts, expected, sizeof(expected), report);
+    TEST_ASSERT_EQUAL(len, ts_txt_delta_statement(&ts, &delta, txt, sizeof(txt)));
+    TEST_ASSERT_EQUAL_STRING(expected, txt);
+
+    // deadband refers to the last published value
+    *bat_voltage += 0.06F;
+    TEST_ASSERT_EQUAL(0, ts_bin_delta_statement(&ts, &delta, resp_buf, sizeof(resp_buf)));
+    *bat_voltage += 0.06F;
+    len = ts_bin_delta_statement(&ts, &delta, resp_buf, sizeof(resp_buf));
+    TEST_ASSERT_EQUAL(0x1F, resp_buf[0]); // statement
+#if CONFIG_THINGSET_CBOR_INDEFINITE_LENGTH
+    TEST_ASSERT_EQUAL_HEX8(0x9F, resp_buf[len - 7]); // indefinite-length array
+    TEST_ASSERT_EQUAL_HEX8(0xFA, resp_buf[len - 6]); // float32
+    TEST_ASSERT_EQUAL_HEX8(0xFF, resp_buf[len - 1]); // break
+#else
+    TEST_ASSERT_EQUAL_HEX8(0x81, resp_buf[len - 6]); // array with one element
+    TEST_ASSERT_EQUAL_HEX8(0xFA, resp_buf[len - 5]); // float32
+#endif
+
+    // values are published again if the buffer was too small
+    *ambient_temp += 1;
+    TEST_ASSERT_EQUAL(-ENOMEM, ts_txt_delta_statement(&ts, &delta, txt, 5));
+    TEST_ASSERT_TRUE(ts_txt_delta_statement(&ts, &delta, txt, sizeof(txt)) > 0);
+    TEST_ASSERT_TRUE(strstr(txt, "\"rAmbient_degC\":24") != NULL);
+
+    *bat_voltage = bat_voltage_orig;
+    *ambient_temp = ambient_temp_orig;
+}
+
+struct check_record
+{
+    float value;
+    float other;
+};
+
+/**
+ * @brief Test ts_check_objects
+ *
+ * Detection of duplicate IDs, missing parents and misplaced record items.
+ */
+void test_ts_check_objects(void)
+{
+    struct ts_context ts_check;
+    struct ts_object_error err;
+    static float value;
+    static struct ts_records records;
+
+    struct ts_data_object valid[] = {
+        TS_GROUP(0x01, "Meas", TS_NO_CALLBACK, ID_ROOT),
+        TS_ITEM_FLOAT(0x40, "rValue", &value, 1, 0x01, TS_ANY_R, 0),
+        TS_RECORDS(0x2000, "Log", &records, ID_ROOT, TS_ANY_R, 0),
+        TS_RECORD_ITEM_FLOAT(0x81, "rValue", struct check_record, value, 1, 0x2000),
+        TS_RECORD_ITEM_FLOAT(0x82, "rOther", struct check_record, other, 1, 0x2000),
+    };
+    struct ts_data_object duplicate[] = {
+        TS_GROUP(0x01, "Meas", TS_NO_CALLBACK, ID_ROOT),
+        TS_ITEM_FLOAT(0x40, "rValue", &value, 1, 0x01, TS_ANY_R, 0),
+        TS_ITEM_FLOAT(0x40, "rOther", &value, 1, 0x01, TS_ANY_R, 0),
+    };
+    struct ts_data_object missing_parent[] = {
+        TS_GROUP(0x01, "Meas", TS_NO_CALLBACK, ID_ROOT),
+        TS_ITEM_FLOAT(0x40, "rValue", &value, 1, 0x02, TS_ANY_R, 0),
+    };
+    struct ts_data_object misplaced_record_item[] = {
+        TS_RECORDS(0x2000, "Log", &records, ID_ROOT, TS_ANY_R, 0),
+        TS_RECORD_ITEM_FLOAT(0x81, "rValue", struct check_record, value, 1, 0x2000),
+        TS_GROUP(0x01, "Meas", TS_NO_CALLBACK, ID_ROOT),
+        TS_RECORD_ITEM_FLOAT(0x82, "rOther", struct check_record, other, 1, 0x2000),
+    };
+
+    TEST_ASSERT_EQUAL(0, ts_init(&ts_check, valid, ARRAY_SIZE(valid)));
+    TEST_ASSERT_EQUAL(0, ts_check_objects(&ts_check, &err));
+    TEST_ASSERT_EQUAL(0, err.code);
+
+    TEST_ASSERT_EQUAL(-EEXIST, ts_init(&ts_check, duplicate, ARRAY_SIZE(duplicate)));
+    TEST_ASSERT_EQUAL(-EEXIST, ts_check_objects(&ts_check, &err));
+    TEST_ASSERT_EQUAL(-EEXIST, err.code);
+    TEST_ASSERT_EQUAL_HEX(0x40, err.id);
+
+    TEST_ASSERT_EQUAL(-ENOENT, ts_init_indexed(&ts_check, missing_parent,
+                                               ARRAY_SIZE(missing_parent), index_buf,
+                                               ARRAY_SIZE(index_buf)));
+    TEST_ASSERT_EQUAL(-ENOENT, ts_check_objects(&ts_check, &err));
+    TEST_ASSERT_EQUAL_HEX(0x40, err.id);
+
+    TEST_ASSERT_EQUAL(-EINVAL,
+                      ts_init(&ts_check, misplaced_record_item, ARRAY_SIZE(misplaced_record_item)));
+    TEST_ASSERT_EQUAL(-EINVAL, ts_check_objects(&ts_check, &err));
+    TEST_ASSERT_EQUAL_HEX(0x82, err.id);
+
+    // entire test database
+    TEST_ASSERT_EQUAL(0, ts_init(&ts_check, &data_objects[0], data_objects_size));
+}
@@ -11,6 +11,7 @@
 struct ts_context ts;
 uint8_t req_buf[TS_REQ_BUFFER_LEN];
 uint8_t resp_buf[TS_RESP_BUFFER_LEN];
+uint16_t index_buf[TS_INDEX_BUFFER_LEN];
 
 bool group_callback_called;
 bool update_callback_called;
@@ -162,6 +162,10 @@ struct ts_data_object data_objects[] = {
 
     TS_ITEM_FLOAT(0x96, "r_A", &battery_current, 2, 0x94, TS_ANY_R, SUBSET_NESTED),
 
+    TS_GROUP(0x98, "Cell1", TS_NO_CALLBACK, 0x94),
+
+    TS_ITEM_FLOAT(0x99, "r_V", &battery_voltage, 2, 0x98, TS_ANY_R, SUBSET_NESTED),
+
     TS_ITEM_INT16(0x97, "rAmbient_degC", &ambient_temp, ID_NESTED, TS_ANY_R, SUBSET_NESTED),
 
     // RECORDED DATA //////////////////////////////////////////////////////////
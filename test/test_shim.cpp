@@ -11,4 +11,9 @@ void test_shim_get_object(void)
 
     ThingSetDataObject *object = ts.get_object(0x10); // timestamp object "t_s"
     TEST_ASSERT_EQUAL_PTR(&data_objects[0], object);
+
+    ThingSet ts_indexed(&data_objects[0], data_objects_size, index_buf, ARRAY_SIZE(index_buf));
+
+    object = ts_indexed.get_object(0x10);
+    TEST_ASSERT_EQUAL_PTR(&data_objects[0], object);
 }
@@ -4,7 +4,9 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <errno.h>
 #include <math.h>
+#include <string.h>
 
 #include "test.h"
 
@@ -128,6 +130,72 @@ void test_txt_patch_whitespaces(void)
     TEST_ASSERT_EQUAL_INT32(50, i32);
 }
 
+void test_txt_patch_number_range(void)
+{
+    TEST_ASSERT_TXT_REQ("=Conf {\"ui8\":255,\"i8\":-128,\"ui16\":65535,\"i16\":-32768}",
+                        ":84 Changed.");
+    TEST_ASSERT_TXT_REQ("?Conf [\"ui8\",\"i8\",\"ui16\",\"i16\"]",
+                        ":85 Content. [255,-128,65535,-32768]");
+
+    TEST_ASSERT_TXT_REQ("=Conf {\"ui32\":4294967295,\"i32\":-2147483648}", ":84 Changed.");
+    TEST_ASSERT_TXT_REQ("?Conf [\"ui32\",\"i32\"]", ":85 Content. [4294967295,-2147483648]");
+
+    // exponent, hex and truncated fraction
+    TEST_ASSERT_TXT_REQ("=Conf {\"ui8\":2.5e1,\"i8\":\"0x7F\",\"ui16\":-0.9,\"i16\":-12.9}",
+                        ":84 Changed.");
+    TEST_ASSERT_TXT_REQ("?Conf [\"ui8\",\"i8\",\"ui16\",\"i16\"]",
+                        ":85 Content. [25,127,0,-12]");
+
+    // out of range values must not be truncated
+    TEST_ASSERT_TXT_REQ("=Conf {\"ui8\":256}", ":AF Unsupported Content-Format.");
+    TEST_ASSERT_TXT_REQ("=Conf {\"i8\":-129}", ":AF Unsupported Content-Format.");
+    TEST_ASSERT_TXT_REQ("=Conf {\"ui16\":-1}", ":AF Unsupported Content-Format.");
+    TEST_ASSERT_TXT_REQ("=Conf {\"ui32\":4294967296}", ":AF Unsupported Content-Format.");
+    TEST_ASSERT_TXT_REQ("=Conf {\"i32\":2147483648}", ":AF Unsupported Content-Format.");
+    TEST_ASSERT_TXT_REQ("=Conf {\"i32\":1e10}", ":AF Unsupported Content-Format.");
+    TEST_ASSERT_TXT_REQ("=Conf {\"f32\":1e39}", ":AF Unsupported Content-Format.");
+
+    // invalid formats
+    TEST_ASSERT_TXT_REQ("=Conf {\"i32\":\"12abc\"}", ":AF Unsupported Content-Format.");
+    TEST_ASSERT_TXT_REQ("=Conf {\"f32\":\"1e\"}", ":AF Unsupported Content-Format.");
+    TEST_ASSERT_TXT_REQ("=Conf {\"f32\":\"-\"}", ":AF Unsupported Content-Format.");
+
+    // a failed request must not change any value
+    TEST_ASSERT_TXT_REQ("?Conf [\"ui8\",\"i8\",\"ui16\",\"i32\"]",
+                        ":85 Content. [25,127,0,-2147483648]");
+
+    // floats are rounded correctly
+    TEST_ASSERT_TXT_REQ("=Conf {\"f32\":0.1}", ":84 Changed.");
+    TEST_ASSERT_EQUAL_UINT32(0x3DCCCCCD, *(uint32_t *)&f32);
+    TEST_ASSERT_TXT_REQ("=Conf {\"f32\":-3.4028234e38}", ":84 Changed.");
+    TEST_ASSERT_EQUAL_FLOAT(-3.4028234e38F, f32);
+    TEST_ASSERT_TXT_REQ("=Conf {\"f32\":123456789012345678901234567890}", ":84 Changed.");
+    TEST_ASSERT_EQUAL_FLOAT(1.2345679e29F, f32);
+
+#if CONFIG_THINGSET_DECFRAC_TYPE_SUPPORT
+    // exact conversion to the decimal fraction mantissa (exponent -2)
+    TEST_ASSERT_TXT_REQ("=Conf {\"DecFrac_degC\":273.15}", ":84 Changed.");
+    TEST_ASSERT_TXT_REQ("?Conf \"DecFrac_degC\"", ":85 Content. 27315e-2");
+    TEST_ASSERT_TXT_REQ("=Conf {\"DecFrac_degC\":-1.005}", ":84 Changed.");
+    TEST_ASSERT_TXT_REQ("?Conf \"DecFrac_degC\"", ":85 Content. -101e-2");
+    TEST_ASSERT_TXT_REQ("=Conf {\"DecFrac_degC\":2.5e3}", ":84 Changed.");
+    TEST_ASSERT_TXT_REQ("?Conf \"DecFrac_degC\"", ":85 Content. 250000e-2");
+    TEST_ASSERT_TXT_REQ("=Conf {\"DecFrac_degC\":21474836.48}", ":AF Unsupported Content-Format.");
+#endif
+
+#if CONFIG_THINGSET_64BIT_TYPES_SUPPORT
+    TEST_ASSERT_TXT_REQ("=Conf {\"ui64\":18446744073709551615,\"i64\":-9223372036854775808}",
+                        ":84 Changed.");
+    TEST_ASSERT_TXT_REQ("?Conf [\"ui64\",\"i64\"]",
+                        ":85 Content. [18446744073709551615,-9223372036854775808]");
+    TEST_ASSERT_TXT_REQ("=Conf {\"ui64\":18446744073709551616}", ":AF Unsupported Content-Format.");
+    TEST_ASSERT_TXT_REQ("=Conf {\"i64\":9223372036854775808}", ":AF Unsupported Content-Format.");
+#endif
+
+    f32 = 52.8F;
+    i32 = 50;
+}
+
 #ifdef CONFIG_BASE64 /* Zephyr only */
 
 void test_txt_patch_bytes_buffer(void)
@@ -387,7 +455,7 @@ void test_txt_export(void)
     expected =
         "{\"Nested\":{"
         "\"Bat1\":{\"r_V\":14.10,\"r_A\":5.13},"
-        "\"Bat2\":{\"r_V\":14.10,\"r_A\":5.13},"
+        "\"Bat2\":{\"r_V\":14.10,\"r_A\":5.13,\"Cell1\":{\"r_V\":14.10}},"
         "\"rAmbient_degC\":22}"
         "}";
 
@@ -423,3 +491,184 @@ void test_txt_update_callback(void)
     TEST_ASSERT_TXT_REQ("=Conf {\"sBatCharging_V\":52}", ":84 Changed.");
     TEST_ASSERT_EQUAL(true, update_callback_called);
 }
+
+void test_txt_number_formatting(void)
+{
+    const float values[] = {
+        0.0F,  -0.0F,    0.5F,      1.5F,   2.5F,   0.125F,     -0.001F,   0.005F,      14.1F,
+        5.13F, -22.675F, 123.456F,  1e-6F,  1e-30F, 1.401e-45F, 65535.99F, 16777216.0F, 1e9F,
+        1073741823, 1073741824, -3e38F, NAN, INFINITY,
+    };
+    char expected[64];
+    char actual[64];
+
+    for (int i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        for (int digits = 0; digits <= 10; digits++) {
+            int len = snprintf(expected, sizeof(expected), "%.*f", digits, values[i]);
+            TEST_ASSERT_EQUAL(len, ts_txt_format_float(actual, sizeof(actual), values[i], digits));
+            TEST_ASSERT_EQUAL_STRING(expected, actual);
+        }
+    }
+
+    // pseudo-random values over a wide range of magnitudes
+    uint32_t rnd = 12345;
+    for (int i = 0; i < 10000; i++) {
+        rnd = rnd * 1103515245U + 12345U;
+        float value = (float)(int32_t)rnd / (float)(1U << (rnd % 31));
+        int digits = rnd % 7;
+        snprintf(expected, sizeof(expected), "%.*f", digits, value);
+        ts_txt_format_float(actual, sizeof(actual), value, digits);
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+    }
+
+    // truncation with snprintf semantics
+    TEST_ASSERT_EQUAL(6, ts_txt_format_float(actual, 4, -12.34F, 2));
+    TEST_ASSERT_EQUAL_STRING("-12", actual);
+    TEST_ASSERT_EQUAL(11, ts_txt_format_int(actual, 5, INT32_MIN));
+    TEST_ASSERT_EQUAL_STRING("-214", actual);
+    TEST_ASSERT_EQUAL(10, ts_txt_format_uint(actual, sizeof(actual), UINT32_MAX));
+    TEST_ASSERT_EQUAL_STRING("4294967295", actual);
+    TEST_ASSERT_EQUAL(1, ts_txt_format_int(actual, sizeof(actual), 0));
+    TEST_ASSERT_EQUAL_STRING("0", actual);
+}
+
+void test_txt_export_buffer_overflow(void)
+{
+#if CONFIG_THINGSET_NESTED_JSON
+    const uint16_t subsets = SUBSET_NESTED;
+#else
+    const uint16_t subsets = SUBSET_REPORT;
+#endif
+    char expected[200];
+    char buf[200];
+
+    int len = ts_txt_export(&ts, expected, sizeof(expected), subsets);
+    TEST_ASSERT_TRUE(len > 0);
+
+    // overflow must be detected exactly and nothing may be written behind the buffer
+    for (int size = 0; size <= len; size++) {
+        memset(buf, 'x', sizeof(buf));
+        TEST_ASSERT_EQUAL(0, ts_txt_export(&ts, buf, size, subsets));
+        TEST_ASSERT_EQUAL('x', buf[size]);
+    }
+
+    memset(buf, 'x', sizeof(buf));
+    TEST_ASSERT_EQUAL(len, ts_txt_export(&ts, buf, len + 1, subsets));
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+    TEST_ASSERT_EQUAL('x', buf[len + 1]);
+
+    // same for statements with path prefix
+    len = ts_txt_statement_by_path(&ts, expected, sizeof(expected), "mReport");
+    TEST_ASSERT_TRUE(len > 0);
+    for (int size = 0; size <= len; size++) {
+        TEST_ASSERT_EQUAL(0, ts_txt_statement_by_path(&ts, buf, size, "mReport"));
+    }
+    TEST_ASSERT_EQUAL(len, ts_txt_statement_by_path(&ts, buf, len + 1, "mReport"));
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+}
+
+void test_txt_json_reader(void)
+{
+    const char *json = " {\"a\" : [1, \"x\\\"y\", {}], \"b\":true} ";
+    const enum ts_json_type expected[] = {
+        TS_JSON_OBJECT,     TS_JSON_STRING,    TS_JSON_ARRAY,      TS_JSON_PRIMITIVE,
+        TS_JSON_STRING,     TS_JSON_OBJECT,    TS_JSON_OBJECT_END, TS_JSON_ARRAY_END,
+        TS_JSON_STRING,     TS_JSON_PRIMITIVE, TS_JSON_OBJECT_END, TS_JSON_END,
+    };
+    struct ts_json_reader r;
+    struct ts_json_token tok;
+
+    ts_json_reader_init(&r, json, strlen(json));
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        TEST_ASSERT_EQUAL(0, ts_json_next(&r, &tok));
+        TEST_ASSERT_EQUAL(expected[i], tok.type);
+        if (i == 4) {
+            TEST_ASSERT_EQUAL(4, tok.len);
+            TEST_ASSERT_EQUAL(0, memcmp("x\\\"y", tok.start, tok.len));
+        }
+    }
+
+    // invalid JSON is detected when the affected token is read
+    const char *invalid[] = { "[1,]", "{\"a\" 1}", "{1:2}", "[1}", "\"abc", "1 2", "{\"a\":}" };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        int err = 0;
+        ts_json_reader_init(&r, invalid[i], strlen(invalid[i]));
+        for (int j = 0; j < 10 && err == 0; j++) {
+            err = ts_json_next(&r, &tok);
+            if (err == 0 && tok.type == TS_JSON_END) {
+                break;
+            }
+        }
+        TEST_ASSERT_EQUAL_MESSAGE(-EINVAL, err, invalid[i]);
+    }
+
+    // the state does not depend on the size of the payload, only on the nesting depth
+    char deep[40];
+    memset(deep, '[', sizeof(deep));
+    ts_json_reader_init(&r, deep, sizeof(deep));
+    int err;
+    do {
+        err = ts_json_next(&r, &tok);
+    } while (err == 0);
+    TEST_ASSERT_EQUAL(-ENOMEM, err);
+}
+
+void test_txt_patch_many_values(void)
+{
+    // more name/value pairs than the previous fixed token limit of 50 tokens could hold
+    char req[TS_REQ_BUFFER_LEN];
+    int len = snprintf(req, sizeof(req), "=Conf {");
+    for (int i = 0; i < 30; i++) {
+        len += snprintf(req + len, sizeof(req) - len, "\"i32\":%d,", i);
+    }
+    len += snprintf(req + len, sizeof(req) - len, "\"f32\":1.5}");
+    TEST_ASSERT_TRUE(len < sizeof(req));
+
+    TEST_ASSERT_TXT_REQ(req, ":84 Changed.");
+    TEST_ASSERT_EQUAL(29, i32);
+    TEST_ASSERT_EQUAL_FLOAT(1.5F, f32);
+
+    // syntax errors anywhere in the payload must prevent any write
+    TEST_ASSERT_TXT_REQ("=Conf {\"i32\":1,\"f32\":2.5,}", ":A0 Bad Request.");
+    TEST_ASSERT_TXT_REQ("=Conf {\"i32\":1,\"f32\":2.5", ":A0 Bad Request.");
+    TEST_ASSERT_TXT_REQ("=Conf {\"i32\":1} 2", ":A0 Bad Request.");
+    TEST_ASSERT_EQUAL(29, i32);
+    TEST_ASSERT_EQUAL_FLOAT(1.5F, f32);
+
+    f32 = 52.8F;
+    i32 = 50;
+}
+
+void test_txt_patch_nested(void)
+{
+    group_callback_called = false;
+
+    TEST_ASSERT_TXT_REQ("= {\"Conf\":{\"i32\":5,\"f32\":1.5},\"_pub\":{"
+                        "\"mReport\":{\"wInterval_ms\":500},\"Info\":{\"wOnChange\":false}}}",
+                        ":84 Changed.");
+    TEST_ASSERT_EQUAL(5, i32);
+    TEST_ASSERT_EQUAL_FLOAT(1.5F, f32);
+    TEST_ASSERT_EQUAL_UINT16(500, pub_report_interval);
+    TEST_ASSERT_EQUAL(false, pub_info_enable);
+    TEST_ASSERT_EQUAL(true, group_callback_called);
+
+    TEST_ASSERT_TXT_REQ("=_pub {\"mReport\":{\"wInterval_ms\":2000},\"Info\":{}}", ":84 Changed.");
+    TEST_ASSERT_EQUAL_UINT16(2000, pub_report_interval);
+
+    // errors in any of the nested objects must prevent all writes
+    TEST_ASSERT_TXT_REQ("= {\"Conf\":{\"i32\":6},\"_pub\":{\"mReport\":{\"wEnabled\":true}}}",
+                        ":A4 Not Found.");
+    TEST_ASSERT_TXT_REQ("= {\"Conf\":{\"i32\":6},\"_pub\":{\"mReport\":{\"wInterval_ms\":70000}}}",
+                        ":AF Unsupported Content-Format.");
+    TEST_ASSERT_TXT_REQ("= {\"Conf\":{\"i32\":6},\"Test\":{\"i32_readonly\":52}}",
+                        ":A3 Forbidden.");
+    TEST_ASSERT_TXT_REQ("= {\"Conf\":{\"i32\":6,\"f32\":{\"x\":1}}}", ":A0 Bad Request.");
+    TEST_ASSERT_TXT_REQ("= {\"Conf\":{\"i32\":6},\"_pub\":{}", ":A0 Bad Request.");
+    TEST_ASSERT_TXT_REQ("= {\"Conf\":{}}", ":A0 Bad Request.");
+    TEST_ASSERT_EQUAL(5, i32);
+
+    f32 = 52.8F;
+    i32 = 50;
+    pub_report_interval = 1000;
+    pub_info_enable = true;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) The ThingSet Project Contributors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Generator for the lookup index of a static data objects array.
+ *
+ * The generator includes the C file with the data objects definition (created with the TS_ITEM_*
+ * macros), builds the index in the same way as ts_init_indexed and writes it into a header file,
+ * which can be used with ts_init_prebuilt. Invalid data objects (e.g. duplicate IDs) make the
+ * generator fail, so that the build is stopped.
+ *
+ * The generator has to be compiled for the host together with all .c files of the library in
+ * the src folder, using the same CONFIG_THINGSET_* settings as the firmware, as some settings
+ * change the layout of the data objects array or the index. The CMake function
+ * thingset_generate_index in ts_index_gen.cmake adds this as a build step (see
+ * docs/src/dev/usage.rst).
+ *
+ * Only the positions of the objects are stored in the index, so the addresses of variables and
+ * functions referenced by the data objects are irrelevant. That's why unresolved symbols can be
+ * ignored during linking.
+ *
+ * The generated header defines a struct ts_index named <array>_index.
+ */
+
+#if !defined(TS_INDEX_GEN_SOURCE) || !defined(TS_INDEX_GEN_ARRAY)
+#error "TS_INDEX_GEN_SOURCE and TS_INDEX_GEN_ARRAY have to be defined"
+#endif
+
+#include TS_INDEX_GEN_SOURCE
+
+#include <stdio.h>
+
+#include "thingset.h"
+
+#define NUM_OBJECTS (sizeof(TS_INDEX_GEN_ARRAY) / sizeof(TS_INDEX_GEN_ARRAY[0]))
+
+#define _STR(x) #x
+#define STR(x)  _STR(x)
+
+static uint16_t gen_index_buf[TS_INDEX_BUF_LEN(NUM_OBJECTS)];
+
+static void write_table(FILE *f, const char *name, const uint16_t *table, size_t len)
+{
+    fprintf(f, "static const uint16_t %s_index_%s[%zu] = {", STR(TS_INDEX_GEN_ARRAY), name, len);
+    for (size_t i = 0; i < len; i++) {
+        fprintf(f, "%s0x%04X,", (i % 8 == 0) ? "\n    " : " ", table[i]);
+    }
+    fprintf(f, "\n};\n\n");
+}
+
+int main(int argc, char *argv[])
+{
+    struct ts_context ts;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <output header file>\n", argv[0]);
+        return 1;
+    }
+
+    int err = ts_init_indexed(&ts, TS_INDEX_GEN_ARRAY, NUM_OBJECTS, gen_index_buf,
+                              sizeof(gen_index_buf) / sizeof(gen_index_buf[0]));
+    if (err != 0) {
+        fprintf(stderr, "Error: Invalid data objects in %s (%d)\n", TS_INDEX_GEN_SOURCE, err);
+        return 1;
+    }
+
+    FILE *f = fopen(argv[1], "w");
+    if (f == NULL) {
+        fprintf(stderr, "Error: Could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(f, "/* Generated by tools/ts_index_gen.c from %s, do not edit. */\n\n",
+            TS_INDEX_GEN_SOURCE);
+    fprintf(f, "#include \"thingset.h\"\n\n");
+    fprintf(f, "#if %s\n", CONFIG_THINGSET_ID_INDEX_HASH ? "!CONFIG_THINGSET_ID_INDEX_HASH"
+                                                         : "CONFIG_THINGSET_ID_INDEX_HASH");
+    fprintf(f, "#error \"Index was generated with different CONFIG_THINGSET_ID_INDEX_HASH\"\n");
+    fprintf(f, "#endif\n\n");
+
+    write_table(f, "ids", ts.index.ids, ts.index.ids_len);
+    write_table(f, "names", ts.index.names, ts.index.names_len);
+    write_table(f, "children", ts.index.children, ts.index.children_len);
+
+    fprintf(f, "static const struct ts_index %s_index = {\n", STR(TS_INDEX_GEN_ARRAY));
+    fprintf(f, "    %s_index_ids, %zu,\n", STR(TS_INDEX_GEN_ARRAY), ts.index.ids_len);
+    fprintf(f, "    %s_index_names, %zu,\n", STR(TS_INDEX_GEN_ARRAY), ts.index.names_len);
+    fprintf(f, "    %s_index_children, %zu,\n", STR(TS_INDEX_GEN_ARRAY), ts.index.children_len);
+    fprintf(f, "};\n");
+
+    fclose(f);
+
+    printf("Index for %zu data objects written to %s\n", NUM_OBJECTS, argv[1]);
+
+    return 0;
+}
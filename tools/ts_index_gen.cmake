@@ -0,0 +1,71 @@
+# Copyright (c) The ThingSet Project Contributors
+# SPDX-License-Identifier: Apache-2.0
+
+# Build step to generate the lookup index of a static data objects array (see ts_index_gen.c)
+#
+# thingset_generate_index(
+#     SOURCE <C file with the data objects array>
+#     ARRAY <name of the array>
+#     OUTPUT <generated header file>
+#     [DEFINES <CONFIG_THINGSET_*=value> ...]
+#     [INCLUDE_DIRS <dir> ...]
+# )
+#
+# The generator is compiled for the host with the compiler in THINGSET_HOST_CC (default: cc) and
+# run whenever the data objects change. Invalid data objects (e.g. duplicate IDs) make the build
+# fail. The OUTPUT file has to be listed in the sources of a target (or a target has to depend on
+# it) so that the command is run.
+#
+# The CONFIG_THINGSET_* settings have to be the same as for the firmware. In a Zephyr build, the
+# settings from Kconfig are passed automatically in addition to DEFINES.
+
+function(thingset_generate_index)
+    cmake_parse_arguments(GEN "" "SOURCE;ARRAY;OUTPUT" "DEFINES;INCLUDE_DIRS" ${ARGN})
+    if(NOT GEN_SOURCE OR NOT GEN_ARRAY OR NOT GEN_OUTPUT)
+        message(FATAL_ERROR "thingset_generate_index: SOURCE, ARRAY and OUTPUT are required")
+    endif()
+
+    if(NOT THINGSET_HOST_CC)
+        find_program(THINGSET_HOST_CC NAMES cc gcc clang REQUIRED)
+    endif()
+
+    # the function may be called from a different directory than the one including this file
+    get_filename_component(ts_base ${CMAKE_CURRENT_FUNCTION_LIST_DIR} DIRECTORY)
+    get_filename_component(source ${GEN_SOURCE} ABSOLUTE)
+    get_filename_component(output ${GEN_OUTPUT} ABSOLUTE BASE_DIR ${CMAKE_CURRENT_BINARY_DIR})
+    set(generator ${CMAKE_CURRENT_BINARY_DIR}/ts_index_gen_${GEN_ARRAY})
+
+    # settings from Kconfig, except the ones which only apply to the target
+    set(flags)
+    get_cmake_property(variables VARIABLES)
+    foreach(var ${variables})
+        if(var MATCHES "^CONFIG_THINGSET_" AND NOT var MATCHES
+           "^CONFIG_THINGSET_(ZEPHYR|ITERABLE_SECTIONS|IMMUTABLE_OBJECTS)$")
+            if("${${var}}" STREQUAL "y")
+                list(APPEND flags -D${var}=1)
+            else()
+                list(APPEND flags -D${var}=${${var}})
+            endif()
+        endif()
+    endforeach()
+    foreach(def ${GEN_DEFINES})
+        list(APPEND flags -D${def})
+    endforeach()
+    foreach(dir ${GEN_INCLUDE_DIRS})
+        list(APPEND flags -I${dir})
+    endforeach()
+
+    file(GLOB lib_sources ${ts_base}/src/*.c)
+
+    add_custom_command(
+        OUTPUT ${output}
+        COMMAND ${THINGSET_HOST_CC} -I${ts_base}/src ${flags}
+                "-DTS_INDEX_GEN_SOURCE=\"${source}\"" -DTS_INDEX_GEN_ARRAY=${GEN_ARRAY}
+                ${ts_base}/tools/ts_index_gen.c ${lib_sources}
+                -Wl,--unresolved-symbols=ignore-all -lm -o ${generator}
+        COMMAND ${generator} ${output}
+        DEPENDS ${source} ${ts_base}/tools/ts_index_gen.c ${lib_sources}
+        COMMENT "Generating ThingSet index ${GEN_OUTPUT}"
+        VERBATIM
+    )
+endfunction()
@@ -12,7 +12,12 @@
 
 void setup(void)
 {
+#ifdef CONFIG_THINGSET_TEST_ID_INDEX
+    (void)ts_init_indexed(&ts, &data_objects[0], data_objects_size, index_buf,
+                          ARRAY_SIZE(index_buf));
+#else
     (void)ts_init(&ts, &data_objects[0], data_objects_size);
+#endif
 }
 
 void teardown(void)
@@ -29,6 +34,25 @@ void test_main(void)
         /* data conversion tests */
         ztest_unit_test_setup_teardown(test_txt_patch_bin_fetch, setup, teardown),
         ztest_unit_test_setup_teardown(test_bin_patch_txt_fetch, setup, teardown),
+        /* data object lookup */
+        ztest_unit_test_setup_teardown(test_ts_init_indexed, setup, teardown),
+        ztest_unit_test_setup_teardown(test_ts_init_prebuilt, setup, teardown),
+        ztest_unit_test_setup_teardown(test_ts_get_next_child, setup, teardown),
+        ztest_unit_test_setup_teardown(test_ts_get_next_member, setup, teardown),
+#if CONFIG_THINGSET_PATH_CACHE_SIZE > 0
+        ztest_unit_test_setup_teardown(test_ts_path_cache, setup, teardown),
+#endif
+        ztest_unit_test_setup_teardown(test_ts_process_chunked, setup, teardown),
+        ztest_unit_test_setup_teardown(test_ts_process_batch, setup, teardown),
+        ztest_unit_test_setup_teardown(test_ts_request_id, setup, teardown),
+        ztest_unit_test_setup_teardown(test_ts_pipeline, setup, teardown),
+        ztest_unit_test_setup_teardown(test_ts_init_shared, setup, teardown),
+#if CONFIG_THINGSET_SEQLOCK
+        ztest_unit_test_setup_teardown(test_ts_seqlock, setup, teardown),
+#endif
+        ztest_unit_test_setup_teardown(test_ts_capture, setup, teardown),
+        ztest_unit_test_setup_teardown(test_ts_delta_statement, setup, teardown),
+        ztest_unit_test_setup_teardown(test_ts_check_objects, setup, teardown),
 
         /* Text mode: GET request */
         ztest_unit_test_setup_teardown(test_txt_get_root, setup, teardown),
@@ -49,6 +73,9 @@ void test_main(void)
         /* Text mode: PATCH request */
         ztest_unit_test_setup_teardown(test_txt_patch_wrong_data_structure, setup, teardown),
         ztest_unit_test_setup_teardown(test_txt_patch_whitespaces, setup, teardown),
+        ztest_unit_test_setup_teardown(test_txt_patch_number_range, setup, teardown),
+        ztest_unit_test_setup_teardown(test_txt_patch_many_values, setup, teardown),
+        ztest_unit_test_setup_teardown(test_txt_patch_nested, setup, teardown),
         ztest_unit_test_setup_teardown(test_txt_patch_bytes_buffer, setup, teardown),
         ztest_unit_test_setup_teardown(test_txt_patch_readonly, setup, teardown),
         ztest_unit_test_setup_teardown(test_txt_patch_wrong_path, setup, teardown),
@@ -74,8 +101,12 @@ void test_main(void)
         ztest_unit_test_setup_teardown(test_txt_get_endpoint, setup, teardown),
         /* Text mode: exporting of data */
         ztest_unit_test_setup_teardown(test_txt_export, setup, teardown),
+        ztest_unit_test_setup_teardown(test_txt_export_buffer_overflow, setup, teardown),
         /* Text mode: update notification */
         ztest_unit_test_setup_teardown(test_txt_update_callback, setup, teardown),
+        /* Text mode: number formatting and JSON parsing */
+        ztest_unit_test_setup_teardown(test_txt_number_formatting, setup, teardown),
+        ztest_unit_test_setup_teardown(test_txt_json_reader, setup, teardown),
 
         /* Bin mode: GET request */
         ztest_unit_test_setup_teardown(test_bin_get_meas_ids_values, setup, teardown),
@@ -85,6 +116,7 @@ void test_main(void)
         ztest_unit_test_setup_teardown(test_bin_patch_multiple_objects, setup, teardown),
         ztest_unit_test_setup_teardown(test_bin_patch_float_array, setup, teardown),
         ztest_unit_test_setup_teardown(test_bin_patch_rounded_float, setup, teardown),
+        ztest_unit_test_setup_teardown(test_bin_patch_stream, setup, teardown),
         /* Text mode: FETCH request */
         ztest_unit_test_setup_teardown(test_bin_fetch_meas_ids, setup, teardown),
         ztest_unit_test_setup_teardown(test_bin_fetch_meas_names, setup, teardown),
@@ -101,9 +133,19 @@ void test_main(void)
         ztest_unit_test_setup_teardown(test_bin_statement_subset, setup, teardown),
         ztest_unit_test_setup_teardown(test_bin_statement_group, setup, teardown),
         ztest_unit_test_setup_teardown(test_bin_pub_can, setup, teardown),
+        ztest_unit_test_setup_teardown(test_bin_pub_can_packed, setup, teardown),
+        ztest_unit_test_setup_teardown(test_bin_can_sched, setup, teardown),
+#if CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT
+        ztest_unit_test_setup_teardown(test_bin_process_iov, setup, teardown),
+#endif
         /* Bin mode: general tests */
         ztest_unit_test_setup_teardown(test_bin_num_elem, setup, teardown),
         ztest_unit_test_setup_teardown(test_bin_serialize_long_string, setup, teardown),
+        ztest_unit_test_setup_teardown(test_bin_serialize_container, setup, teardown),
+        ztest_unit_test_setup_teardown(test_bin_array_elements, setup, teardown),
+#if CONFIG_THINGSET_CBOR_TYPED_ARRAYS
+        ztest_unit_test_setup_teardown(test_bin_patch_typed_array, setup, teardown),
+#endif
 #ifdef CONFIG_THINGSET_BYTE_STRING_TYPE_SUPPORT
         /* Bin mode: binary (bytes) data type */
         ztest_unit_test_setup_teardown(test_bin_serialize_bytes, setup, teardown),